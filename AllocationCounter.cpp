@@ -0,0 +1,222 @@
+#include "AllocationCounter.h"
+#include "Tracer.h"
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(PULSE_ALLOCATION_COUNTING) && defined(__GLIBC__)
+#define PULSE_COUNT_ALLOCATIONS 1
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+}
+#endif
+
+namespace Pulse {
+
+namespace {
+
+// Slot 0 collects allocations outside any scope
+constexpr int kMaxSubsystems = 32;
+
+struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<quint64> count{0};
+    quint64 lastFrame = 0;      // GUI thread only
+    quint64 frameDelta = 0;     // GUI thread only
+};
+
+Slot s_slots[kMaxSubsystems];
+
+// Constant-initialized, so safe to touch from inside malloc
+thread_local int t_slot = 0;
+
+// GUI thread only
+quint64 s_frames = 0;
+quint64 s_quietFrames = 0;
+quint64 s_lastFrameTotal = 0;
+
+[[maybe_unused]] inline void countAllocation() {
+    s_slots[t_slot].count.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+bool AllocationCounter::available() {
+#ifdef PULSE_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+quint64 AllocationCounter::total() {
+    quint64 sum = 0;
+    for (const Slot& slot : s_slots) {
+        sum += slot.count.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+int AllocationCounter::slotFor(const char* subsystem) {
+    // Literals of the same name may live at different addresses per library
+    for (int i = 1; i < kMaxSubsystems; ++i) {
+        const char* current = s_slots[i].name.load(std::memory_order_acquire);
+        if (!current) {
+            if (s_slots[i].name.compare_exchange_strong(current, subsystem, std::memory_order_acq_rel)) {
+                return i;
+            }
+        }
+        if (current == subsystem || std::strcmp(current, subsystem) == 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+int AllocationCounter::enter(int slot) {
+    const int previous = t_slot;
+    t_slot = slot;
+    return previous;
+}
+
+quint64 AllocationCounter::frameEnd() {
+    if (!available()) return 0;
+    
+    quint64 frameTotal = 0;
+    for (int i = 0; i < kMaxSubsystems; ++i) {
+        Slot& slot = s_slots[i];
+        const quint64 count = slot.count.load(std::memory_order_relaxed);
+        slot.frameDelta = count - slot.lastFrame;
+        slot.lastFrame = count;
+        frameTotal += slot.frameDelta;
+    }
+    
+    s_frames++;
+    s_lastFrameTotal = frameTotal;
+    if (frameTotal == 0) {
+        s_quietFrames++;
+    }
+    
+    PULSE_TRACE_COUNTER("alloc", "frame", qint64(frameTotal));
+    if (Tracer::enabled()) {
+        for (int i = 0; i < kMaxSubsystems; ++i) {
+            const char* name = i == 0 ? "other" : s_slots[i].name.load(std::memory_order_acquire);
+            if (name && s_slots[i].frameDelta) {
+                Tracer::counter("alloc", name, qint64(s_slots[i].frameDelta));
+            }
+        }
+    }
+    
+    // Recording the counters may have allocated
+    rebase();
+    return frameTotal;
+}
+
+quint64 AllocationCounter::lastFrame() {
+    return s_lastFrameTotal;
+}
+
+void AllocationCounter::rebase() {
+    if (!available()) return;
+    
+    for (Slot& slot : s_slots) {
+        slot.lastFrame = slot.count.load(std::memory_order_relaxed);
+    }
+}
+
+QString AllocationCounter::report() {
+    if (!available()) {
+        return QStringLiteral("Allocation counting not compiled in (PULSE_ALLOCATION_COUNTING)");
+    }
+    
+    struct Row {
+        const char* name;
+        quint64 count;
+    };
+    std::vector<Row> rows;
+    for (int i = 0; i < kMaxSubsystems; ++i) {
+        const char* name = i == 0 ? "other" : s_slots[i].name.load(std::memory_order_acquire);
+        const quint64 count = s_slots[i].count.load(std::memory_order_relaxed);
+        if (name && count) {
+            rows.push_back({name, count});
+        }
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.count > b.count; });
+    
+    QStringList subsystems;
+    for (size_t i = 0; i < rows.size() && i < 5; ++i) {
+        subsystems << QStringLiteral("%1 %2").arg(QLatin1String(rows[i].name)).arg(rows[i].count);
+    }
+    return QStringLiteral("%1 frames, %2 without heap allocations, last frame %3; totals: %4")
+        .arg(s_frames).arg(s_quietFrames).arg(s_lastFrameTotal).arg(subsystems.join(", "));
+}
+
+} // namespace Pulse
+
+#ifdef PULSE_COUNT_ALLOCATIONS
+
+// Interposed over glibc for the whole process, shared libraries included.
+// operator new ends up here as well, the aligned overloads through
+// aligned_alloc or posix_memalign.
+extern "C" {
+
+void* malloc(size_t size) {
+    Pulse::countAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    Pulse::countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    Pulse::countAllocation();
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    Pulse::countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    Pulse::countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size) {
+    Pulse::countAllocation();
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* result = __libc_memalign(alignment, size);
+    if (!result && size) {
+        return ENOMEM;
+    }
+    *pointer = result;
+    return 0;
+}
+
+void* valloc(size_t size) {
+    Pulse::countAllocation();
+    return __libc_valloc(size);
+}
+
+void* pvalloc(size_t size) {
+    Pulse::countAllocation();
+    return __libc_pvalloc(size);
+}
+
+} // extern "C"
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+namespace Pulse {
+
+// Heap allocation counts per frame and per subsystem, for diagnostics
+// builds (PULSE_ALLOCATION_COUNTING, glibc only). malloc, calloc, realloc
+// and the aligned allocators (memalign, aligned_alloc, posix_memalign,
+// valloc, pvalloc) are interposed process-wide, so Qt containers and
+// every operator new are counted alike. mmap and allocators that bypass
+// glibc malloc are not. Each allocation is charged to the subsystem of the
+// innermost PULSE_TRACE_SCOPE on its thread, or to "other".
+//
+// In regular builds nothing is interposed and every call is a no-op.
+class AllocationCounter {
+public:
+    // Whether counting is compiled in
+    static bool available();
+    
+    // Allocations since startup, all threads
+    static quint64 total();
+    
+    // Slot for a subsystem name; looked up once per call site
+    static int slotFor(const char* subsystem);
+    
+    // Current subsystem of this thread; returns the previous one
+    static int enter(int slot);
+    
+    // Call once per frame on the GUI thread: publishes per-subsystem
+    // deltas as trace counters and returns the frame's allocations
+    static quint64 frameEnd();
+    
+    // Allocations of the frame last passed to frameEnd()
+    static quint64 lastFrame();
+    
+    // Leaves allocations made since frameEnd() out of the next frame; for
+    // diagnostics output and test drivers, not compositor work
+    static void rebase();
+    
+    // Frames seen, frames without allocations, and the busiest subsystems
+    static QString report();
+};
+
+class AllocationScope {
+public:
+    explicit AllocationScope(int slot)
+        : m_previous(AllocationCounter::enter(slot)) {
+    }
+    
+    ~AllocationScope() {
+        AllocationCounter::enter(m_previous);
+    }
+    
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+    
+private:
+    int m_previous;
+};
+
+} // namespace Pulse
+
+#define PULSE_ALLOCATION_CONCAT_(a, b) a##b
+#define PULSE_ALLOCATION_CONCAT(a, b) PULSE_ALLOCATION_CONCAT_(a, b)
+
+#ifdef PULSE_ALLOCATION_COUNTING
+#define PULSE_ALLOCATION_SCOPE(subsystem) \
+    static const int PULSE_ALLOCATION_CONCAT(pulseAllocationSlot_, __LINE__) = \
+        ::Pulse::AllocationCounter::slotFor(subsystem); \
+    ::Pulse::AllocationScope PULSE_ALLOCATION_CONCAT(pulseAllocationScope_, __LINE__)( \
+        PULSE_ALLOCATION_CONCAT(pulseAllocationSlot_, __LINE__))
+#else
+#define PULSE_ALLOCATION_SCOPE(subsystem) \
+    do { } while (0)
+#endif
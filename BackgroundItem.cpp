@@ -0,0 +1,280 @@
+#include "BackgroundItem.h"
+#include "Tracer.h"
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QQuickWindow>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGImageNode>
+#include <QSGVertexColorMaterial>
+#include <QtConcurrent>
+#include <QDebug>
+#include <cmath>
+
+namespace Pulse {
+
+namespace {
+
+// Keeps the child nodes addressable without walking the tree
+class BackgroundNode : public QSGNode {
+public:
+    QSGGeometryNode* fill = nullptr;
+    QSGGeometryNode* grid = nullptr;
+    QSGImageNode* wallpaper = nullptr;
+};
+
+void setVertex(QSGGeometry::ColoredPoint2D& vertex, float x, float y, const QColor& color) {
+    const QRgb rgb = qPremultiply(color.rgba());
+    vertex.set(x, y, qRed(rgb), qGreen(rgb), qBlue(rgb), qAlpha(rgb));
+}
+
+QImage decode(const QString& path, const QSize& target) {
+    PULSE_TRACE_SCOPE("background", "decode");
+    
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    
+    // Let the decoder downscale (JPEG does this almost for free) instead of
+    // decoding at full resolution and scaling afterwards
+    const QSize original = reader.size();
+    if (original.isValid()) {
+        reader.setScaledSize(original.scaled(target, Qt::KeepAspectRatioByExpanding));
+    }
+    
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qWarning() << "Failed to decode wallpaper" << path << reader.errorString();
+        return image;
+    }
+    if (image.width() < target.width() || image.height() < target.height()) {
+        image = image.scaled(target, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+    }
+    
+    // Cover: center crop to the target size
+    const QRect crop(QPoint((image.width() - target.width()) / 2, (image.height() - target.height()) / 2),
+                     target);
+    return image.copy(crop).convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+}
+
+} // namespace
+
+BackgroundItem::BackgroundItem(QQuickItem* parent)
+    : QQuickItem(parent) {
+    setFlag(ItemHasContents, true);
+    
+    // Decode once a resize has settled, not on every step of it
+    m_decodeTimer.setSingleShot(true);
+    m_decodeTimer.setInterval(100);
+    connect(&m_decodeTimer, &QTimer::timeout, this, &BackgroundItem::decodeWallpaper);
+}
+
+BackgroundItem::~BackgroundItem() {
+}
+
+void BackgroundItem::setColor(const QColor& color) {
+    if (m_color != color) {
+        m_color = color;
+        m_geometryDirty = true;
+        emit colorChanged(color);
+        update();
+    }
+}
+
+void BackgroundItem::setGradientColor(const QColor& color) {
+    if (m_gradientColor != color) {
+        m_gradientColor = color;
+        m_geometryDirty = true;
+        emit gradientColorChanged(color);
+        update();
+    }
+}
+
+void BackgroundItem::setGridColor(const QColor& color) {
+    if (m_gridColor != color) {
+        m_gridColor = color;
+        m_geometryDirty = true;
+        emit gridColorChanged(color);
+        update();
+    }
+}
+
+void BackgroundItem::setGridSpacing(int spacing) {
+    if (m_gridSpacing != spacing) {
+        m_gridSpacing = spacing;
+        m_geometryDirty = true;
+        emit gridSpacingChanged(spacing);
+        update();
+    }
+}
+
+void BackgroundItem::setSource(const QUrl& source) {
+    if (m_source == source) return;
+    
+    m_source = source;
+    m_wallpaper = QImage();
+    m_wallpaperSize = QSize();
+    m_showWallpaper = false;
+    emit sourceChanged(source);
+    
+    decodeWallpaper();
+    update();
+}
+
+void BackgroundItem::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        m_geometryDirty = true;
+        if (!m_source.isEmpty()) {
+            m_decodeTimer.start();
+        }
+        update();
+    }
+}
+
+void BackgroundItem::decodeWallpaper() {
+    const quint64 generation = ++m_decodeGeneration;
+    if (m_source.isEmpty() || width() <= 0 || height() <= 0) return;
+    
+    const qreal dpr = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+    const QSize target = (size() * dpr).toSize();
+    if (m_showWallpaper && target == m_wallpaperSize && (m_wallpaperUploaded || !m_wallpaper.isNull())) {
+        return;
+    }
+    
+    const QString path = m_source.scheme() == "qrc" ? ":" + m_source.path()
+        : m_source.isLocalFile() ? m_source.toLocalFile() : m_source.toString();
+    
+    auto* watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, generation, target]() {
+        watcher->deleteLater();
+        
+        // A newer source or size superseded this decode
+        if (generation != m_decodeGeneration) return;
+        
+        const QImage image = watcher->result();
+        if (image.isNull()) return;
+        
+        m_wallpaper = image;
+        m_wallpaperSize = target;
+        m_showWallpaper = true;
+        update();
+    });
+    
+    watcher->setFuture(QtConcurrent::run(decode, path, target));
+}
+
+QSGNode* BackgroundItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) {
+    Q_UNUSED(data)
+    PULSE_TRACE_SCOPE("render", "background");
+    
+    auto* node = static_cast<BackgroundNode*>(oldNode);
+    if (!node) {
+        node = new BackgroundNode;
+        m_geometryDirty = true;
+        
+        // The uploaded texture went away with the previous scene graph
+        if (m_wallpaperUploaded && m_wallpaper.isNull()) {
+            m_wallpaperUploaded = false;
+            QMetaObject::invokeMethod(this, &BackgroundItem::decodeWallpaper, Qt::QueuedConnection);
+        }
+    }
+    
+    // A new wallpaper replaces the old node, which deletes its texture
+    if (node->wallpaper && (!m_showWallpaper || !m_wallpaper.isNull())) {
+        delete node->wallpaper;
+        node->wallpaper = nullptr;
+        m_wallpaperUploaded = false;
+    }
+    
+    // Upload once, then drop the CPU copy
+    if (!m_wallpaper.isNull()) {
+        node->wallpaper = window()->createImageNode();
+        node->wallpaper->setTexture(window()->createTextureFromImage(m_wallpaper));
+        node->wallpaper->setOwnsTexture(true);
+        node->wallpaper->setFiltering(QSGTexture::Linear);
+        node->appendChildNode(node->wallpaper);
+        m_wallpaper = QImage();
+        m_wallpaperUploaded = true;
+    }
+    
+    if (node->wallpaper) {
+        delete node->fill;
+        delete node->grid;
+        node->fill = nullptr;
+        node->grid = nullptr;
+        
+        // Stretched until a resize has settled and the new size is decoded
+        node->wallpaper->setRect(boundingRect());
+        return node;
+    }
+    
+    if (!node->fill) {
+        auto* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 4);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangleStrip);
+        node->fill = new QSGGeometryNode;
+        node->fill->setGeometry(geometry);
+        node->fill->setFlag(QSGNode::OwnsGeometry);
+        node->fill->setMaterial(new QSGVertexColorMaterial);
+        node->fill->setFlag(QSGNode::OwnsMaterial);
+        node->prependChildNode(node->fill);
+        m_geometryDirty = true;
+    }
+    
+    if (!m_geometryDirty) {
+        return node;
+    }
+    m_geometryDirty = false;
+    
+    const float w = width();
+    const float h = height();
+    const QColor bottom = m_gradientColor.isValid() ? m_gradientColor : m_color;
+    QSGGeometry::ColoredPoint2D* corners = node->fill->geometry()->vertexDataAsColoredPoint2D();
+    setVertex(corners[0], 0, 0, m_color);
+    setVertex(corners[1], w, 0, m_color);
+    setVertex(corners[2], 0, h, bottom);
+    setVertex(corners[3], w, h, bottom);
+    node->fill->markDirty(QSGNode::DirtyGeometry);
+    
+    if (m_gridColor.alpha() == 0 || m_gridSpacing <= 0) {
+        delete node->grid;
+        node->grid = nullptr;
+        return node;
+    }
+    
+    // All grid lines in one draw call
+    const int columns = int(std::ceil(w / m_gridSpacing));
+    const int rows = int(std::ceil(h / m_gridSpacing));
+    if (!node->grid) {
+        auto* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawLines);
+        geometry->setLineWidth(1);
+        node->grid = new QSGGeometryNode;
+        node->grid->setGeometry(geometry);
+        node->grid->setFlag(QSGNode::OwnsGeometry);
+        node->grid->setMaterial(new QSGFlatColorMaterial);
+        node->grid->setFlag(QSGNode::OwnsMaterial);
+        node->appendChildNode(node->grid);
+    }
+    
+    QSGGeometry* geometry = node->grid->geometry();
+    geometry->allocate(2 * (columns + rows));
+    QSGGeometry::Point2D* points = geometry->vertexDataAsPoint2D();
+    
+    // Half-pixel offset keeps 1px lines on a single pixel row
+    for (int i = 0; i < columns; ++i) {
+        const float x = i * m_gridSpacing + 0.5f;
+        (points++)->set(x, 0);
+        (points++)->set(x, h);
+    }
+    for (int i = 0; i < rows; ++i) {
+        const float y = i * m_gridSpacing + 0.5f;
+        (points++)->set(0, y);
+        (points++)->set(w, y);
+    }
+    
+    static_cast<QSGFlatColorMaterial*>(node->grid->material())->setColor(m_gridColor);
+    node->grid->markDirty(QSGNode::DirtyGeometry | QSGNode::DirtyMaterial);
+    return node;
+}
+
+} // namespace Pulse
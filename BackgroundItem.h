@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QQuickItem>
+#include <QColor>
+#include <QImage>
+#include <QTimer>
+#include <QUrl>
+#include <QtQml/qqmlregistration.h>
+
+namespace Pulse {
+
+// Desktop background drawn by the scene graph: a solid or gradient fill,
+// a line grid, or a wallpaper decoded on a worker thread and uploaded once
+class BackgroundItem : public QQuickItem {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(QColor gradientColor READ gradientColor WRITE setGradientColor NOTIFY gradientColorChanged)
+    Q_PROPERTY(QColor gridColor READ gridColor WRITE setGridColor NOTIFY gridColorChanged)
+    Q_PROPERTY(int gridSpacing READ gridSpacing WRITE setGridSpacing NOTIFY gridSpacingChanged)
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+    
+public:
+    explicit BackgroundItem(QQuickItem* parent = nullptr);
+    ~BackgroundItem();
+    
+    QColor color() const { return m_color; }
+    void setColor(const QColor& color);
+    
+    // Bottom color of a vertical gradient; invalid for a solid fill
+    QColor gradientColor() const { return m_gradientColor; }
+    void setGradientColor(const QColor& color);
+    
+    // Transparent disables the grid
+    QColor gridColor() const { return m_gridColor; }
+    void setGridColor(const QColor& color);
+    int gridSpacing() const { return m_gridSpacing; }
+    void setGridSpacing(int spacing);
+    
+    // Local file; scaled to cover the item, replaces fill and grid once loaded
+    QUrl source() const { return m_source; }
+    void setSource(const QUrl& source);
+    
+signals:
+    void colorChanged(const QColor& color);
+    void gradientColorChanged(const QColor& color);
+    void gridColorChanged(const QColor& color);
+    void gridSpacingChanged(int spacing);
+    void sourceChanged(const QUrl& source);
+    
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+    
+private slots:
+    void decodeWallpaper();
+    
+private:
+    QColor m_color = QColor("#1a1a1a");
+    QColor m_gradientColor;
+    QColor m_gridColor = QColor("#333333");
+    int m_gridSpacing = 50;
+    QUrl m_source;
+    
+    // Decoded pixels waiting for upload; dropped once they are a texture
+    QImage m_wallpaper;
+    QSize m_wallpaperSize;
+    bool m_showWallpaper = false;
+    bool m_wallpaperUploaded = false;
+    quint64 m_decodeGeneration = 0;
+    QTimer m_decodeTimer;
+    
+    // Fill and grid geometry only change with size, colors or spacing
+    bool m_geometryDirty = true;
+};
+
+} // namespace Pulse
@@ -0,0 +1,312 @@
+#include "ClientMemoryTracker.h"
+#include "EventBus.h"
+#include "ThumbnailCache.h"
+#include "Tracer.h"
+#include "WindowManager.h"
+#include <QDBusConnection>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QWaylandBufferRef>
+#include <QWaylandClient>
+#include <QDebug>
+#include <algorithm>
+
+namespace Pulse {
+
+namespace {
+
+// Evict down to this fraction of the budget so one commit over the line
+// does not trigger another pass right away
+constexpr int kEvictTargetPercent = 90;
+
+double toMiB(qint64 bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+ClientMemoryTracker::ClientMemoryTracker(WindowManager* windowManager, ThumbnailCache* thumbnails,
+                                         QObject* parent)
+    : QObject(parent)
+    , m_windowManager(windowManager)
+    , m_thumbnails(thumbnails) {
+    
+    EventBus* bus = EventBus::instance();
+    bus->subscribe<WindowAdded, &ClientMemoryTracker::onWindowAdded>(this);
+    bus->subscribe<WindowRemoved, &ClientMemoryTracker::onWindowRemoved>(this);
+    connect(m_windowManager, &WindowManager::currentWorkspaceChanged,
+            this, &ClientMemoryTracker::accountAll);
+    
+    m_enforceTimer.setSingleShot(true);
+    m_enforceTimer.setInterval(0);
+    connect(&m_enforceTimer, &QTimer::timeout, this, &ClientMemoryTracker::enforceBudget);
+    
+    m_statsTimer.setSingleShot(true);
+    m_statsTimer.setInterval(1000);
+    connect(&m_statsTimer, &QTimer::timeout, this, &ClientMemoryTracker::statsChanged);
+}
+
+ClientMemoryTracker::~ClientMemoryTracker() {
+}
+
+void ClientMemoryTracker::setBudget(qint64 bytes) {
+    if (m_budget == bytes) return;
+    m_budget = bytes;
+    emit statsChanged();
+    m_enforceTimer.start();
+}
+
+void ClientMemoryTracker::setClientQuota(qint64 bytes) {
+    if (m_clientQuota == bytes) return;
+    m_clientQuota = bytes;
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        checkQuota(it.value());
+    }
+    emit statsChanged();
+}
+
+void ClientMemoryTracker::onWindowAdded(const WindowAdded& event) {
+    // The client may have destroyed the surface before this was delivered
+    Window* window = event.window;
+    QWaylandSurface* surface = window->surface();
+    if (!surface) return;
+    
+    WindowEntry& entry = m_windows[window];
+    entry.client = surface->client();
+    ClientUsage& client = m_clients[entry.client];
+    client.pid = entry.client ? entry.client->processId() : 0;
+    client.windows++;
+    
+    // Connected after Window's own handler, so the view already holds the
+    // buffer of this commit
+    connect(surface, &QWaylandSurface::redraw, this, [this, window]() {
+        account(window);
+    });
+    connect(window, &Window::stateChanged, this, [this, window]() {
+        account(window);
+    });
+    connect(window, &Window::workspaceChanged, this, [this, window]() {
+        account(window);
+    });
+    
+    account(window);
+}
+
+void ClientMemoryTracker::onWindowRemoved(const WindowRemoved& event) {
+    Window* window = event.window;
+    auto it = m_windows.find(window);
+    if (it == m_windows.end()) return;
+    
+    apply(it.value(), Usage());
+    
+    auto client = m_clients.find(it->client);
+    if (client != m_clients.end() && --client->windows <= 0) {
+        m_clients.erase(client);
+    }
+    
+    // Null once the surface is gone, its connections with it
+    if (QWaylandSurface* surface = window->surface()) {
+        disconnect(surface, nullptr, this, nullptr);
+    }
+    disconnect(window, nullptr, this, nullptr);
+    m_windows.erase(it);
+    
+    if (!m_statsTimer.isActive()) {
+        m_statsTimer.start();
+    }
+}
+
+void ClientMemoryTracker::accountAll() {
+    // account() updates entries in place; the key set does not change
+    for (auto it = m_windows.keyBegin(); it != m_windows.keyEnd(); ++it) {
+        account(*it);
+    }
+}
+
+void ClientMemoryTracker::account(Window* window) {
+    auto it = m_windows.find(window);
+    if (it == m_windows.end()) return;
+    
+    Usage usage;
+    const QWaylandBufferRef buffer = window->currentBuffer();
+    if (buffer.hasBuffer()) {
+        const QSize size = buffer.size();
+        const qint64 pixelBytes = qint64(size.width()) * size.height() * 4;
+        usage.bufferBytes = buffer.isSharedMemory() ? buffer.image().sizeInBytes() : pixelBytes;
+        
+        // A shown buffer is uploaded to (shm) or imported as (dmabuf) a
+        // texture; count its full size either way
+        const bool shown = window->state() != Window::State::Minimized &&
+                           window->workspace() == m_windowManager->currentWorkspace();
+        if (shown) {
+            usage.textureBytes = pixelBytes;
+        }
+    }
+    usage.textureBytes += m_thumbnails->bytesForWindow(window->id());
+    usage.nodes = window->sceneNodes();
+    
+    apply(it.value(), usage);
+    
+    if (m_totalBytes > m_budget && !m_enforceTimer.isActive()) {
+        m_enforceTimer.start();
+    }
+    if (!m_statsTimer.isActive()) {
+        m_statsTimer.start();
+    }
+}
+
+void ClientMemoryTracker::apply(WindowEntry& entry, const Usage& usage) {
+    const Usage old = entry.usage;
+    entry.usage = usage;
+    m_totalBytes += usage.total() - old.total();
+    
+    auto it = m_clients.find(entry.client);
+    if (it == m_clients.end()) return;
+    
+    Usage& client = it->usage;
+    client.bufferBytes += usage.bufferBytes - old.bufferBytes;
+    client.textureBytes += usage.textureBytes - old.textureBytes;
+    client.nodes += usage.nodes - old.nodes;
+    checkQuota(it.value());
+}
+
+void ClientMemoryTracker::checkQuota(ClientUsage& usage) {
+    const bool over = usage.usage.total() > m_clientQuota;
+    if (over == usage.overQuota) return;
+    
+    // Warn once per crossing, not on every commit while over
+    usage.overQuota = over;
+    if (over) {
+        qWarning() << "Client" << usage.pid << "is using"
+                   << QString::number(toMiB(usage.usage.total()), 'f', 1) << "MiB of buffers, over its"
+                   << QString::number(toMiB(m_clientQuota), 'f', 1) << "MiB quota";
+        emit quotaExceeded(usage.pid, usage.usage.total());
+    }
+}
+
+FrameArena::Vector<Window*> ClientMemoryTracker::evictionOrder() const {
+    // Scratch lists live in the frame arena; the pass runs to completion
+    // before the frame ends
+    FrameArena* arena = FrameArena::instance();
+    FrameArena::Vector<Window*> minimized = arena->vector<Window*>(m_windows.size());
+    FrameArena::Vector<Window*> hidden = arena->vector<Window*>();
+    
+    auto holdsBuffer = [this](Window* window) {
+        auto it = m_windows.constFind(window);
+        return it != m_windows.cend() && !window->bufferReleased() && it->usage.bufferBytes > 0;
+    };
+    
+    // Candidates come from the store's flag and workspace columns; only
+    // those are looked up as Window objects
+    const WindowStore& store = m_windowManager->store();
+    const std::vector<quint32>& ids = store.ids();
+    const std::vector<quint8>& flags = store.flagColumn();
+    const std::vector<int>& workspaces = store.workspaces();
+    const int current = m_windowManager->currentWorkspace();
+    
+    for (int i = 0; i < store.size(); ++i) {
+        const bool isMinimized = flags[i] & WindowStore::Minimized;
+        if (workspaces[i] < 0 || (!isMinimized && workspaces[i] == current)) continue;
+        
+        Window* window = m_windowManager->windowById(ids[i]);
+        if (window && holdsBuffer(window)) {
+            (isMinimized ? minimized : hidden).push_back(window);
+        }
+    }
+    
+    // Least recently used first
+    auto byActivation = [this](Window* a, Window* b) {
+        return m_windowManager->activationStamp(a) < m_windowManager->activationStamp(b);
+    };
+    std::sort(minimized.begin(), minimized.end(), byActivation);
+    std::sort(hidden.begin(), hidden.end(), byActivation);
+    
+    // Visible windows are never candidates, covered ones included: raised
+    // or uncovered, they would show nothing until their client commits
+    // again, and an idle client may not
+    minimized.insert(minimized.end(), hidden.begin(), hidden.end());
+    return minimized;
+}
+
+void ClientMemoryTracker::enforceBudget() {
+    if (m_totalBytes <= m_budget) return;
+    PULSE_TRACE_SCOPE("memory", "enforceBudget");
+    
+    const qint64 target = m_budget / 100 * kEvictTargetPercent;
+    const qint64 before = m_totalBytes;
+    int evicted = 0;
+    
+    const FrameArena::Vector<Window*> order = evictionOrder();
+    for (Window* window : order) {
+        if (m_totalBytes <= target) break;
+        
+        // The next commit brings a buffer back
+        window->releaseBuffer();
+        account(window);
+        evicted++;
+    }
+    
+    m_evictions += evicted;
+    PULSE_TRACE_COUNTER("memory", "clientBytes", m_totalBytes);
+    
+    if (m_totalBytes > m_budget) {
+        qWarning() << "Client buffers use" << QString::number(toMiB(m_totalBytes), 'f', 1)
+                   << "MiB, over the" << QString::number(toMiB(m_budget), 'f', 1)
+                   << "MiB budget, with nothing left to evict";
+    } else if (evicted > 0) {
+        qDebug() << "Evicted" << evicted << "window buffers, freeing"
+                 << QString::number(toMiB(before - m_totalBytes), 'f', 1) << "MiB";
+    }
+}
+
+QVariantList ClientMemoryTracker::clients() const {
+    QList<const ClientUsage*> rows;
+    for (const ClientUsage& client : m_clients) {
+        rows.append(&client);
+    }
+    std::sort(rows.begin(), rows.end(), [](const ClientUsage* a, const ClientUsage* b) {
+        return a->usage.total() > b->usage.total();
+    });
+    
+    QVariantList list;
+    for (const ClientUsage* client : rows) {
+        list.append(QVariantMap{
+            {"pid", client->pid},
+            {"windows", client->windows},
+            {"bufferBytes", client->usage.bufferBytes},
+            {"textureBytes", client->usage.textureBytes},
+            {"nodes", client->usage.nodes},
+            {"totalBytes", client->usage.total()},
+            {"overQuota", client->overQuota}
+        });
+    }
+    return list;
+}
+
+QString ClientMemoryTracker::report() const {
+    QJsonObject report;
+    report["totalBytes"] = m_totalBytes;
+    report["budget"] = m_budget;
+    report["clientQuota"] = m_clientQuota;
+    report["evictions"] = m_evictions;
+    report["clients"] = QJsonArray::fromVariantList(clients());
+    return QString::fromUtf8(QJsonDocument(report).toJson(QJsonDocument::Compact));
+}
+
+bool ClientMemoryTracker::exportOnDBus() {
+    if (m_dbusRegistered) {
+        return true;
+    }
+    
+    m_dbusRegistered = QDBusConnection::sessionBus().registerObject(
+        "/org/pulse/ClientMemory", this,
+        QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportScriptableSignals);
+    
+    if (!m_dbusRegistered) {
+        qWarning() << "Failed to register client memory tracker on DBus";
+    }
+    return m_dbusRegistered;
+}
+
+} // namespace Pulse
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QVariantList>
+#include <QtQml/qqmlregistration.h>
+#include "FrameArena.h"
+#include "WindowEvents.h"
+
+class QWaylandClient;
+
+namespace Pulse {
+
+class Window;
+class WindowManager;
+class ThumbnailCache;
+
+// Per-client accounting of buffer memory, updated on every commit. Keeps
+// the total under a global budget by dropping the buffers of windows that
+// are not on screen, least useful first, and warns about clients that go
+// over their own quota.
+class ClientMemoryTracker : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by the compositor")
+    Q_CLASSINFO("D-Bus Interface", "org.pulse.ClientMemory")
+    Q_PROPERTY(qint64 totalBytes READ totalBytes NOTIFY statsChanged)
+    Q_PROPERTY(qint64 budget READ budget WRITE setBudget NOTIFY statsChanged)
+    Q_PROPERTY(qint64 clientQuota READ clientQuota WRITE setClientQuota NOTIFY statsChanged)
+    Q_PROPERTY(qint64 evictions READ evictions NOTIFY statsChanged)
+    Q_PROPERTY(QVariantList clients READ clients NOTIFY statsChanged)
+    
+public:
+    ClientMemoryTracker(WindowManager* windowManager, ThumbnailCache* thumbnails,
+                        QObject* parent = nullptr);
+    ~ClientMemoryTracker();
+    
+    // Attached buffers plus what the renderer holds for them, all clients
+    qint64 totalBytes() const { return m_totalBytes; }
+    
+    qint64 budget() const { return m_budget; }
+    void setBudget(qint64 bytes);
+    qint64 clientQuota() const { return m_clientQuota; }
+    void setClientQuota(qint64 bytes);
+    qint64 evictions() const { return m_evictions; }
+    
+    // One map per client, largest first (pid, windows, bufferBytes,
+    // textureBytes, nodes, totalBytes, overQuota)
+    QVariantList clients() const;
+    
+    bool exportOnDBus();
+    
+public slots:
+    Q_SCRIPTABLE QString report() const;
+    
+signals:
+    void statsChanged();
+    Q_SCRIPTABLE void quotaExceeded(qint64 pid, qint64 bytes);
+    
+private slots:
+    void enforceBudget();
+    void accountAll();
+    
+private:
+    void onWindowAdded(const WindowAdded& event);
+    void onWindowRemoved(const WindowRemoved& event);
+    
+    struct Usage {
+        qint64 bufferBytes = 0;
+        qint64 textureBytes = 0;
+        int nodes = 0;
+        
+        qint64 total() const { return bufferBytes + textureBytes; }
+    };
+    
+    struct ClientUsage {
+        Usage usage;
+        qint64 pid = 0;
+        int windows = 0;
+        bool overQuota = false;
+    };
+    
+    struct WindowEntry {
+        // Hash key only; the client may be gone before its windows are
+        QWaylandClient* client = nullptr;
+        Usage usage;
+    };
+    
+    void account(Window* window);
+    void apply(WindowEntry& entry, const Usage& usage);
+    void checkQuota(ClientUsage& usage);
+    FrameArena::Vector<Window*> evictionOrder() const;
+    
+    WindowManager* m_windowManager;
+    ThumbnailCache* m_thumbnails;
+    
+    QHash<Window*, WindowEntry> m_windows;
+    QHash<QWaylandClient*, ClientUsage> m_clients;
+    qint64 m_totalBytes = 0;
+    
+    qint64 m_budget = 256ll * 1024 * 1024;
+    qint64 m_clientQuota = 128ll * 1024 * 1024;
+    qint64 m_evictions = 0;
+    bool m_dbusRegistered = false;
+    
+    // Commits arrive per frame; budget checks and QML updates are batched
+    QTimer m_enforceTimer;
+    QTimer m_statsTimer;
+};
+
+} // namespace Pulse
@@ -0,0 +1,359 @@
+// Clipboard transfer benchmark.
+//
+// Runs the compositor on an offscreen output and starts itself twice more
+// as Wayland clients: a source (--source) that puts a large payload on the
+// clipboard once it has keyboard focus, and a sink (--sink) that reads the
+// whole payload when the selection is offered to it. The data device hands
+// the sink's fd straight to the source, so the payload should never pass
+// through the compositor. Measures the time from focusing the sink to the
+// sink reporting the full size, the compositor's peak resident memory
+// growth meanwhile, and the longest gap between ticks of a 1 ms timer on
+// the compositor's GUI thread. Exits non-zero when bytes go missing or a
+// limit is exceeded.
+
+#include "Compositor.h"
+#include <QClipboard>
+#include <QCommandLineParser>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QMimeData>
+#include <QPainter>
+#include <QProcess>
+#include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QRasterWindow>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QWaylandOutput>
+#include <QWaylandSeat>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QDebug>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+namespace Pulse {
+
+namespace {
+
+const char* const kMimeType = "application/x-pulse-benchmark";
+
+constexpr int kTransferTimeoutMs = 60000;
+constexpr int kStallTickMs = 1;
+
+class ClientWindow : public QRasterWindow {
+public:
+    ClientWindow(const QString& title, const QColor& color)
+        : m_color(color) {
+        setTitle(title);
+        resize(320, 240);
+    }
+    
+protected:
+    void paintEvent(QPaintEvent* event) override {
+        Q_UNUSED(event)
+        QPainter(this).fillRect(QRect(QPoint(), size()), m_color);
+    }
+    
+private:
+    QColor m_color;
+};
+
+void reply(const QByteArray& line) {
+    std::fwrite(line.constData(), 1, line.size(), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+// The benchmark closing stdin ends a client
+void quitOnStdinClosed(QGuiApplication& app, QSocketNotifier& notifier) {
+    QObject::connect(&notifier, &QSocketNotifier::activated, &app, [&app]() {
+        char buffer[64];
+        if (::read(STDIN_FILENO, buffer, sizeof(buffer)) <= 0) {
+            app.quit();
+        }
+    });
+}
+
+int runSource(QGuiApplication& app, qint64 bytes) {
+    ClientWindow window("clipboard-source", QColor("#208080"));
+    window.show();
+    
+    QSocketNotifier notifier(STDIN_FILENO, QSocketNotifier::Read);
+    quitOnStdinClosed(app, notifier);
+    
+    // Selections are only accepted from the focused client
+    bool offered = false;
+    QObject::connect(&window, &QWindow::activeChanged, &app, [&]() {
+        if (!window.isActive() || offered) return;
+        offered = true;
+        
+        auto* data = new QMimeData;
+        data->setData(kMimeType, QByteArray(bytes, 'p'));
+        QGuiApplication::clipboard()->setMimeData(data);
+        reply("offered");
+    });
+    
+    return app.exec();
+}
+
+int runSink(QGuiApplication& app) {
+    ClientWindow window("clipboard-sink", QColor("#802080"));
+    window.show();
+    
+    QSocketNotifier notifier(STDIN_FILENO, QSocketNotifier::Read);
+    quitOnStdinClosed(app, notifier);
+    
+    // The offer arrives with keyboard focus; data() reads it all
+    QObject::connect(QGuiApplication::clipboard(), &QClipboard::dataChanged, &app, []() {
+        const QMimeData* data = QGuiApplication::clipboard()->mimeData();
+        if (data && data->hasFormat(kMimeType)) {
+            reply("received " + QByteArray::number(data->data(kMimeType).size()));
+        }
+    });
+    
+    return app.exec();
+}
+
+// From /proc/self/status, in kB
+qint64 statusField(const QByteArray& name) {
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) return 0;
+    for (const QByteArray& line : status.readAll().split('\n')) {
+        if (line.startsWith(name + ':')) {
+            return line.mid(name.size() + 1).trimmed().split(' ').value(0).toLongLong();
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+class ClipboardBenchmark : public QObject {
+public:
+    struct Limits {
+        double maxRssGrowthMb = 16;
+        double maxStallMs = 50;
+    };
+    
+    ClipboardBenchmark(qint64 bytes, const Limits& limits)
+        : m_bytes(bytes)
+        , m_limits(limits) {
+        m_stallTimer.setInterval(kStallTickMs);
+        connect(&m_stallTimer, &QTimer::timeout, this, [this]() {
+            const qint64 now = m_clock.nsecsElapsed();
+            m_maxStallNs = qMax(m_maxStallNs, now - m_lastTick);
+            m_lastTick = now;
+        });
+    }
+    
+    ~ClipboardBenchmark() {
+        for (QProcess* client : { &m_source, &m_sink }) {
+            if (client->state() != QProcess::NotRunning) {
+                client->closeWriteChannel();
+                if (!client->waitForFinished(2000)) {
+                    client->kill();
+                }
+            }
+        }
+    }
+    
+    bool start() {
+        m_clock.start();
+        m_compositor.setSocketName(QByteArray("pulse-clipboard-") + QByteArray::number(QCoreApplication::applicationPid()));
+        
+        m_engine.setInitialProperties({{"compositor", QVariant::fromValue(&m_compositor)}});
+        m_engine.load(QUrl(QStringLiteral("qrc:/qt/qml/Pulse/CompositorView.qml")));
+        m_window = m_engine.rootObjects().isEmpty() ? nullptr
+            : qobject_cast<QQuickWindow*>(m_engine.rootObjects().constFirst());
+        if (!m_window) {
+            qWarning() << "Clipboard benchmark: failed to load CompositorView";
+            return false;
+        }
+        
+        m_compositor.create();
+        auto* output = new QWaylandOutput(&m_compositor, m_window);
+        output->setSizeFollowsWindow(true);
+        
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        environment.insert("WAYLAND_DISPLAY", QString::fromUtf8(m_compositor.socketName()));
+        environment.insert("QT_QPA_PLATFORM", "wayland");
+        environment.insert("QT_WAYLAND_DISABLE_WINDOWDECORATION", "1");
+        
+        for (QProcess* client : { &m_source, &m_sink }) {
+            client->setProcessEnvironment(environment);
+            client->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+            connect(client, &QProcess::readyReadStandardOutput, this, [this, client]() {
+                while (client->canReadLine()) {
+                    onReply(client->readLine().trimmed());
+                }
+            });
+        }
+        m_source.start(QCoreApplication::applicationFilePath(),
+                       {"--source", "--size-bytes", QString::number(m_bytes)});
+        m_sink.start(QCoreApplication::applicationFilePath(), {"--sink"});
+        
+        waitForClientWindows(QDeadlineTimer(10000));
+        return true;
+    }
+    
+    int exitCode() const { return m_exitCode; }
+    
+private:
+    Window* windowTitled(const QString& title) const {
+        for (Window* window : m_compositor.windowManager()->windows()) {
+            if (window->title() == title) return window;
+        }
+        return nullptr;
+    }
+    
+    void waitForClientWindows(const QDeadlineTimer& deadline) {
+        m_sourceWindow = windowTitled("clipboard-source");
+        m_sinkWindow = windowTitled("clipboard-sink");
+        if (m_sourceWindow && m_sinkWindow) {
+            m_compositor.defaultSeat()->setKeyboardFocus(m_sourceWindow->surface());
+            QTimer::singleShot(kTransferTimeoutMs, this, [this]() {
+                qWarning() << "Clipboard benchmark: transfer timed out";
+                finish(2);
+            });
+            return;
+        }
+        
+        if (deadline.hasExpired() || m_source.state() == QProcess::NotRunning ||
+            m_sink.state() == QProcess::NotRunning) {
+            qWarning() << "Clipboard benchmark: client windows did not appear";
+            finish(2);
+            return;
+        }
+        QTimer::singleShot(50, this, [this, deadline]() { waitForClientWindows(deadline); });
+    }
+    
+    void onReply(const QByteArray& line) {
+        if (line == "offered") {
+            startTransfer();
+        } else if (line.startsWith("received ")) {
+            report(line.mid(9).toLongLong());
+        }
+    }
+    
+    void startTransfer() {
+        // Peak RSS counts from here: writing 5 to clear_refs resets VmHWM
+        QFile clearRefs("/proc/self/clear_refs");
+        if (clearRefs.open(QIODevice::WriteOnly)) {
+            clearRefs.write("5");
+        }
+        m_rssBeforeKb = statusField("VmRSS");
+        
+        m_lastTick = m_clock.nsecsElapsed();
+        m_maxStallNs = 0;
+        m_stallTimer.start();
+        
+        m_t0 = m_clock.nsecsElapsed();
+        m_compositor.defaultSeat()->setKeyboardFocus(m_sinkWindow->surface());
+    }
+    
+    void report(qint64 received) {
+        const double seconds = (m_clock.nsecsElapsed() - m_t0) / 1e9;
+        m_stallTimer.stop();
+        
+        const double rssGrowthMb = qMax<qint64>(0, statusField("VmHWM") - m_rssBeforeKb) / 1024.0;
+        const double maxStallMs = m_maxStallNs / 1e6;
+        const bool complete = received == m_bytes;
+        const bool failed = !complete || rssGrowthMb > m_limits.maxRssGrowthMb ||
+                            maxStallMs > m_limits.maxStallMs;
+        
+        qInfo().noquote() << QString("%1 MB in %2 ms (%3 MB/s), compositor peak RSS +%4 MB (limit %5), "
+                                     "longest GUI stall %6 ms (limit %7)%8")
+            .arg(m_bytes / 1e6, 0, 'f', 1).arg(seconds * 1000, 0, 'f', 1)
+            .arg(m_bytes / 1e6 / qMax(seconds, 1e-9), 0, 'f', 0)
+            .arg(rssGrowthMb, 0, 'f', 1).arg(m_limits.maxRssGrowthMb)
+            .arg(maxStallMs, 0, 'f', 1).arg(m_limits.maxStallMs)
+            .arg(failed ? " FAILED" : "");
+        if (!complete) {
+            qWarning() << "Sink received" << received << "of" << m_bytes << "bytes";
+        }
+        finish(failed ? 1 : 0);
+    }
+    
+    void finish(int exitCode) {
+        m_exitCode = exitCode;
+        QCoreApplication::exit(exitCode);
+    }
+    
+    const qint64 m_bytes;
+    const Limits m_limits;
+    
+    Compositor m_compositor;
+    QQmlApplicationEngine m_engine;
+    QQuickWindow* m_window = nullptr;
+    QProcess m_source;
+    QProcess m_sink;
+    QElapsedTimer m_clock;
+    QTimer m_stallTimer;
+    
+    Window* m_sourceWindow = nullptr;
+    Window* m_sinkWindow = nullptr;
+    
+    qint64 m_t0 = 0;
+    qint64 m_rssBeforeKb = 0;
+    qint64 m_lastTick = 0;
+    qint64 m_maxStallNs = 0;
+    int m_exitCode = 0;
+};
+
+} // namespace Pulse
+
+// The Pulse module is linked statically
+Q_IMPORT_QML_PLUGIN(PulsePlugin)
+
+int main(int argc, char *argv[]) {
+    const bool client = std::any_of(argv + 1, argv + argc, [](const char* arg) {
+        return qstrcmp(arg, "--source") == 0 || qstrcmp(arg, "--sink") == 0;
+    });
+    // Keeps the window manager's session file out of the user's data
+    if (!client) {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+    
+    if (!client && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("pulse-clipboard-benchmark");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Clipboard transfer benchmark for the Pulse compositor");
+    parser.addHelpOption();
+    parser.addOption({"source", "Run as the clipboard source (started by the benchmark)"});
+    parser.addOption({"sink", "Run as the clipboard sink (started by the benchmark)"});
+    parser.addOption({"size-mb", "Payload size", "MB", "100"});
+    parser.addOption({"size-bytes", "Payload size in bytes; overrides --size-mb", "bytes"});
+    parser.addOption({"max-rss-growth-mb", "Compositor peak RSS growth limit", "MB", "16"});
+    parser.addOption({"max-stall-ms", "Compositor GUI thread stall limit", "ms", "50"});
+    parser.process(app);
+    
+    const qint64 bytes = parser.isSet("size-bytes") ? parser.value("size-bytes").toLongLong()
+        : qint64(parser.value("size-mb").toDouble() * 1000 * 1000);
+    
+    if (parser.isSet("source")) {
+        return Pulse::runSource(app, bytes);
+    }
+    if (parser.isSet("sink")) {
+        return Pulse::runSink(app);
+    }
+    
+    Pulse::ClipboardBenchmark::Limits limits;
+    limits.maxRssGrowthMb = parser.value("max-rss-growth-mb").toDouble();
+    limits.maxStallMs = parser.value("max-stall-ms").toDouble();
+    
+    Pulse::ClipboardBenchmark benchmark(qMax<qint64>(1, bytes), limits);
+    if (!benchmark.start()) {
+        return 2;
+    }
+    
+    return app.exec();
+}
@@ -1,43 +1,164 @@
 #include "Compositor.h"
+#include "AllocationCounter.h"
+#include "EventBus.h"
+#include "FrameArena.h"
+#include "TitleTextCache.h"
+#include "Tracer.h"
+#include <QAbstractEventDispatcher>
+#include <QGuiApplication>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <QThread>
 #include <QDebug>
 
 namespace Pulse {
 
+// About ten seconds at 60 Hz
+static constexpr int kAllocationReportFrames = 600;
+
 Compositor::Compositor(QObject* parent)
     : QWaylandCompositor(parent)
-    , m_windowManager(new WindowManager(this)) {
+    , m_windowManager(new WindowManager(this))
+    , m_xdgShell(new QWaylandXdgShell(this))
+    , m_thumbnails(new ThumbnailCache(m_windowManager, this))
+    , m_switcher(new WindowSwitcherModel(m_windowManager, this))
+    , m_input(new InputDispatcher(this))
+    , m_windowTable(new WindowTablePublisher(m_windowManager, this))
+    , m_clientMemory(new ClientMemoryTracker(m_windowManager, m_thumbnails, this)) {
     
     qDebug() << "Pulse Compositor initialized";
     
-    // Connect signals
+    // Connect signals; only xdg toplevels become windows, not cursor,
+    // subsurface or popup surfaces
     connect(this, &QWaylandCompositor::surfaceCreated,
             this, &Compositor::onSurfaceCreated);
+    connect(m_xdgShell, &QWaylandXdgShell::toplevelCreated,
+            this, &Compositor::onToplevelCreated);
+    
+    EventBus* bus = EventBus::instance();
+    bus->subscribe<WindowAdded, &Compositor::onWindowAdded>(this);
+    bus->subscribe<WindowRemoved, &Compositor::onWindowRemoved>(this);
+    
+    // Work between frames (input, client requests) uses the frame arena
+    // too; without frames only this rewinds it. Not inside a nested event
+    // loop, whose caller may still hold arena memory.
+    connect(QAbstractEventDispatcher::instance(), &QAbstractEventDispatcher::aboutToBlock, this, []() {
+        if (QThread::currentThread()->loopLevel() <= 1) {
+            FrameArena::instance()->reset();
+        }
+    });
+    
+    // Common title glyphs are ready before the first window maps
+    TitleTextCache::instance()->prewarm(QGuiApplication::font());
     
-    connect(m_windowManager, &WindowManager::windowAdded,
-            this, &Compositor::onWindowAdded);
-    connect(m_windowManager, &WindowManager::windowRemoved,
-            this, &Compositor::onWindowRemoved);
+    // Live window state for panels and docks, without D-Bus round trips.
+    // The socket is named after ours, which is only final once created.
+    connect(this, &QWaylandCompositor::createdChanged, this, [this]() {
+        if (isCreated()) {
+            m_windowTable->start(QString::fromStdString(windowTableSocketPath(socketName().constData())));
+        }
+    });
+    
+    // Per-client buffer usage for tools and the control panel
+    m_clientMemory->exportOnDBus();
 }
 
 Compositor::~Compositor() {
     qDebug() << "Pulse Compositor shutting down";
 }
 
-void Compositor::onSurfaceCreated(QWaylandSurface* surface) {
-    qDebug() << "Surface created for process:" << surface->client()->processId();
+void Compositor::attachWindow(QQuickWindow* window) {
+    if (!window || m_window == window) return;
     
-    // Create window for this surface
-    Window* window = m_windowManager->createWindow(surface);
+    if (m_window) {
+        disconnect(m_window, nullptr, this, nullptr);
+    }
+    m_window = window;
     
-    connect(surface, &QWaylandSurface::destroyed,
-            this, &Compositor::onSurfaceDestroyed);
+    // Minimized windows and the overview are drawn from image://thumbnails
+    QQmlEngine* engine = qmlEngine(window);
+    if (engine && !engine->imageProvider("thumbnails")) {
+        engine->addImageProvider("thumbnails", new ThumbnailProvider(m_thumbnails));
+    }
+    
+    // Emitted on the render thread; direct connections keep spans on that thread
+    connect(window, &QQuickWindow::beforeSynchronizing, this, []() {
+        Tracer::begin("frame", "sync");
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterSynchronizing, this, []() {
+        Tracer::end("frame", "sync");
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::beforeRendering, this, []() {
+        Tracer::begin("frame", "render");
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering, this, []() {
+        Tracer::end("frame", "render");
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        PULSE_TRACE_COUNTER("frame", "windows", m_windowManager->windowCount());
+    }, Qt::DirectConnection);
+    
+    // Window events of this frame reach their handlers as one batch,
+    // before the scene is synchronized
+    connect(window, &QQuickWindow::afterAnimating, this, []() {
+        EventBus::instance()->flush();
+    });
+    
+    // Queued to the GUI thread when the render loop is threaded
+    connect(window, &QQuickWindow::frameSwapped,
+            this, &Compositor::sendFrameCallbacks);
+    connect(window, &QQuickWindow::frameSwapped,
+            this, &Compositor::endFrame);
     
-    if (window) {
-        qDebug() << "Window created for surface:" << window->title();
+    // Read devices directly when we own the seat; nested sessions keep
+    // using the toolkit's input through QML. main() has already turned
+    // the platform's own device input off in this case.
+    const QString platform = QGuiApplication::platformName();
+    if (qEnvironmentVariableIsSet("PULSE_LIBINPUT") ||
+        platform == "eglfs" || platform == "linuxfb") {
+        m_input->start(window);
     }
 }
 
+void Compositor::sendFrameCallbacks() {
+    PULSE_TRACE_SCOPE("frame", "sendFrameCallbacks");
+    
+    // Windows on hidden workspaces or minimized get no callbacks, which
+    // pauses well-behaved clients until they are shown again
+    for (Window* window : m_windowManager->currentWorkspaceObject()->windows()) {
+        if (window->state() != Window::State::Minimized && window->surface()) {
+            window->surface()->sendFrameCallbacks();
+        }
+    }
+    
+    // Cursors, subsurfaces and popups wait for callbacks too
+    for (QWaylandSurface* surface : std::as_const(m_auxiliarySurfaces)) {
+        surface->sendFrameCallbacks();
+    }
+}
+
+void Compositor::endFrame() {
+    FrameArena::instance()->reset();
+    
+    // Diagnostics builds: steady-state frames should not allocate at all
+    AllocationCounter::frameEnd();
+    if (AllocationCounter::available() && ++m_framesSinceReport >= kAllocationReportFrames) {
+        m_framesSinceReport = 0;
+        qDebug().noquote() << "Allocations:" << AllocationCounter::report();
+        AllocationCounter::rebase();
+    }
+}
+
+void Compositor::onSurfaceCreated(QWaylandSurface* surface) {
+    // Until it gets a toplevel role the surface is not a window
+    m_auxiliarySurfaces.append(surface);
+    connect(surface, &QObject::destroyed, this, [this, surface]() {
+        m_auxiliarySurfaces.removeOne(surface);
+    });
+}
+
 void Compositor::onSurfaceDestroyed() {
+    PULSE_TRACE_SCOPE("compositor", "surfaceDestroyed");
     auto* surface = qobject_cast<QWaylandSurface*>(sender());
     if (surface) {
         Window* window = m_windowManager->windowForSurface(surface);
@@ -47,12 +168,43 @@ void Compositor::onSurfaceDestroyed() {
     }
 }
 
-void Compositor::onWindowAdded(Window* window) {
+void Compositor::onToplevelCreated(QWaylandXdgToplevel* toplevel, QWaylandXdgSurface* xdgSurface) {
+    PULSE_TRACE_SCOPE("compositor", "toplevelCreated");
+    
+    QWaylandSurface* surface = xdgSurface->surface();
+    Window* window = m_windowManager->windowForSurface(surface);
+    if (!window) {
+        window = m_windowManager->createWindow(surface);
+        if (!window) return;
+        
+        connect(surface, &QWaylandSurface::destroyed,
+                this, &Compositor::onSurfaceDestroyed);
+        m_auxiliarySurfaces.removeOne(surface);
+        qDebug() << "Window created for process:" << surface->client()->processId();
+    }
+    
+    window->setToplevel(toplevel);
+    
+    // Client-side state requests
+    connect(toplevel, &QWaylandXdgToplevel::setMaximized, window, [this, window]() {
+        m_windowManager->maximizeWindow(window);
+    });
+    connect(toplevel, &QWaylandXdgToplevel::unsetMaximized, window, [window]() {
+        window->setState(Window::State::Normal);
+    });
+    connect(toplevel, &QWaylandXdgToplevel::setMinimized, window, [this, window]() {
+        m_windowManager->minimizeWindow(window);
+    });
+}
+
+void Compositor::onWindowAdded(const WindowAdded& event) {
+    Window* window = event.window;
     qDebug() << "Window added to compositor:" << window->title()
              << "Total windows:" << m_windowManager->windowCount();
 }
 
-void Compositor::onWindowRemoved(Window* window) {
+void Compositor::onWindowRemoved(const WindowRemoved& event) {
+    Window* window = event.window;
     qDebug() << "Window removed from compositor:" << window->title()
              << "Remaining windows:" << m_windowManager->windowCount();
 }
@@ -2,18 +2,45 @@
 
 #include <QWaylandCompositor>
 #include <QWaylandSurface>
+#include <QWaylandXdgShell>
+#include <QPointer>
+#include <QtQml/qqmlregistration.h>
 #include "WindowManager.h"
+#include "ThumbnailCache.h"
+#include "WindowSwitcherModel.h"
+#include "InputDispatcher.h"
+#include "WindowTablePublisher.h"
+#include "ClientMemoryTracker.h"
+#include "WindowEvents.h"
+
+class QQuickWindow;
 
 namespace Pulse {
 
 class Compositor : public QWaylandCompositor {
     Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by the compositor")
+    Q_PROPERTY(Pulse::WindowManager* windowManager READ windowManager CONSTANT)
+    Q_PROPERTY(Pulse::ThumbnailCache* thumbnails READ thumbnails CONSTANT)
+    Q_PROPERTY(Pulse::WindowSwitcherModel* switcher READ switcher CONSTANT)
+    Q_PROPERTY(Pulse::InputDispatcher* input READ input CONSTANT)
+    Q_PROPERTY(Pulse::ClientMemoryTracker* clientMemory READ clientMemory CONSTANT)
     
 public:
     explicit Compositor(QObject* parent = nullptr);
     ~Compositor();
     
     WindowManager* windowManager() const { return m_windowManager; }
+    QWaylandXdgShell* xdgShell() const { return m_xdgShell; }
+    ThumbnailCache* thumbnails() const { return m_thumbnails; }
+    WindowSwitcherModel* switcher() const { return m_switcher; }
+    InputDispatcher* input() const { return m_input; }
+    WindowTablePublisher* windowTable() const { return m_windowTable; }
+    ClientMemoryTracker* clientMemory() const { return m_clientMemory; }
+    
+    // Hook the compositing window's frame signals and start input
+    Q_INVOKABLE void attachWindow(QQuickWindow* window);
     
 public slots:
     void closeActiveWindow();
@@ -22,14 +49,33 @@ public slots:
     void tileWindows();
     void cascadeWindows();
     
+    // Frame callbacks go only to windows that are actually on screen
+    void sendFrameCallbacks();
+    
+    // GUI thread, once per frame: rewinds the frame arena
+    void endFrame();
+    
 private slots:
     void onSurfaceCreated(QWaylandSurface* surface);
     void onSurfaceDestroyed();
-    void onWindowAdded(Window* window);
-    void onWindowRemoved(Window* window);
+    void onToplevelCreated(QWaylandXdgToplevel* toplevel, QWaylandXdgSurface* xdgSurface);
     
 private:
+    void onWindowAdded(const WindowAdded& event);
+    void onWindowRemoved(const WindowRemoved& event);
+    
     WindowManager* m_windowManager;
+    QWaylandXdgShell* m_xdgShell;
+    ThumbnailCache* m_thumbnails;
+    WindowSwitcherModel* m_switcher;
+    InputDispatcher* m_input;
+    WindowTablePublisher* m_windowTable;
+    ClientMemoryTracker* m_clientMemory;
+    QPointer<QQuickWindow> m_window;
+    int m_framesSinceReport = 0;
+    
+    // Surfaces without a window: cursors, subsurfaces, popups
+    QList<QWaylandSurface*> m_auxiliarySurfaces;
 };
 
 } // namespace Pulse
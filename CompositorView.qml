@@ -11,39 +11,46 @@ Window {
     title: "Pulse Compositor - Window Manager"
     color: "#1a1a1a"
     
-    property var compositor: null
+    property Compositor compositor: null
+    property bool workspaceTransitions: true
     
-    // Background grid
-    Canvas {
-        id: gridCanvas
+    onCompositorChanged: if (compositor) compositor.attachWindow(root)
+    
+    // Background grid, drawn by the scene graph in one draw call; set
+    // source for a wallpaper
+    BackgroundItem {
         anchors.fill: parent
-        onPaint: {
-            var ctx = getContext("2d");
-            ctx.strokeStyle = "#333333";
-            ctx.lineWidth = 1;
-            
-            // Draw grid lines
-            for (var x = 0; x < width; x += 50) {
-                ctx.beginPath();
-                ctx.moveTo(x, 0);
-                ctx.lineTo(x, height);
-                ctx.stroke();
-            }
-            for (var y = 0; y < height; y += 50) {
-                ctx.beginPath();
-                ctx.moveTo(0, y);
-                ctx.lineTo(width, y);
-                ctx.stroke();
-            }
-        }
+        color: root.color
+        gridColor: "#333333"
+        gridSpacing: 50
     }
     
-    // Window renderers
+    // One retained layer per workspace; switching only toggles visibility
     Repeater {
-        model: compositor ? compositor.windowManager.windows : []
-        delegate: WindowItem {
-            window: modelData
-            compositor: root.compositor
+        model: compositor ? compositor.windowManager.workspaces : []
+        delegate: Item {
+            id: workspaceLayer
+            anchors.fill: parent
+            visible: modelData.active
+            
+            onVisibleChanged: if (visible && root.workspaceTransitions) fadeIn.restart()
+            
+            // Runs on the render thread
+            OpacityAnimator {
+                id: fadeIn
+                target: workspaceLayer
+                from: 0
+                to: 1
+                duration: 150
+            }
+            
+            Repeater {
+                model: modelData
+                delegate: WindowItem {
+                    window: model.window
+                    compositor: root.compositor
+                }
+            }
         }
     }
     
@@ -51,7 +58,7 @@ Window {
     Rectangle {
         id: controlPanel
         width: 300
-        height: 200
+        height: panelColumn.implicitHeight + 20
         color: "#2a2a2a"
         radius: 8
         anchors.top: parent.top
@@ -59,6 +66,7 @@ Window {
         anchors.margins: 20
         
         Column {
+            id: panelColumn
             anchors.fill: parent
             anchors.margins: 10
             spacing: 8
@@ -104,9 +112,32 @@ Window {
                 width: parent.width
                 onClicked: if (compositor) compositor.toggleMaximizeActiveWindow()
             }
+            
+            Text {
+                text: compositor ? "Client memory: " + (compositor.clientMemory.totalBytes / 1048576).toFixed(1) +
+                                   " / " + (compositor.clientMemory.budget / 1048576).toFixed(0) + " MiB" : ""
+                color: "#aaaaaa"
+            }
+            
+            // Heaviest clients first
+            Repeater {
+                model: compositor ? compositor.clientMemory.clients.slice(0, 5) : []
+                delegate: Text {
+                    text: "PID " + modelData.pid + ": " + (modelData.totalBytes / 1048576).toFixed(1) + " MiB, " +
+                          modelData.windows + " win, " + modelData.nodes + " nodes"
+                    color: modelData.overQuota ? "#e25a4a" : "#888888"
+                    font.pixelSize: 11
+                }
+            }
         }
     }
     
+    // Cursor driven by the input thread (only when reading devices directly)
+    CursorItem {
+        anchors.fill: parent
+        input: compositor ? compositor.input : null
+    }
+    
     // Info text
     Text {
         anchors.bottom: parent.bottom
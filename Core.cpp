@@ -1,8 +1,10 @@
 #include "Core.h"
 #include "Logger.h"
+#include "Tracer.h"
 #include "../pulse-config/Config.h"
 #include "../pulse-ipc/DBusInterface.h"
 #include "../pulse-plugins/PluginManager.h"
+#include "../pulse-plugins/PluginWatchdog.h"
 
 #include <QDebug>
 
@@ -14,6 +16,7 @@ public:
     std::unique_ptr<Config> config;
     std::unique_ptr<DBusInterface> dbus;
     std::unique_ptr<PluginManager> pluginManager;
+    std::unique_ptr<PluginWatchdog> pluginWatchdog;
 };
 
 Core* Core::instance() {
@@ -30,6 +33,7 @@ Core::Core(QObject* parent)
     d->config = std::make_unique<Config>();
     d->dbus = std::make_unique<DBusInterface>();
     d->pluginManager = std::make_unique<PluginManager>();
+    d->pluginWatchdog = std::make_unique<PluginWatchdog>();
 }
 
 Core::~Core() {
@@ -60,6 +64,9 @@ bool Core::initialize(const QStringList& args) {
     if (!d->dbus->initialize()) {
         qWarning() << "Failed to initialize DBus (continuing without it)";
         // DBus is optional for now
+    } else {
+        Tracer::instance()->exportOnDBus();
+        d->pluginWatchdog->exportOnDBus();
     }
     
     if (!d->pluginManager->initialize()) {
@@ -106,6 +113,10 @@ PluginManager* Core::pluginManager() const {
     return d->pluginManager.get();
 }
 
+PluginWatchdog* Core::pluginWatchdog() const {
+    return d->pluginWatchdog.get();
+}
+
 Logger* Core::logger() const {
     return d->logger.get();
 }
@@ -9,6 +9,7 @@ namespace Pulse {
 // Forward declarations
 class Config;
 class PluginManager;
+class PluginWatchdog;
 class Logger;
 class DBusInterface;
 
@@ -45,6 +46,7 @@ public:
     // Subsystem access
     Config* config() const;
     PluginManager* pluginManager() const;
+    PluginWatchdog* pluginWatchdog() const;
     Logger* logger() const;
     DBusInterface* dbus() const;
     
@@ -0,0 +1,90 @@
+#include "CursorItem.h"
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGTransformNode>
+
+namespace Pulse {
+
+CursorItem::CursorItem(QQuickItem* parent)
+    : QQuickItem(parent) {
+    setFlag(ItemHasContents, true);
+    setZ(1000000);
+}
+
+CursorItem::~CursorItem() {
+}
+
+void CursorItem::setInput(InputDispatcher* input) {
+    if (m_input == input) return;
+    
+    if (m_input) {
+        disconnect(m_input, nullptr, this, nullptr);
+    }
+    
+    m_input = input;
+    if (m_input) {
+        connect(m_input, &InputDispatcher::runningChanged, this, &QQuickItem::update);
+        connect(m_input, &InputDispatcher::cursorMoved, this, &QQuickItem::update);
+    }
+    
+    emit inputChanged(input);
+    update();
+}
+
+void CursorItem::setColor(const QColor& color) {
+    if (m_color != color) {
+        m_color = color;
+        emit colorChanged(color);
+        update();
+    }
+}
+
+QSGNode* CursorItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) {
+    Q_UNUSED(data)
+    
+    if (!m_input || !m_input->running()) {
+        delete oldNode;
+        return nullptr;
+    }
+    
+    auto* transform = static_cast<QSGTransformNode*>(oldNode);
+    if (!transform) {
+        transform = new QSGTransformNode;
+        
+        // Arrow pointer as one triangle fan
+        auto* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 4);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangleFan);
+        QSGGeometry::Point2D* points = geometry->vertexDataAsPoint2D();
+        points[0].set(0, 0);
+        points[1].set(0, 18);
+        points[2].set(5, 13);
+        points[3].set(12, 12);
+        
+        auto* arrow = new QSGGeometryNode;
+        arrow->setGeometry(geometry);
+        arrow->setFlag(QSGNode::OwnsGeometry);
+        arrow->setMaterial(new QSGFlatColorMaterial);
+        arrow->setFlag(QSGNode::OwnsMaterial);
+        transform->appendChildNode(arrow);
+    }
+    
+    auto* arrow = static_cast<QSGGeometryNode*>(transform->firstChild());
+    auto* material = static_cast<QSGFlatColorMaterial*>(arrow->material());
+    if (material->color() != m_color) {
+        material->setColor(m_color);
+        arrow->markDirty(QSGNode::DirtyMaterial);
+    }
+    
+    // Read now rather than from the GUI thread's last value: the input
+    // thread may have moved the cursor since the update was requested
+    const QPointF position = m_input->cursorPosition();
+    QMatrix4x4 matrix;
+    matrix.translate(position.x(), position.y());
+    if (transform->matrix() != matrix) {
+        transform->setMatrix(matrix);
+        transform->markDirty(QSGNode::DirtyMatrix);
+    }
+    return transform;
+}
+
+} // namespace Pulse
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QQuickItem>
+#include <QColor>
+#include <QPointer>
+#include <QtQml/qqmlregistration.h>
+#include "InputDispatcher.h"
+
+namespace Pulse {
+
+// Pointer cursor drawn at the input thread's latest cursor position. Every
+// burst of motion costs one update(), and the position is read at sync
+// rather than replayed from queued events
+class CursorItem : public QQuickItem {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(Pulse::InputDispatcher* input READ input WRITE setInput NOTIFY inputChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    
+public:
+    explicit CursorItem(QQuickItem* parent = nullptr);
+    ~CursorItem();
+    
+    InputDispatcher* input() const { return m_input; }
+    void setInput(InputDispatcher* input);
+    
+    QColor color() const { return m_color; }
+    void setColor(const QColor& color);
+    
+signals:
+    void inputChanged(InputDispatcher* input);
+    void colorChanged(const QColor& color);
+    
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    
+private:
+    QPointer<InputDispatcher> m_input;
+    QColor m_color = Qt::white;
+};
+
+} // namespace Pulse
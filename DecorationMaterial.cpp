@@ -0,0 +1,110 @@
+#include "DecorationMaterial.h"
+#include <QSGMaterialShader>
+#include <cstring>
+#include <tuple>
+
+namespace Pulse {
+
+namespace {
+
+// Must match the std140 block in decoration.vert/decoration.frag
+constexpr int kMatrixOffset = 0;
+constexpr int kOpacityOffset = 64;
+constexpr int kTitleBarOffset = 68;
+constexpr int kFrameOffset = 80;          // width, height, radius, border
+constexpr int kShadowOffset = 96;         // offset x/y, softness
+constexpr int kBorderColorOffset = 112;
+constexpr int kTitleBarColorOffset = 128;
+constexpr int kClientColorOffset = 144;
+constexpr int kShadowColorOffset = 160;
+constexpr int kUniformSize = 176;
+
+void writeFloats(QByteArray* buffer, int offset, std::initializer_list<float> values) {
+    std::memcpy(buffer->data() + offset, values.begin(), values.size() * sizeof(float));
+}
+
+void writeColor(QByteArray* buffer, int offset, const QColor& color) {
+    // Straight alpha; the fragment shader premultiplies after blending layers
+    writeFloats(buffer, offset, { float(color.redF()), float(color.greenF()),
+                                  float(color.blueF()), float(color.alphaF()) });
+}
+
+class DecorationShader : public QSGMaterialShader {
+public:
+    DecorationShader() {
+        setShaderFileName(VertexStage, QStringLiteral(":/shaders/decoration.vert.qsb"));
+        setShaderFileName(FragmentStage, QStringLiteral(":/shaders/decoration.frag.qsb"));
+    }
+    
+    bool updateUniformData(RenderState& state, QSGMaterial* newMaterial,
+                           QSGMaterial* oldMaterial) override {
+        QByteArray* buffer = state.uniformData();
+        Q_ASSERT(buffer->size() >= kUniformSize);
+        bool changed = false;
+        
+        if (state.isMatrixDirty()) {
+            const QMatrix4x4 matrix = state.combinedMatrix();
+            std::memcpy(buffer->data() + kMatrixOffset, matrix.constData(), 64);
+            changed = true;
+        }
+        if (state.isOpacityDirty()) {
+            writeFloats(buffer, kOpacityOffset, { float(state.opacity()) });
+            changed = true;
+        }
+        
+        auto* material = static_cast<DecorationMaterial*>(newMaterial);
+        if (oldMaterial != newMaterial || material->compare(oldMaterial) != 0) {
+            writeFloats(buffer, kTitleBarOffset, { float(material->titleBarHeight) });
+            writeFloats(buffer, kFrameOffset, { float(material->size.width()),
+                                                float(material->size.height()),
+                                                float(material->cornerRadius),
+                                                float(material->borderWidth) });
+            writeFloats(buffer, kShadowOffset, { float(material->shadowOffset.x()),
+                                                 float(material->shadowOffset.y()),
+                                                 float(material->shadowSoftness), 0.0f });
+            writeColor(buffer, kBorderColorOffset, material->borderColor);
+            writeColor(buffer, kTitleBarColorOffset, material->titleBarColor);
+            writeColor(buffer, kClientColorOffset, material->clientColor);
+            writeColor(buffer, kShadowColorOffset, material->shadowColor);
+            changed = true;
+        }
+        
+        return changed;
+    }
+};
+
+} // namespace
+
+DecorationMaterial::DecorationMaterial() {
+    setFlag(Blending, true);
+}
+
+QSGMaterialType* DecorationMaterial::type() const {
+    static QSGMaterialType type;
+    return &type;
+}
+
+QSGMaterialShader* DecorationMaterial::createShader(QSGRendererInterface::RenderMode renderMode) const {
+    Q_UNUSED(renderMode)
+    return new DecorationShader;
+}
+
+int DecorationMaterial::compare(const QSGMaterial* other) const {
+    auto key = [](const DecorationMaterial* material) {
+        return std::make_tuple(material->size.width(), material->size.height(),
+                               material->cornerRadius, material->borderWidth,
+                               material->titleBarHeight, material->borderColor.rgba(),
+                               material->titleBarColor.rgba(), material->clientColor.rgba(),
+                               material->shadowColor.rgba(), material->shadowOffset.x(),
+                               material->shadowOffset.y(), material->shadowSoftness);
+    };
+    const auto lhs = key(this);
+    const auto rhs = key(static_cast<const DecorationMaterial*>(other));
+    return lhs == rhs ? 0 : (lhs < rhs ? -1 : 1);
+}
+
+qreal DecorationMaterial::shadowMargin() const {
+    return shadowSoftness + qMax(qAbs(shadowOffset.x()), qAbs(shadowOffset.y()));
+}
+
+} // namespace Pulse
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QSGMaterial>
+#include <QColor>
+#include <QPointF>
+#include <QSizeF>
+
+namespace Pulse {
+
+// Draws a complete window frame (drop shadow, rounded outline, focus
+// border, title bar and client background) in one quad. Coverage is
+// computed per fragment from a rounded-box signed distance, so corners
+// and borders cost no extra geometry or overdraw.
+class DecorationMaterial : public QSGMaterial {
+public:
+    DecorationMaterial();
+    
+    QSGMaterialType* type() const override;
+    QSGMaterialShader* createShader(QSGRendererInterface::RenderMode renderMode) const override;
+    int compare(const QSGMaterial* other) const override;
+    
+    // Frame size in item coordinates; the quad extends past it by shadowMargin()
+    QSizeF size;
+    qreal cornerRadius = 4;
+    qreal borderWidth = 1;
+    qreal titleBarHeight = 30;
+    
+    QColor borderColor = Qt::gray;
+    QColor titleBarColor = Qt::darkGray;
+    QColor clientColor = Qt::white;
+    
+    QColor shadowColor = QColor(0, 0, 0, 90);
+    QPointF shadowOffset = QPointF(0, 4);
+    qreal shadowSoftness = 12;
+    
+    // Space around the frame the quad must cover to fit the shadow
+    qreal shadowMargin() const;
+};
+
+} // namespace Pulse
@@ -0,0 +1,120 @@
+#include "EventBus.h"
+#include <QStringList>
+#include <QDebug>
+
+namespace Pulse {
+
+namespace {
+
+// Handlers publishing in response to each other cannot hold up a frame
+// for more than this many rounds; the rest goes to the next flush
+constexpr int kMaxPasses = 8;
+
+} // namespace
+
+EventBus* EventBus::instance() {
+    static EventBus instance;
+    return &instance;
+}
+
+EventBus::EventBus(QObject* parent)
+    : QObject(parent) {
+}
+
+EventBus::~EventBus() {
+}
+
+void EventBus::unsubscribe(const void* receiver) {
+    // Compacted at the end of the next delivery pass
+    for (const auto& channel : m_channels) {
+        channel->removeReceiver(receiver);
+    }
+}
+
+void EventBus::queued(ChannelBase* channel) {
+    if (!m_runs.empty() && m_runs.back().channel == channel) {
+        m_runs.back().count++;
+    } else {
+        m_runs.push_back({channel, 1});
+    }
+    
+    // Events published while delivering are picked up by the running flush
+    if (!m_flushing) {
+        scheduleFlush();
+    }
+}
+
+void EventBus::scheduleFlush() {
+    // Any thread
+    if (!m_flushScheduled.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &EventBus::flush, Qt::QueuedConnection);
+    }
+}
+
+void EventBus::flush() {
+    if (m_flushing) return;
+    
+    // Cleared before draining, so a post racing with it schedules again
+    m_flushScheduled.store(false, std::memory_order_release);
+    
+    for (const auto& channel : m_channels) {
+        const qsizetype drained = channel->drainInboxes();
+        if (drained == 0) continue;
+        
+        if (!m_runs.empty() && m_runs.back().channel == channel.get()) {
+            m_runs.back().count += drained;
+        } else {
+            m_runs.push_back({channel.get(), drained});
+        }
+    }
+    if (m_runs.empty()) return;
+    
+    PULSE_TRACE_SCOPE("events", "flush");
+    m_flushing = true;
+    
+    for (int pass = 0; pass < kMaxPasses && !m_runs.empty(); ++pass) {
+        m_delivering.swap(m_runs);
+        for (const auto& channel : m_channels) {
+            channel->beginPass();
+        }
+        for (const Run& run : m_delivering) {
+            run.channel->deliver(run.count);
+        }
+        for (const auto& channel : m_channels) {
+            channel->endPass();
+        }
+        m_delivering.clear();
+    }
+    
+    m_flushing = false;
+    if (!m_runs.empty()) {
+        qWarning() << "EventBus: events still being published after" << kMaxPasses
+                   << "delivery passes, continuing next flush";
+        scheduleFlush();
+    }
+}
+
+QVector<EventBus::Stats> EventBus::stats() const {
+    QVector<Stats> result;
+    result.reserve(int(m_channels.size()));
+    for (const auto& channel : m_channels) {
+        result.append(channel->stats);
+    }
+    return result;
+}
+
+QString EventBus::report() const {
+    QStringList lines;
+    for (const Stats& stats : this->stats()) {
+        const double averageMs = stats.delivered
+            ? stats.totalLatencyNs / double(stats.delivered) / 1e6 : 0.0;
+        lines << QStringLiteral("%1: %2 published, %3 delivered in %4 batches to %5 handlers, "
+                                "latency avg %6 ms, max %7 ms")
+            .arg(QLatin1String(stats.eventName))
+            .arg(stats.published).arg(stats.delivered).arg(stats.batches).arg(stats.handlers)
+            .arg(averageMs, 0, 'f', 3).arg(stats.maxLatencyNs / 1e6, 0, 'f', 3);
+    }
+    return lines.join('\n');
+}
+
+} // namespace Pulse
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "SpscQueue.h"
+#include "Tracer.h"
+
+namespace Pulse {
+
+// Typed, batched notifications between subsystems.
+//
+// An event is a plain struct naming itself with a string literal:
+//
+//     struct WindowAdded {
+//         static constexpr const char* eventName = "WindowAdded";
+//         Window* window;
+//     };
+//
+// Handlers are member functions bound at compile time, kept in one static
+// table per event type: publishing boxes nothing into QVariant and looks
+// nothing up by name. Events published on the GUI thread are queued and
+// delivered together by flush(), once per frame (or on the next event loop
+// turn when no frame is coming). Publish order is kept; consecutive events
+// of one type reach each handler as one batch. A handler taking no event
+// runs once per batch.
+//
+// Other threads publish through an Inbox, a lock-free single-producer
+// queue that flush() drains.
+class EventBus : public QObject {
+    Q_OBJECT
+    
+public:
+    struct Stats {
+        const char* eventName = nullptr;
+        int handlers = 0;
+        quint64 published = 0;
+        quint64 delivered = 0;
+        quint64 batches = 0;
+        qint64 totalLatencyNs = 0;      // publish to delivery
+        qint64 maxLatencyNs = 0;
+    };
+    
+    // Producer side for one event type on one thread
+    template<typename E, size_t Capacity>
+    class Inbox;
+    
+    // Singleton instance; lives on the GUI thread
+    static EventBus* instance();
+    
+    // GUI thread
+    template<typename E>
+    void publish(const E& event);
+    
+    // Method is void (Receiver::*)(const E&) or void (Receiver::*)().
+    // QObject receivers are unsubscribed when destroyed.
+    template<typename E, auto Method, typename Receiver>
+    void subscribe(Receiver* receiver);
+    
+    // Removes every handler of the receiver, for all event types
+    void unsubscribe(const void* receiver);
+    
+    // Owned by the bus; hand it to the producing thread
+    template<typename E, size_t Capacity = 1024>
+    Inbox<E, Capacity>* createInbox();
+    
+    // Delivers everything queued so far, including events published by
+    // handlers while delivering
+    void flush();
+    
+    QVector<Stats> stats() const;
+    Q_INVOKABLE QString report() const;
+    
+private:
+    explicit EventBus(QObject* parent = nullptr);
+    ~EventBus();
+    
+    class ChannelBase {
+    public:
+        virtual ~ChannelBase() = default;
+        
+        // Moves queued events aside; publishing during delivery queues anew
+        virtual void beginPass() = 0;
+        virtual void deliver(qsizetype count) = 0;
+        virtual void endPass() = 0;
+        
+        // Cross-thread events go to the end of the queue
+        virtual qsizetype drainInboxes() = 0;
+        virtual void removeReceiver(const void* receiver) = 0;
+        
+        Stats stats;
+    };
+    
+    template<typename E>
+    class Channel;
+    
+    // Consecutive events of one type
+    struct Run {
+        ChannelBase* channel;
+        qsizetype count;
+    };
+    
+    template<typename E>
+    Channel<E>& channel();
+    
+    void queued(ChannelBase* channel);
+    void scheduleFlush();
+    
+    // The per-type dispatch tables
+    template<typename E>
+    inline static Channel<E>* s_channel = nullptr;
+    
+    std::vector<std::unique_ptr<ChannelBase>> m_channels;
+    std::vector<Run> m_runs;
+    std::vector<Run> m_delivering;
+    std::atomic<bool> m_flushScheduled{false};
+    bool m_flushing = false;
+};
+
+template<typename E, size_t Capacity>
+class EventBus::Inbox {
+public:
+    // Producer thread; false when the queue is full and the event dropped
+    bool post(const E& event) {
+        if (!m_queue.push(Entry{event, Tracer::now()})) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_bus->scheduleFlush();
+        return true;
+    }
+    
+    quint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    
+private:
+    friend class EventBus;
+    
+    struct Entry {
+        E event;
+        qint64 postedAt;
+    };
+    
+    explicit Inbox(EventBus* bus)
+        : m_bus(bus) {
+    }
+    
+    EventBus* m_bus;
+    SpscQueue<Entry, Capacity> m_queue;
+    std::atomic<quint64> m_dropped{0};
+};
+
+template<typename E>
+class EventBus::Channel : public ChannelBase {
+public:
+    using Invoke = void (*)(void* receiver, const E* events, qsizetype count);
+    
+    struct Handler {
+        void* receiver;
+        Invoke invoke;
+    };
+    
+    // Inboxes of any capacity, drained through one function each
+    struct InboxSlot {
+        std::shared_ptr<void> inbox;
+        qsizetype (*drain)(void* inbox, Channel& channel);
+    };
+    
+    Channel() {
+        stats.eventName = E::eventName;
+    }
+    
+    void queue(const E& event, qint64 publishedAt) {
+        m_pending.push_back(event);
+        m_publishedAt.push_back(publishedAt);
+        stats.published++;
+    }
+    
+    void beginPass() override {
+        m_pending.swap(m_delivering);
+        m_publishedAt.swap(m_deliveringAt);
+        m_cursor = 0;
+    }
+    
+    void deliver(qsizetype count) override {
+        const E* events = m_delivering.data() + m_cursor;
+        
+        // By index: handlers may subscribe or unsubscribe while delivering
+        for (size_t i = 0; i < m_handlers.size(); ++i) {
+            const Handler handler = m_handlers[i];
+            if (handler.receiver) {
+                handler.invoke(handler.receiver, events, count);
+            }
+        }
+        
+        const qint64 now = Tracer::now();
+        for (qsizetype i = m_cursor; i < m_cursor + count; ++i) {
+            const qint64 latency = now - m_deliveringAt[i];
+            stats.totalLatencyNs += latency;
+            stats.maxLatencyNs = qMax(stats.maxLatencyNs, latency);
+        }
+        stats.delivered += count;
+        stats.batches++;
+        m_cursor += count;
+        PULSE_TRACE_COUNTER("events", E::eventName, qint64(stats.delivered));
+    }
+    
+    void endPass() override {
+        m_delivering.clear();
+        m_deliveringAt.clear();
+        
+        if (m_removedHandlers) {
+            m_removedHandlers = false;
+            m_handlers.erase(std::remove_if(m_handlers.begin(), m_handlers.end(),
+                                            [](const Handler& handler) { return !handler.receiver; }),
+                             m_handlers.end());
+            stats.handlers = int(m_handlers.size());
+        }
+    }
+    
+    qsizetype drainInboxes() override {
+        qsizetype drained = 0;
+        for (const InboxSlot& slot : m_inboxes) {
+            drained += slot.drain(slot.inbox.get(), *this);
+        }
+        return drained;
+    }
+    
+    void removeReceiver(const void* receiver) override {
+        for (Handler& handler : m_handlers) {
+            if (handler.receiver == receiver) {
+                handler.receiver = nullptr;
+                m_removedHandlers = true;
+            }
+        }
+    }
+    
+    void addHandler(void* receiver, Invoke invoke) {
+        m_handlers.push_back({receiver, invoke});
+        stats.handlers = int(m_handlers.size());
+    }
+    
+    void addInbox(std::shared_ptr<void> inbox, qsizetype (*drain)(void*, Channel&)) {
+        m_inboxes.push_back({std::move(inbox), drain});
+    }
+    
+private:
+    std::vector<Handler> m_handlers;
+    std::vector<InboxSlot> m_inboxes;
+    bool m_removedHandlers = false;
+    
+    // Filled by publish; swapped into the delivering pair per pass
+    std::vector<E> m_pending;
+    std::vector<qint64> m_publishedAt;
+    std::vector<E> m_delivering;
+    std::vector<qint64> m_deliveringAt;
+    qsizetype m_cursor = 0;
+};
+
+template<typename E>
+EventBus::Channel<E>& EventBus::channel() {
+    if (!s_channel<E>) {
+        auto channel = std::make_unique<Channel<E>>();
+        s_channel<E> = channel.get();
+        m_channels.push_back(std::move(channel));
+    }
+    return *s_channel<E>;
+}
+
+template<typename E>
+void EventBus::publish(const E& event) {
+    Q_ASSERT(QThread::currentThread() == thread());
+    Channel<E>& target = channel<E>();
+    target.queue(event, Tracer::now());
+    queued(&target);
+}
+
+template<typename E, auto Method, typename Receiver>
+void EventBus::subscribe(Receiver* receiver) {
+    Q_ASSERT(QThread::currentThread() == thread());
+    
+    auto invoke = [](void* target, const E* events, qsizetype count) {
+        Receiver* self = static_cast<Receiver*>(target);
+        if constexpr (std::is_invocable_v<decltype(Method), Receiver*, const E&>) {
+            for (qsizetype i = 0; i < count; ++i) {
+                (self->*Method)(events[i]);
+            }
+        } else {
+            static_assert(std::is_invocable_v<decltype(Method), Receiver*>,
+                          "Handlers take const E& or nothing");
+            Q_UNUSED(events)
+            Q_UNUSED(count)
+            (self->*Method)();
+        }
+    };
+    channel<E>().addHandler(receiver, invoke);
+    
+    if constexpr (std::is_base_of_v<QObject, Receiver>) {
+        connect(receiver, &QObject::destroyed, this, [this, receiver]() {
+            unsubscribe(receiver);
+        });
+    }
+}
+
+template<typename E, size_t Capacity>
+EventBus::Inbox<E, Capacity>* EventBus::createInbox() {
+    Q_ASSERT(QThread::currentThread() == thread());
+    
+    std::shared_ptr<Inbox<E, Capacity>> inbox(new Inbox<E, Capacity>(this));
+    channel<E>().addInbox(inbox, [](void* target, Channel<E>& channel) {
+        auto* self = static_cast<Inbox<E, Capacity>*>(target);
+        qsizetype drained = 0;
+        typename Inbox<E, Capacity>::Entry entry;
+        while (self->m_queue.pop(entry)) {
+            channel.queue(entry.event, entry.postedAt);
+            drained++;
+        }
+        return drained;
+    });
+    return inbox.get();
+}
+
+} // namespace Pulse
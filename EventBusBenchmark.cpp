@@ -0,0 +1,226 @@
+// Window event delivery benchmark: EventBus against signals and slots.
+//
+// Replays the same frames of window events through both paths. The signal
+// path is the one the bus replaced: the window manager emits one signal
+// per change, the compositor relays each to its own signal, and every
+// subscriber is connected to the relay. The bus path publishes typed
+// events and delivers them in one flush per frame, including the queued
+// flush call publishing schedules. Subscribers fold every event they see
+// into a checksum; the two paths must agree. Exits non-zero on a mismatch
+// or when the bus is slower than --min-speedup times the signal path.
+
+#include "EventBus.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <memory>
+#include <vector>
+
+namespace Pulse {
+
+namespace {
+
+// Stands in for Window; only its address is passed around
+struct Item {
+    quint64 id = 0;
+};
+
+struct ItemAdded {
+    static constexpr const char* eventName = "ItemAdded";
+    Item* item = nullptr;
+};
+
+struct ItemRemoved {
+    static constexpr const char* eventName = "ItemRemoved";
+    Item* item = nullptr;
+};
+
+struct ActiveItemChanged {
+    static constexpr const char* eventName = "ActiveItemChanged";
+    Item* item = nullptr;
+};
+
+enum class Kind {
+    Added,
+    Removed,
+    Active
+};
+
+quint64 fold(quint64 sum, const Item* item, Kind kind) {
+    return sum * 31 + item->id * 4 + quint64(kind);
+}
+
+} // namespace
+
+// Signal path: the window manager's signals
+class SignalSource : public QObject {
+    Q_OBJECT
+    
+signals:
+    void itemAdded(Pulse::Item* item);
+    void itemRemoved(Pulse::Item* item);
+    void activeItemChanged(Pulse::Item* item);
+};
+
+// Signal path: the compositor re-emitting each change
+class SignalRelay : public QObject {
+    Q_OBJECT
+    
+public:
+    explicit SignalRelay(SignalSource* source) {
+        connect(source, &SignalSource::itemAdded, this, &SignalRelay::itemAdded);
+        connect(source, &SignalSource::itemRemoved, this, &SignalRelay::itemRemoved);
+        connect(source, &SignalSource::activeItemChanged, this, &SignalRelay::activeItemChanged);
+    }
+    
+signals:
+    void itemAdded(Pulse::Item* item);
+    void itemRemoved(Pulse::Item* item);
+    void activeItemChanged(Pulse::Item* item);
+};
+
+class Subscriber : public QObject {
+    Q_OBJECT
+    
+public:
+    quint64 sum = 0;
+    
+    void connectTo(SignalRelay* relay) {
+        connect(relay, &SignalRelay::itemAdded, this, &Subscriber::added);
+        connect(relay, &SignalRelay::itemRemoved, this, &Subscriber::removed);
+        connect(relay, &SignalRelay::activeItemChanged, this, &Subscriber::activated);
+    }
+    
+    void subscribeTo(EventBus* bus) {
+        bus->subscribe<ItemAdded, &Subscriber::onAdded>(this);
+        bus->subscribe<ItemRemoved, &Subscriber::onRemoved>(this);
+        bus->subscribe<ActiveItemChanged, &Subscriber::onActivated>(this);
+    }
+    
+public slots:
+    void added(Pulse::Item* item) { sum = fold(sum, item, Kind::Added); }
+    void removed(Pulse::Item* item) { sum = fold(sum, item, Kind::Removed); }
+    void activated(Pulse::Item* item) { sum = fold(sum, item, Kind::Active); }
+    
+private:
+    void onAdded(const ItemAdded& event) { added(event.item); }
+    void onRemoved(const ItemRemoved& event) { removed(event.item); }
+    void onActivated(const ActiveItemChanged& event) { activated(event.item); }
+};
+
+namespace {
+
+// One frame's changes: windows open and take focus, older ones close
+std::vector<std::pair<Kind, Item*>> buildFrame(std::vector<Item>& items, int burst) {
+    std::vector<std::pair<Kind, Item*>> frame;
+    for (int i = 0; i < burst; ++i) {
+        Item* item = &items[i % items.size()];
+        switch (i % 3) {
+        case 0: frame.emplace_back(Kind::Added, item); break;
+        case 1: frame.emplace_back(Kind::Active, item); break;
+        default: frame.emplace_back(Kind::Removed, item); break;
+        }
+    }
+    return frame;
+}
+
+quint64 checksum(const std::vector<std::unique_ptr<Subscriber>>& subscribers) {
+    quint64 sum = 0;
+    for (const auto& subscriber : subscribers) {
+        sum ^= subscriber->sum;
+        subscriber->sum = 0;
+    }
+    return sum;
+}
+
+// Nanoseconds per event and subscriber
+double perDelivery(qint64 ns, int frames, size_t events, size_t subscribers) {
+    return double(ns) / (double(frames) * events * subscribers);
+}
+
+} // namespace
+
+} // namespace Pulse
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("pulse-event-bus-benchmark");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Window event delivery: EventBus against relayed signals and slots");
+    parser.addHelpOption();
+    parser.addOption({"frames", "Frames of events delivered per path", "count", "20000"});
+    parser.addOption({"burst", "Events per frame", "count", "6"});
+    parser.addOption({"subscribers", "Subscribers to every event", "count", "8"});
+    parser.addOption({"min-speedup", "Required speedup of the bus over signals", "ratio", "1"});
+    parser.process(app);
+    
+    const int frames = qMax(1, parser.value("frames").toInt());
+    const int burst = qMax(1, parser.value("burst").toInt());
+    const int subscriberCount = qMax(1, parser.value("subscribers").toInt());
+    
+    std::vector<Pulse::Item> items(64);
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i].id = i + 1;
+    }
+    const auto frame = Pulse::buildFrame(items, burst);
+    
+    Pulse::SignalSource source;
+    Pulse::SignalRelay relay(&source);
+    Pulse::EventBus* bus = Pulse::EventBus::instance();
+    
+    std::vector<std::unique_ptr<Pulse::Subscriber>> subscribers;
+    for (int i = 0; i < subscriberCount; ++i) {
+        auto subscriber = std::make_unique<Pulse::Subscriber>();
+        subscriber->connectTo(&relay);
+        subscriber->subscribeTo(bus);
+        subscribers.push_back(std::move(subscriber));
+    }
+    
+    // Each path runs with the other's handlers attached but idle
+    QElapsedTimer timer;
+    timer.start();
+    for (int f = 0; f < frames; ++f) {
+        for (const auto& [kind, item] : frame) {
+            switch (kind) {
+            case Pulse::Kind::Added: emit source.itemAdded(item); break;
+            case Pulse::Kind::Removed: emit source.itemRemoved(item); break;
+            case Pulse::Kind::Active: emit source.activeItemChanged(item); break;
+            }
+        }
+    }
+    const qint64 signalNs = timer.nsecsElapsed();
+    const quint64 signalSum = Pulse::checksum(subscribers);
+    
+    timer.restart();
+    for (int f = 0; f < frames; ++f) {
+        for (const auto& [kind, item] : frame) {
+            switch (kind) {
+            case Pulse::Kind::Added: bus->publish(Pulse::ItemAdded{item}); break;
+            case Pulse::Kind::Removed: bus->publish(Pulse::ItemRemoved{item}); break;
+            case Pulse::Kind::Active: bus->publish(Pulse::ActiveItemChanged{item}); break;
+            }
+        }
+        bus->flush();
+        QCoreApplication::sendPostedEvents(bus, QEvent::MetaCall);
+    }
+    const qint64 busNs = timer.nsecsElapsed();
+    const quint64 busSum = Pulse::checksum(subscribers);
+    
+    const double signalPer = Pulse::perDelivery(signalNs, frames, frame.size(), subscribers.size());
+    const double busPer = Pulse::perDelivery(busNs, frames, frame.size(), subscribers.size());
+    const double speedup = signalPer / qMax(busPer, 0.001);
+    const double required = parser.value("min-speedup").toDouble();
+    
+    qInfo().noquote() << QString("%1 frames of %2 events, %3 subscribers")
+        .arg(frames).arg(frame.size()).arg(subscribers.size());
+    qInfo().noquote() << QString("signals %1 ns, bus %2 ns per delivery, %3x (required %4x)%5")
+        .arg(signalPer, 0, 'f', 1).arg(busPer, 0, 'f', 1).arg(speedup, 0, 'f', 2).arg(required)
+        .arg(signalSum == busSum ? "" : " MISMATCH");
+    qInfo().noquote() << bus->report();
+    
+    return signalSum == busSum && speedup >= required ? 0 : 1;
+}
+
+#include "EventBusBenchmark.moc"
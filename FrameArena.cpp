@@ -0,0 +1,62 @@
+#include "FrameArena.h"
+#include "Tracer.h"
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+namespace Pulse {
+
+namespace {
+
+constexpr std::size_t kInitialBytes = 64 * 1024;
+
+// One outlier frame should not pin this much for the process lifetime
+constexpr std::size_t kMaxBytes = 4 * 1024 * 1024;
+
+} // namespace
+
+FrameArena* FrameArena::instance() {
+    static FrameArena arena;
+    return &arena;
+}
+
+FrameArena::FrameArena()
+    : m_buffer(kInitialBytes) {
+    m_resource.emplace(m_buffer.data(), m_buffer.size(), &m_overflow);
+}
+
+void FrameArena::reset() {
+    m_resource->release();
+    if (m_overflow.spilled == 0) return;
+    
+    const std::size_t spilled = std::exchange(m_overflow.spilled, 0);
+    if (m_buffer.size() >= kMaxBytes) return;
+    
+    // Room for everything the last frame needed, with headroom
+    std::size_t size = m_buffer.size();
+    while (size < m_buffer.size() + spilled * 2 && size < kMaxBytes) {
+        size *= 2;
+    }
+    size = std::min(size, kMaxBytes);
+    qDebug() << "Frame arena spilled" << spilled << "bytes, growing to" << size;
+    
+    m_resource.reset();
+    m_buffer = std::vector<std::byte>(size);
+    m_resource.emplace(m_buffer.data(), m_buffer.size(), &m_overflow);
+    PULSE_TRACE_COUNTER("frame", "arenaBytes", qint64(size));
+}
+
+void* FrameArena::OverflowResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    spilled += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void FrameArena::OverflowResource::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+bool FrameArena::OverflowResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+} // namespace Pulse
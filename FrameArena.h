@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace Pulse {
+
+// Monotonic allocator for GUI-thread data that dies with the current
+// frame: scratch lists, sort buffers, snapshots consumed in place.
+// Allocation is a pointer bump; nothing is freed until reset() rewinds
+// the whole buffer, at frame end and whenever the GUI thread goes idle.
+// A frame that overflows the buffer spills to the heap once; the buffer
+// then grows so later frames do not, up to a cap past which oversized
+// frames keep spilling instead.
+//
+// Nothing allocated here may be kept past the frame or handed to
+// another thread.
+class FrameArena {
+public:
+    template<typename T>
+    using Vector = std::pmr::vector<T>;
+    
+    // GUI thread
+    static FrameArena* instance();
+    
+    std::pmr::memory_resource* resource() { return &*m_resource; }
+    
+    template<typename T>
+    Vector<T> vector(std::size_t reserve = 0) {
+        Vector<T> result(resource());
+        result.reserve(reserve);
+        return result;
+    }
+    
+    // Called by the compositor after each frame, and before the GUI
+    // thread's event loop blocks so work between frames is freed too
+    void reset();
+    
+    std::size_t capacity() const { return m_buffer.size(); }
+    
+private:
+    FrameArena();
+    
+    // Upstream for overflow; remembers how much spilled this frame
+    class OverflowResource : public std::pmr::memory_resource {
+    public:
+        std::size_t spilled = 0;
+        
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+    
+    std::vector<std::byte> m_buffer;
+    OverflowResource m_overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+};
+
+} // namespace Pulse
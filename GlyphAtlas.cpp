@@ -0,0 +1,138 @@
+#include "GlyphAtlas.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+namespace Pulse {
+
+namespace {
+
+constexpr int kAtlasWidth = 512;
+constexpr int kMaxAtlasHeight = 2048;
+
+QString fontKey(const QRawFont& font) {
+    return font.familyName() + QLatin1Char('/') + font.styleName();
+}
+
+} // namespace
+
+GlyphAtlas::GlyphAtlas()
+    : m_image(kAtlasWidth, 256, QImage::Format_Alpha8) {
+    m_image.fill(0);
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::glyph(const QRawFont& font, quint32 glyphIndex) {
+    const QPair<QString, quint32> key(fontKey(font), glyphIndex);
+    auto it = m_glyphs.constFind(key);
+    if (it == m_glyphs.constEnd()) {
+        it = m_glyphs.insert(key, rasterize(font, glyphIndex));
+    }
+    return *it;
+}
+
+void GlyphAtlas::prewarm(const QRawFont& font, const QString& characters) {
+    for (quint32 glyphIndex : font.glyphIndexesForString(characters)) {
+        glyph(font, glyphIndex);
+    }
+}
+
+GlyphAtlas::Glyph GlyphAtlas::rasterize(const QRawFont& font, quint32 glyphIndex) {
+    Glyph glyph;
+    
+    QRawFont base(font);
+    base.setPixelSize(kBaseSize);
+    const QPainterPath path = base.pathForGlyph(glyphIndex);
+    if (path.isEmpty()) {
+        return glyph;
+    }
+    
+    const QRect cell = path.boundingRect().toAlignedRect().adjusted(-kSpread, -kSpread, kSpread, kSpread);
+    if (!allocate(cell.size(), &glyph.atlasRect)) {
+        qWarning() << "Glyph atlas full, dropping glyph" << glyphIndex;
+        return glyph;
+    }
+    glyph.offset = cell.topLeft();
+    glyph.valid = true;
+    
+    QImage coverage(cell.size(), QImage::Format_Alpha8);
+    coverage.fill(0);
+    {
+        QPainter painter(&coverage);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.translate(-cell.topLeft());
+        painter.fillPath(path, Qt::black);
+    }
+    
+    // Distance to the nearest pixel on the other side of the outline,
+    // searched within the spread. Edge pixels use their coverage directly.
+    const int width = cell.width();
+    const int height = cell.height();
+    auto inside = [&](int x, int y) {
+        return coverage.constScanLine(y)[x] >= 128;
+    };
+    
+    for (int y = 0; y < height; ++y) {
+        quint8* target = m_image.scanLine(glyph.atlasRect.y() + y) + glyph.atlasRect.x();
+        for (int x = 0; x < width; ++x) {
+            const int alpha = coverage.constScanLine(y)[x];
+            float distance;
+            if (alpha > 0 && alpha < 255) {
+                distance = alpha / 255.0f - 0.5f;
+            } else {
+                const bool in = alpha >= 128;
+                float nearest = kSpread;
+                for (int dy = -kSpread; dy <= kSpread; ++dy) {
+                    const int sy = y + dy;
+                    if (sy < 0 || sy >= height) continue;
+                    for (int dx = -kSpread; dx <= kSpread; ++dx) {
+                        const int sx = x + dx;
+                        if (sx < 0 || sx >= width || inside(sx, sy) == in) continue;
+                        nearest = qMin(nearest, std::sqrt(float(dx * dx + dy * dy)));
+                    }
+                }
+                distance = in ? nearest - 0.5f : 0.5f - nearest;
+            }
+            
+            // 0.5 is the outline; kSpread pixels either side map to 0..1
+            const float value = qBound(0.0f, 0.5f + distance / (2.0f * kSpread), 1.0f);
+            target[x] = quint8(std::lround(value * 255.0f));
+        }
+    }
+    
+    m_generation++;
+    return glyph;
+}
+
+bool GlyphAtlas::allocate(const QSize& size, QRect* rect) {
+    if (size.width() > m_image.width()) {
+        return false;
+    }
+    
+    if (m_shelfX + size.width() > m_image.width()) {
+        m_shelfY += m_shelfHeight;
+        m_shelfX = 0;
+        m_shelfHeight = 0;
+    }
+    
+    // Grow downwards; existing rects stay valid because the top is kept
+    while (m_shelfY + size.height() > m_image.height()) {
+        if (m_image.height() * 2 > kMaxAtlasHeight) {
+            return false;
+        }
+        QImage grown(m_image.width(), m_image.height() * 2, m_image.format());
+        grown.fill(0);
+        for (int y = 0; y < m_image.height(); ++y) {
+            std::memcpy(grown.scanLine(y), m_image.constScanLine(y), m_image.bytesPerLine());
+        }
+        m_image = grown;
+    }
+    
+    *rect = QRect(QPoint(m_shelfX, m_shelfY), size);
+    m_shelfX += size.width();
+    m_shelfHeight = qMax(m_shelfHeight, size.height());
+    return true;
+}
+
+} // namespace Pulse
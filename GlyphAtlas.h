@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QPointF>
+#include <QRawFont>
+#include <QRect>
+
+namespace Pulse {
+
+// Signed-distance-field glyph atlas shared by every title. Glyphs are
+// rendered once at a base size and scaled in the shader, so one atlas entry
+// serves all font sizes. The image is a single Alpha8 channel, uploaded
+// as an R8 texture. Not thread-safe; TitleTextCache serialises access.
+class GlyphAtlas {
+public:
+    struct Glyph {
+        QRect atlasRect;        // in atlas pixels, including the distance spread
+        QPointF offset;         // atlasRect's top-left relative to the pen, at base size
+        bool valid = false;     // false for blank glyphs (spaces) and when full
+    };
+    
+    static constexpr int kBaseSize = 32;
+    static constexpr int kSpread = 4;
+    
+    GlyphAtlas();
+    
+    const Glyph& glyph(const QRawFont& font, quint32 glyphIndex);
+    void prewarm(const QRawFont& font, const QString& characters);
+    
+    const QImage& image() const { return m_image; }
+    int count() const { return m_glyphs.size(); }
+    
+    // Bumped whenever image() changes
+    quint64 generation() const { return m_generation; }
+    
+private:
+    Glyph rasterize(const QRawFont& font, quint32 glyphIndex);
+    bool allocate(const QSize& size, QRect* rect);
+    
+    QImage m_image;
+    QHash<QPair<QString, quint32>, Glyph> m_glyphs;
+    quint64 m_generation = 1;
+    
+    // Shelf packer
+    int m_shelfX = 0;
+    int m_shelfY = 0;
+    int m_shelfHeight = 0;
+};
+
+} // namespace Pulse
@@ -0,0 +1,245 @@
+// Steady-state allocation check for diagnostics builds.
+//
+// Runs the compositor on an offscreen output and starts itself again as a
+// Wayland client (--client) with one static window. Once the window is
+// mapped and animations have settled, the harness keeps the scene
+// rendering by requesting a new frame after every swap, and reads
+// AllocationCounter::lastFrame() for each one: nothing changes on screen,
+// so no frame may allocate. Counted are all malloc-family and aligned
+// allocations through glibc (see AllocationCounter.h); direct mmap is
+// not. Exits non-zero when any measured frame allocated, and skips when
+// allocation counting is not compiled in.
+
+#include "Compositor.h"
+#include "AllocationCounter.h"
+#include <QCommandLineParser>
+#include <QGuiApplication>
+#include <QPainter>
+#include <QProcess>
+#include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QRasterWindow>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QWaylandOutput>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QDebug>
+#include <algorithm>
+
+namespace Pulse {
+
+namespace {
+
+// Lets the new window's decoration and map animations finish
+constexpr int kSettleMs = 1000;
+
+constexpr int kFrameTimeoutMs = 1000;
+
+constexpr int kOutputWidth = 1280;
+constexpr int kOutputHeight = 800;
+
+// Client side: one solid window that never redraws on its own
+class ClientWindow : public QRasterWindow {
+public:
+    ClientWindow() {
+        setTitle("idle-allocations");
+        resize(400, 300);
+    }
+    
+protected:
+    void paintEvent(QPaintEvent* event) override {
+        Q_UNUSED(event)
+        QPainter(this).fillRect(QRect(QPoint(), size()), QColor("#208080"));
+    }
+};
+
+int runClient(QGuiApplication& app) {
+    ClientWindow window;
+    window.show();
+    return app.exec();
+}
+
+} // namespace
+
+class IdleAllocationTest : public QObject {
+public:
+    IdleAllocationTest(int warmupFrames, int frames)
+        : m_warmupFrames(warmupFrames)
+        , m_frames(frames) {
+        m_timeout.setSingleShot(true);
+        m_timeout.setInterval(kFrameTimeoutMs);
+        connect(&m_timeout, &QTimer::timeout, this, [this]() {
+            qWarning() << "Idle allocation test: no frame rendered within" << kFrameTimeoutMs << "ms";
+            finish(2);
+        });
+    }
+    
+    ~IdleAllocationTest() {
+        if (m_client.state() != QProcess::NotRunning) {
+            m_client.terminate();
+            if (!m_client.waitForFinished(2000)) {
+                m_client.kill();
+            }
+        }
+    }
+    
+    bool start() {
+        m_compositor.setSocketName(QByteArray("pulse-idle-") + QByteArray::number(QCoreApplication::applicationPid()));
+        
+        m_engine.setInitialProperties({{"compositor", QVariant::fromValue(&m_compositor)}});
+        m_engine.load(QUrl(QStringLiteral("qrc:/qt/qml/Pulse/CompositorView.qml")));
+        m_window = m_engine.rootObjects().isEmpty() ? nullptr
+            : qobject_cast<QQuickWindow*>(m_engine.rootObjects().constFirst());
+        if (!m_window) {
+            qWarning() << "Idle allocation test: failed to load CompositorView";
+            return false;
+        }
+        m_window->resize(kOutputWidth, kOutputHeight);
+        
+        m_compositor.create();
+        auto* output = new QWaylandOutput(&m_compositor, m_window);
+        output->setSizeFollowsWindow(true);
+        
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        environment.insert("WAYLAND_DISPLAY", QString::fromUtf8(m_compositor.socketName()));
+        environment.insert("QT_QPA_PLATFORM", "wayland");
+        environment.insert("QT_WAYLAND_DISABLE_WINDOWDECORATION", "1");
+        m_client.setProcessEnvironment(environment);
+        m_client.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        m_client.start(QCoreApplication::applicationFilePath(), {"--client"});
+        
+        waitForClientWindow(QDeadlineTimer(10000));
+        return true;
+    }
+    
+    int exitCode() const { return m_exitCode; }
+    
+private:
+    void waitForClientWindow(const QDeadlineTimer& deadline) {
+        if (!m_compositor.windowManager()->windows().isEmpty()) {
+            QTimer::singleShot(kSettleMs, this, [this]() { startFrames(); });
+            return;
+        }
+        
+        if (deadline.hasExpired() || m_client.state() == QProcess::NotRunning) {
+            qWarning() << "Idle allocation test: client window did not appear";
+            finish(2);
+            return;
+        }
+        QTimer::singleShot(50, this, [this, deadline]() { waitForClientWindow(deadline); });
+    }
+    
+    void startFrames() {
+        // Connected after the compositor's own endFrame, so each call sees
+        // the frame it just closed
+        connect(m_window, &QQuickWindow::frameSwapped, this, [this]() { onFrame(); });
+        requestFrame();
+    }
+    
+    void requestFrame() {
+        // The request and the timer are the harness's, not compositor work
+        m_window->update();
+        m_timeout.start();
+        AllocationCounter::rebase();
+    }
+    
+    void onFrame() {
+        if (m_seen++ >= m_warmupFrames) {
+            const quint64 allocations = AllocationCounter::lastFrame();
+            m_measured++;
+            m_total += allocations;
+            m_worst = std::max(m_worst, allocations);
+            if (allocations > 0) {
+                m_allocatingFrames++;
+            }
+        }
+        
+        if (m_measured >= m_frames) {
+            m_timeout.stop();
+            report();
+            return;
+        }
+        requestFrame();
+    }
+    
+    void report() {
+        const bool failed = m_allocatingFrames > 0;
+        qInfo().noquote() << QString("%1 idle frames, %2 with heap allocations, %3 allocations (worst frame %4)%5")
+            .arg(m_measured).arg(m_allocatingFrames).arg(m_total).arg(m_worst)
+            .arg(failed ? " FAILED" : "");
+        if (failed) {
+            qInfo().noquote() << "Allocations:" << AllocationCounter::report();
+        }
+        finish(failed ? 1 : 0);
+    }
+    
+    void finish(int exitCode) {
+        m_exitCode = exitCode;
+        QCoreApplication::exit(exitCode);
+    }
+    
+    const int m_warmupFrames;
+    const int m_frames;
+    
+    Compositor m_compositor;
+    QQmlApplicationEngine m_engine;
+    QQuickWindow* m_window = nullptr;
+    QProcess m_client;
+    QTimer m_timeout;
+    
+    int m_seen = 0;
+    int m_measured = 0;
+    int m_allocatingFrames = 0;
+    quint64 m_total = 0;
+    quint64 m_worst = 0;
+    int m_exitCode = 0;
+};
+
+} // namespace Pulse
+
+// The Pulse module is linked statically
+Q_IMPORT_QML_PLUGIN(PulsePlugin)
+
+int main(int argc, char *argv[]) {
+    const bool client = std::any_of(argv + 1, argv + argc, [](const char* arg) {
+        return qstrcmp(arg, "--client") == 0;
+    });
+    
+    // Keeps the window manager's session file out of the user's data
+    if (!client) {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+    
+    // Headless by default
+    if (!client && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("pulse-idle-allocation-test");
+    
+    if (client) {
+        return Pulse::runClient(app);
+    }
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Checks that idle compositor frames make no heap allocations");
+    parser.addHelpOption();
+    parser.addOption({"client", "Run as the test client (started by the harness)"});
+    parser.addOption({"warmup", "Frames rendered before measuring", "count", "60"});
+    parser.addOption({"frames", "Idle frames measured", "count", "300"});
+    parser.process(app);
+    
+    if (!Pulse::AllocationCounter::available()) {
+        qInfo() << "Skipped:" << Pulse::AllocationCounter::report();
+        return 0;
+    }
+    
+    Pulse::IdleAllocationTest test(qMax(0, parser.value("warmup").toInt()),
+                                   qMax(1, parser.value("frames").toInt()));
+    if (!test.start()) {
+        return 2;
+    }
+    
+    return app.exec();
+}
@@ -0,0 +1,239 @@
+#include "InputDispatcher.h"
+#include "Compositor.h"
+#include "EventBus.h"
+#include "Tracer.h"
+#include <QQuickWindow>
+#include <QWaylandSeat>
+#include <QDebug>
+#include <linux/input-event-codes.h>
+
+namespace Pulse {
+
+namespace {
+
+Qt::MouseButton toQtButton(quint32 code) {
+    switch (code) {
+    case BTN_LEFT: return Qt::LeftButton;
+    case BTN_RIGHT: return Qt::RightButton;
+    case BTN_MIDDLE: return Qt::MiddleButton;
+    case BTN_SIDE: return Qt::BackButton;
+    case BTN_EXTRA: return Qt::ForwardButton;
+    default: return Qt::NoButton;
+    }
+}
+
+} // namespace
+
+InputDispatcher::InputDispatcher(Compositor* compositor)
+    : QObject(compositor)
+    , m_compositor(compositor) {
+    
+    WindowManager* windowManager = m_compositor->windowManager();
+    EventBus* bus = EventBus::instance();
+    bus->subscribe<WindowAdded, &InputDispatcher::onWindowAdded>(this);
+    bus->subscribe<WindowRemoved, &InputDispatcher::schedulePublish>(this);
+    bus->subscribe<ActiveWindowChanged, &InputDispatcher::schedulePublish>(this);
+    connect(windowManager, &WindowManager::currentWorkspaceChanged,
+            this, &InputDispatcher::schedulePublish);
+    
+    // Geometry changes in a burst (re-tile) publish one snapshot
+    m_publishTimer.setSingleShot(true);
+    m_publishTimer.setInterval(0);
+    connect(&m_publishTimer, &QTimer::timeout, this, &InputDispatcher::publishGeometry);
+    
+    m_statsTimer.setInterval(1000);
+    connect(&m_statsTimer, &QTimer::timeout, this, &InputDispatcher::statsChanged);
+    
+    m_thread.onEventsQueued = [this]() {
+        if (!m_drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+            QMetaObject::invokeMethod(this, &InputDispatcher::drain, Qt::QueuedConnection);
+        }
+    };
+    m_thread.onCursorMoved = [this]() {
+        requestCursorFrame();
+    };
+    connect(&m_thread, &QThread::finished, this, [this]() {
+        emit runningChanged(false);
+    });
+}
+
+InputDispatcher::~InputDispatcher() {
+    stop();
+}
+
+bool InputDispatcher::start(QQuickWindow* window) {
+    if (running() || !window) {
+        return running();
+    }
+    
+    m_window = window;
+    connect(window, &QObject::destroyed, this, &InputDispatcher::stop);
+    publishGeometry();
+    
+    m_thread.start(QThread::TimeCriticalPriority);
+    m_statsTimer.start();
+    emit runningChanged(true);
+    return true;
+}
+
+bool InputDispatcher::startInjected(QQuickWindow* window) {
+    if (!running()) {
+        m_thread.setDevicesEnabled(false);
+    }
+    return start(window);
+}
+
+void InputDispatcher::stop() {
+    m_thread.stop();
+    m_statsTimer.stop();
+}
+
+double InputDispatcher::averageLatencyUs() const {
+    return m_eventCount ? (double(m_totalLatencyNs) / m_eventCount) / 1000.0 : 0.0;
+}
+
+void InputDispatcher::requestCursorFrame() {
+    // Input thread. At most one notification is queued however fast the
+    // pointer moves; the slot reads the latest position. A call queued
+    // to this object only goes away with it, so the flag cannot stick.
+    if (m_cursorFramePending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this]() {
+        m_cursorFramePending.store(false, std::memory_order_release);
+        emit cursorMoved();
+    }, Qt::QueuedConnection);
+}
+
+void InputDispatcher::onWindowAdded(const WindowAdded& event) {
+    Window* window = event.window;
+    connect(window, &Window::geometryChanged, this, &InputDispatcher::schedulePublish);
+    connect(window, &Window::stateChanged, this, &InputDispatcher::schedulePublish);
+    connect(window, &Window::workspaceChanged, this, &InputDispatcher::schedulePublish);
+    schedulePublish();
+}
+
+void InputDispatcher::schedulePublish() {
+    if (!m_publishTimer.isActive()) {
+        m_publishTimer.start();
+    }
+}
+
+void InputDispatcher::publishGeometry() {
+    PULSE_TRACE_SCOPE("input", "publishGeometry");
+    
+    GeometrySnapshot& snapshot = m_thread.geometryForWriting();
+    snapshot.windows.clear();
+    snapshot.output = m_window ? QRect(0, 0, m_window->width(), m_window->height())
+                               : QRect(0, 0, 1920, 1080);
+    
+    const QList<Window*>& windows = m_compositor->windowManager()->currentWorkspaceObject()->windows();
+    for (auto it = windows.crbegin(); it != windows.crend(); ++it) {
+        Window* window = *it;
+        if (window->state() == Window::State::Minimized) continue;
+        snapshot.windows.append({window->id(), window->geometry(), window->clientArea()});
+    }
+    
+    m_thread.publishGeometry();
+}
+
+void InputDispatcher::drain() {
+    PULSE_TRACE_SCOPE("input", "drain");
+    
+    // Clear first so events queued while draining schedule another pass
+    m_drainScheduled.store(false, std::memory_order_release);
+    
+    InputEvent event;
+    while (m_thread.queue().pop(event)) {
+        const qint64 latency = Tracer::now() - event.enqueuedAt;
+        m_eventCount++;
+        m_totalLatencyNs += latency;
+        m_maxLatencyNs = qMax(m_maxLatencyNs, latency);
+        PULSE_TRACE_COUNTER("input", "queueLatencyUs", latency / 1000);
+        
+        dispatch(event);
+    }
+}
+
+void InputDispatcher::clickTitleButton(Window* window, InputRegion button) {
+    // Same actions as the buttons in WindowItem.qml
+    WindowManager* windowManager = m_compositor->windowManager();
+    switch (button) {
+    case InputRegion::MinimizeButton: windowManager->minimizeWindow(window); break;
+    case InputRegion::MaximizeButton: windowManager->toggleMaximize(window); break;
+    case InputRegion::CloseButton: windowManager->closeWindow(window); break;
+    default: break;
+    }
+}
+
+void InputDispatcher::dispatch(const InputEvent& event) {
+    WindowManager* windowManager = m_compositor->windowManager();
+    QWaylandSeat* seat = m_compositor->defaultSeat();
+    Window* window = event.windowId ? windowManager->windowById(event.windowId) : nullptr;
+    
+    switch (event.type) {
+    case InputEvent::Type::PointerMotion:
+        if (m_moveWindow) {
+            if (Window* moving = windowManager->windowById(m_moveWindow)) {
+                const QPoint delta = (event.position - m_lastPosition).toPoint();
+                if (!delta.isNull()) {
+                    windowManager->moveWindow(moving, delta);
+                    m_lastPosition += delta;
+                }
+            }
+        } else if (window && event.region == InputRegion::Client) {
+            seat->sendMouseMoveEvent(window->view(), event.localPosition, event.position);
+        }
+        break;
+        
+    case InputEvent::Type::PointerButton: {
+        const Qt::MouseButton button = toQtButton(event.code);
+        if (event.pressed) {
+            if (window) {
+                windowManager->setActiveWindow(window);
+                seat->setKeyboardFocus(window->surface());
+                if (event.region != InputRegion::Client && button == Qt::LeftButton) {
+                    if (event.region == InputRegion::TitleBar) {
+                        m_moveWindow = window->id();
+                        m_lastPosition = event.position;
+                    } else {
+                        m_pressedButton = event.region;
+                    }
+                    break;
+                }
+            }
+            seat->sendMousePressEvent(button);
+        } else {
+            if (m_moveWindow && button == Qt::LeftButton) {
+                m_moveWindow = 0;
+                break;
+            }
+            if (m_pressedButton != InputRegion::None && button == Qt::LeftButton) {
+                if (window && event.region == m_pressedButton) {
+                    clickTitleButton(window, m_pressedButton);
+                }
+                m_pressedButton = InputRegion::None;
+                break;
+            }
+            seat->sendMouseReleaseEvent(button);
+        }
+        break;
+    }
+    
+    case InputEvent::Type::PointerAxis:
+        // libinput reports ~15 units per wheel click, Qt expects 120
+        seat->sendMouseWheelEvent(Qt::Vertical, int(-event.axis * 8));
+        break;
+        
+    case InputEvent::Type::Key:
+        // QWaylandSeat takes XKB keycodes (evdev + 8)
+        if (event.pressed) {
+            seat->sendKeyPressEvent(event.code + 8);
+        } else {
+            seat->sendKeyReleaseEvent(event.code + 8);
+        }
+        break;
+    }
+}
+
+} // namespace Pulse
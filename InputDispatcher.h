@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+#include "InputThread.h"
+#include "WindowEvents.h"
+
+class QQuickWindow;
+
+namespace Pulse {
+
+class Compositor;
+class Window;
+
+// GUI-side end of the input pipeline: publishes window geometry to the
+// input thread, drains its queue and delivers events to Wayland clients
+class InputDispatcher : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by the compositor")
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    Q_PROPERTY(QPointF cursorPosition READ cursorPosition NOTIFY cursorMoved)
+    Q_PROPERTY(double averageLatencyUs READ averageLatencyUs NOTIFY statsChanged)
+    Q_PROPERTY(double maxLatencyUs READ maxLatencyUs NOTIFY statsChanged)
+    Q_PROPERTY(qint64 eventCount READ eventCount NOTIFY statsChanged)
+    Q_PROPERTY(qint64 droppedEvents READ droppedEvents NOTIFY statsChanged)
+    
+public:
+    explicit InputDispatcher(Compositor* compositor);
+    ~InputDispatcher();
+    
+    bool start(QQuickWindow* window);
+    void stop();
+    bool running() const { return m_thread.isRunning(); }
+    
+    // Tests and benchmarks: runs the input thread without opening devices.
+    // Injected events take the whole device path, hit test to dispatch.
+    bool startInjected(QQuickWindow* window);
+    void injectMotion(const QPointF& position) { m_thread.injectMotion(position); }
+    void injectButton(quint32 code, bool pressed) { m_thread.injectButton(code, pressed); }
+    
+    // Any thread
+    QPointF cursorPosition() const { return m_thread.cursorPosition(); }
+    
+    // Queueing latency (input thread enqueue to GUI dequeue)
+    double averageLatencyUs() const;
+    double maxLatencyUs() const { return m_maxLatencyNs / 1000.0; }
+    qint64 eventCount() const { return m_eventCount; }
+    qint64 droppedEvents() const { return qint64(m_thread.droppedEvents()); }
+    
+signals:
+    void runningChanged(bool running);
+    void statsChanged();
+    
+    // Coalesced: once per GUI thread pass, whatever the motion rate
+    void cursorMoved();
+    
+private slots:
+    void drain();
+    void schedulePublish();
+    void publishGeometry();
+    
+private:
+    void onWindowAdded(const WindowAdded& event);
+    void dispatch(const InputEvent& event);
+    void clickTitleButton(Window* window, InputRegion button);
+    void requestCursorFrame();
+    
+    Compositor* m_compositor;
+    InputThread m_thread;
+    QPointer<QQuickWindow> m_window;
+    
+    // Set from the input thread while a cursorMoved() is queued
+    std::atomic<bool> m_cursorFramePending{false};
+    
+    std::atomic<bool> m_drainScheduled{false};
+    QTimer m_publishTimer;
+    QTimer m_statsTimer;
+    
+    // Interactive move started by a title bar press
+    quint32 m_moveWindow = 0;
+    QPointF m_lastPosition;
+    
+    // Title bar button under the press; acts on release over it
+    InputRegion m_pressedButton = InputRegion::None;
+    
+    qint64 m_eventCount = 0;
+    qint64 m_totalLatencyNs = 0;
+    qint64 m_maxLatencyNs = 0;
+};
+
+} // namespace Pulse
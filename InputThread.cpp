@@ -0,0 +1,346 @@
+#include "InputThread.h"
+#include "Tracer.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include <cerrno>
+#include <fcntl.h>
+#include <libinput.h>
+#include <libudev.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace Pulse {
+
+namespace {
+
+constexpr int kBacklogRetryMs = 2;
+
+int openRestricted(const char* path, int flags, void* userData) {
+    Q_UNUSED(userData)
+    int fd = ::open(path, flags | O_CLOEXEC);
+    return fd < 0 ? -errno : fd;
+}
+
+void closeRestricted(int fd, void* userData) {
+    Q_UNUSED(userData)
+    ::close(fd);
+}
+
+const libinput_interface kInterface = {
+    openRestricted,
+    closeRestricted
+};
+
+// Title bar controls as laid out in WindowItem.qml: square buttons in a
+// row at the right edge, centred in the bar
+constexpr int kTitleButtonSize = 20;
+constexpr int kTitleButtonSpacing = 5;
+
+// The buttons sit on top of the title bar, so they are tested first
+InputRegion regionAt(const GeometrySnapshot::Entry& entry, const QPoint& point) {
+    if (entry.client.contains(point)) {
+        return InputRegion::Client;
+    }
+    
+    constexpr InputRegion kButtons[] = {
+        InputRegion::CloseButton, InputRegion::MaximizeButton, InputRegion::MinimizeButton
+    };
+    const int top = entry.frame.top() + (entry.client.top() - entry.frame.top() - kTitleButtonSize) / 2;
+    int left = entry.frame.left() + entry.frame.width() - kTitleButtonSpacing - kTitleButtonSize;
+    for (InputRegion button : kButtons) {
+        if (QRect(left, top, kTitleButtonSize, kTitleButtonSize).contains(point)) {
+            return button;
+        }
+        left -= kTitleButtonSize + kTitleButtonSpacing;
+    }
+    return InputRegion::TitleBar;
+}
+
+bool isTitleButton(InputRegion region) {
+    return region == InputRegion::MinimizeButton || region == InputRegion::MaximizeButton ||
+           region == InputRegion::CloseButton;
+}
+
+quint64 packPosition(const QPointF& position) {
+    const quint32 x = static_cast<quint32>(qint32(position.x() * 256.0));
+    const quint32 y = static_cast<quint32>(qint32(position.y() * 256.0));
+    return (quint64(x) << 32) | y;
+}
+
+} // namespace
+
+InputThread::InputThread(QObject* parent)
+    : QThread(parent)
+    , m_wakeFd(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    , m_injectFd(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    setObjectName("Input");
+}
+
+InputThread::~InputThread() {
+    stop();
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+    if (m_injectFd >= 0) {
+        ::close(m_injectFd);
+    }
+}
+
+void InputThread::stop() {
+    if (!isRunning()) return;
+    
+    requestInterruption();
+    quint64 one = 1;
+    if (::write(m_wakeFd, &one, sizeof(one)) < 0) {
+        qWarning() << "Failed to wake input thread";
+    }
+    wait();
+}
+
+void InputThread::injectMotion(const QPointF& position) {
+    InputEvent event;
+    event.type = InputEvent::Type::PointerMotion;
+    event.position = position;
+    inject(event);
+}
+
+void InputThread::injectButton(quint32 code, bool pressed) {
+    InputEvent event;
+    event.type = InputEvent::Type::PointerButton;
+    event.code = code;
+    event.pressed = pressed;
+    inject(event);
+}
+
+void InputThread::inject(const InputEvent& event) {
+    {
+        QMutexLocker locker(&m_injectedMutex);
+        m_injected.push_back(event);
+    }
+    quint64 one = 1;
+    if (::write(m_injectFd, &one, sizeof(one)) < 0) {
+        qWarning() << "Failed to wake input thread";
+    }
+}
+
+QPointF InputThread::cursorPosition() const {
+    const quint64 packed = m_cursor.load(std::memory_order_relaxed);
+    return QPointF(qint32(packed >> 32) / 256.0, qint32(packed & 0xffffffffu) / 256.0);
+}
+
+void InputThread::setCursor(const QPointF& position) {
+    const QRect output = m_geometry.read().output;
+    QPointF clamped = position;
+    if (!output.isEmpty()) {
+        clamped.setX(qBound<qreal>(output.left(), position.x(), output.right()));
+        clamped.setY(qBound<qreal>(output.top(), position.y(), output.bottom()));
+    }
+    m_position = clamped;
+    m_cursor.store(packPosition(clamped), std::memory_order_relaxed);
+    
+    if (onCursorMoved) {
+        onCursorMoved();
+    }
+}
+
+void InputThread::run() {
+    udev* udevContext = nullptr;
+    libinput* context = nullptr;
+    
+    if (m_devicesEnabled) {
+        udevContext = udev_new();
+        context = udevContext ? libinput_udev_create_context(&kInterface, nullptr, udevContext) : nullptr;
+        
+        if (!context || libinput_udev_assign_seat(context, "seat0") != 0) {
+            qWarning() << "Input thread: libinput unavailable, falling back to toolkit input";
+            if (context) libinput_unref(context);
+            if (udevContext) udev_unref(udevContext);
+            return;
+        }
+    }
+    
+    qDebug() << (context ? "Input thread started" : "Input thread started for injected input only");
+    
+    // poll() skips the negative fd when no devices are read
+    pollfd fds[3] = {
+        { context ? libinput_get_fd(context) : -1, POLLIN, 0 },
+        { m_wakeFd, POLLIN, 0 },
+        { m_injectFd, POLLIN, 0 }
+    };
+    
+    while (!isInterruptionRequested()) {
+        // Retry held-back events even when no new input arrives
+        const int timeout = m_backlog.empty() ? -1 : kBacklogRetryMs;
+        if (::poll(fds, 3, timeout) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        
+        flushBacklog();
+        if (fds[2].revents & POLLIN) {
+            handleInjected();
+        }
+        if (context) {
+            libinput_dispatch(context);
+            while (libinput_event* event = libinput_get_event(context)) {
+                handleEvent(event);
+                libinput_event_destroy(event);
+            }
+        }
+    }
+    
+    if (context) libinput_unref(context);
+    if (udevContext) udev_unref(udevContext);
+    qDebug() << "Input thread stopped";
+}
+
+void InputThread::handleEvent(libinput_event* event) {
+    PULSE_TRACE_SCOPE("input", "handleEvent");
+    InputEvent routed;
+    
+    switch (libinput_event_get_type(event)) {
+    case LIBINPUT_EVENT_POINTER_MOTION: {
+        libinput_event_pointer* pointer = libinput_event_get_pointer_event(event);
+        setCursor(m_position + QPointF(libinput_event_pointer_get_dx(pointer),
+                                       libinput_event_pointer_get_dy(pointer)));
+        routed.type = InputEvent::Type::PointerMotion;
+        break;
+    }
+    case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE: {
+        libinput_event_pointer* pointer = libinput_event_get_pointer_event(event);
+        const QRect output = m_geometry.read().output;
+        setCursor(QPointF(output.x() + libinput_event_pointer_get_absolute_x_transformed(pointer, output.width()),
+                          output.y() + libinput_event_pointer_get_absolute_y_transformed(pointer, output.height())));
+        routed.type = InputEvent::Type::PointerMotion;
+        break;
+    }
+    case LIBINPUT_EVENT_POINTER_BUTTON: {
+        libinput_event_pointer* pointer = libinput_event_get_pointer_event(event);
+        routed.type = InputEvent::Type::PointerButton;
+        routed.code = libinput_event_pointer_get_button(pointer);
+        routed.pressed = libinput_event_pointer_get_button_state(pointer) == LIBINPUT_BUTTON_STATE_PRESSED;
+        break;
+    }
+    case LIBINPUT_EVENT_POINTER_AXIS: {
+        libinput_event_pointer* pointer = libinput_event_get_pointer_event(event);
+        if (!libinput_event_pointer_has_axis(pointer, LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL)) {
+            return;
+        }
+        routed.type = InputEvent::Type::PointerAxis;
+        routed.axis = libinput_event_pointer_get_axis_value(pointer, LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL);
+        break;
+    }
+    case LIBINPUT_EVENT_KEYBOARD_KEY: {
+        libinput_event_keyboard* keyboard = libinput_event_get_keyboard_event(event);
+        routed.type = InputEvent::Type::Key;
+        routed.code = libinput_event_keyboard_get_key(keyboard);
+        routed.pressed = libinput_event_keyboard_get_key_state(keyboard) == LIBINPUT_KEY_STATE_PRESSED;
+        break;
+    }
+    default:
+        return;
+    }
+    
+    route(routed);
+}
+
+void InputThread::handleInjected() {
+    quint64 count;
+    if (::read(m_injectFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        qWarning() << "Failed to read injected input";
+    }
+    
+    std::deque<InputEvent> events;
+    {
+        QMutexLocker locker(&m_injectedMutex);
+        events.swap(m_injected);
+    }
+    for (InputEvent& event : events) {
+        if (event.type == InputEvent::Type::PointerMotion) {
+            setCursor(event.position);
+        }
+        route(event);
+    }
+}
+
+void InputThread::route(InputEvent& routed) {
+    routed.position = m_position;
+    if (routed.type != InputEvent::Type::Key) {
+        hitTest(routed);
+    }
+    
+    // Implicit pointer grab: everything between press and release goes to
+    // the window that received the press
+    if (routed.type == InputEvent::Type::PointerButton) {
+        if (routed.pressed && m_buttonsDown++ == 0) {
+            m_grabWindow = routed.windowId;
+            m_grabRegion = routed.region;
+        } else if (!routed.pressed && m_buttonsDown > 0 && --m_buttonsDown == 0) {
+            m_grabWindow = 0;
+            m_grabRegion = InputRegion::None;
+        }
+    }
+    
+    enqueue(routed);
+}
+
+void InputThread::hitTest(InputEvent& event) {
+    const GeometrySnapshot& snapshot = m_geometry.read();
+    const QPoint point = event.position.toPoint();
+    
+    for (const GeometrySnapshot::Entry& entry : snapshot.windows) {
+        const bool grabbed = m_grabWindow && entry.windowId == m_grabWindow;
+        if (grabbed || (!m_grabWindow && entry.frame.contains(point))) {
+            event.windowId = entry.windowId;
+            event.region = grabbed ? m_grabRegion : regionAt(entry, point);
+            
+            // A button clicks only if released over it, as in QML
+            if (grabbed && isTitleButton(m_grabRegion) && regionAt(entry, point) != m_grabRegion) {
+                event.region = InputRegion::None;
+            }
+            event.localPosition = event.position - QPointF(entry.client.topLeft());
+            return;
+        }
+    }
+}
+
+void InputThread::enqueue(InputEvent& event) {
+    event.enqueuedAt = Tracer::now();
+    
+    // Held-back events go first so order is kept
+    flushBacklog();
+    if (m_backlog.empty() && m_queue.push(event)) {
+        if (onEventsQueued) {
+            onEventsQueued();
+        }
+        return;
+    }
+    
+    // GUI thread is behind. Motion is superseded by the cursor position;
+    // buttons, keys and scrolling must arrive, or keys stick and grabs leak
+    if (event.type == InputEvent::Type::PointerMotion) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_backlog.push_back(event);
+    if (onEventsQueued) {
+        onEventsQueued();
+    }
+}
+
+void InputThread::flushBacklog() {
+    bool pushed = false;
+    while (!m_backlog.empty() && m_queue.push(m_backlog.front())) {
+        m_backlog.pop_front();
+        pushed = true;
+    }
+    if (pushed && onEventsQueued) {
+        onEventsQueued();
+    }
+}
+
+} // namespace Pulse
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <QMutex>
+#include <QThread>
+#include <QPointF>
+#include <QRect>
+#include <QVector>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+struct libinput_event;
+
+namespace Pulse {
+
+// What sits under the pointer, as seen by the input thread
+enum class InputRegion : quint8 {
+    None,
+    TitleBar,
+    MinimizeButton,
+    MaximizeButton,
+    CloseButton,
+    Client
+};
+
+struct InputEvent {
+    enum class Type : quint8 {
+        PointerMotion,
+        PointerButton,
+        PointerAxis,
+        Key
+    };
+    
+    Type type = Type::PointerMotion;
+    InputRegion region = InputRegion::None;
+    bool pressed = false;
+    quint32 windowId = 0;          // hit-tested (or grabbed) window, 0 for none
+    quint32 code = 0;              // evdev button/key code
+    QPointF position;              // global cursor position
+    QPointF localPosition;         // relative to the window's client area
+    double axis = 0.0;             // vertical scroll amount
+    qint64 enqueuedAt = 0;         // Tracer::now() when queued
+};
+
+// Geometry of the visible windows, published from the GUI thread
+struct GeometrySnapshot {
+    struct Entry {
+        quint32 windowId;
+        QRect frame;               // including decorations
+        QRect client;
+    };
+    
+    QVector<Entry> windows;        // top-most first
+    QRect output;
+};
+
+// Reads libinput on its own thread, moves the cursor, hit-tests against the
+// latest geometry snapshot and hands routed events to the GUI thread
+class InputThread : public QThread {
+    Q_OBJECT
+    
+public:
+    using EventQueue = SpscQueue<InputEvent, 1024>;
+    
+    explicit InputThread(QObject* parent = nullptr);
+    ~InputThread();
+    
+    void stop();
+    
+    // Before start(): route injected events only, without opening devices
+    void setDevicesEnabled(bool enabled) { m_devicesEnabled = enabled; }
+    
+    // Any thread: synthetic pointer input, routed on the input thread
+    // exactly like device events (cursor, hit test, grab, queue)
+    void injectMotion(const QPointF& position);
+    void injectButton(quint32 code, bool pressed);
+    
+    // GUI thread: fill, then publish
+    GeometrySnapshot& geometryForWriting() { return m_geometry.writeBuffer(); }
+    void publishGeometry() { m_geometry.publish(); }
+    
+    // Consumer side (GUI thread)
+    EventQueue& queue() { return m_queue; }
+    // Pointer motion only; other events wait on the input thread
+    quint64 droppedEvents() const { return m_dropped.load(std::memory_order_relaxed); }
+    
+    // Latest cursor position; safe from any thread
+    QPointF cursorPosition() const;
+    
+    // Called from the input thread after events were queued / the cursor moved
+    std::function<void()> onEventsQueued;
+    std::function<void()> onCursorMoved;
+    
+protected:
+    void run() override;
+    
+private:
+    void handleEvent(libinput_event* event);
+    void handleInjected();
+    void inject(const InputEvent& event);
+    void route(InputEvent& event);
+    void hitTest(InputEvent& event);
+    void enqueue(InputEvent& event);
+    void flushBacklog();
+    void setCursor(const QPointF& position);
+    
+    EventQueue m_queue;
+    TripleBuffer<GeometrySnapshot> m_geometry;
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_cursor{0};    // packed x/y in 1/256 px
+    int m_wakeFd = -1;
+    int m_injectFd = -1;
+    bool m_devicesEnabled = true;
+    
+    QMutex m_injectedMutex;
+    std::deque<InputEvent> m_injected;
+    
+    // Input-thread state
+    std::deque<InputEvent> m_backlog;   // non-motion events the queue had no room for
+    QPointF m_position;
+    quint32 m_grabWindow = 0;
+    InputRegion m_grabRegion = InputRegion::None;
+    int m_buttonsDown = 0;
+};
+
+} // namespace Pulse
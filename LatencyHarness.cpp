@@ -0,0 +1,513 @@
+// Input-to-photon latency harness.
+//
+// Runs the compositor on an offscreen output and starts itself again as a
+// Wayland client (--client) with two windows. Synthetic pointer input is
+// injected into the compositor's input thread with a timestamp and takes
+// the device path from there (hit test, queue, dispatch); every following frame
+// reads back one probe pixel where the change must show up, right after
+// the scene graph has rendered it. The first frame whose probe differs
+// from the pre-input frame ends the sample.
+//
+// Scenarios: window drag (title bar press and move), focus change (click
+// on the other window's title bar) and client commit (the client resizes
+// itself, the frame follows the new buffer). Exits non-zero when a p95 is
+// over its threshold or a sample never shows up.
+
+#include "Compositor.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QPainter>
+#include <QProcess>
+#include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QRasterWindow>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QWaylandOutput>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <linux/input-event-codes.h>
+#include <unistd.h>
+
+namespace Pulse {
+
+namespace {
+
+constexpr int kSampleTimeoutMs = 1000;
+
+// Lets decoration and position animations finish between samples
+constexpr int kSettleMs = 250;
+
+constexpr int kOutputWidth = 1280;
+constexpr int kOutputHeight = 800;
+
+// Below the control panel, far enough apart that drags and resizes never
+// make the windows overlap
+const QRect kPlacementA(40, 420, 400, 300);
+const QRect kPlacementB(600, 420, 400, 300);
+
+// Client side: solid windows that resize on request from stdin
+class ClientWindow : public QRasterWindow {
+public:
+    ClientWindow(const QString& title, const QColor& color)
+        : m_color(color) {
+        setTitle(title);
+        resize(kPlacementA.size());
+    }
+    
+protected:
+    void paintEvent(QPaintEvent* event) override {
+        Q_UNUSED(event)
+        QPainter(this).fillRect(QRect(QPoint(), size()), m_color);
+    }
+    
+private:
+    QColor m_color;
+};
+
+int runClient(QGuiApplication& app) {
+    ClientWindow a("latency-a", QColor("#208080"));
+    ClientWindow b("latency-b", QColor("#802080"));
+    a.show();
+    b.show();
+    
+    // "resize <a|b> <dw>"; the harness closing stdin ends the client
+    QFile input;
+    input.open(stdin, QIODevice::ReadOnly);
+    QSocketNotifier notifier(STDIN_FILENO, QSocketNotifier::Read);
+    QObject::connect(&notifier, &QSocketNotifier::activated, &app, [&]() {
+        const QByteArray line = input.readLine().trimmed();
+        if (line.isEmpty() && input.atEnd()) {
+            app.quit();
+            return;
+        }
+        const QList<QByteArray> parts = line.split(' ');
+        if (parts.size() == 3 && parts[0] == "resize") {
+            ClientWindow& window = parts[1] == "a" ? a : b;
+            window.resize(window.width() + parts[2].toInt(), window.height());
+        }
+    });
+    
+    return app.exec();
+}
+
+struct Stats {
+    int samples = 0;
+    int missed = 0;
+    double min = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+Stats summarize(QVector<double> latencies, int missed) {
+    Stats stats;
+    stats.samples = latencies.size();
+    stats.missed = missed;
+    if (latencies.isEmpty()) return stats;
+    
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        const int rank = int(std::ceil(p * latencies.size())) - 1;
+        return latencies[qBound(0, rank, int(latencies.size()) - 1)];
+    };
+    stats.min = latencies.first();
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    stats.max = latencies.last();
+    return stats;
+}
+
+} // namespace
+
+class LatencyHarness : public QObject {
+public:
+    enum class Scenario {
+        Drag,
+        Focus,
+        Commit
+    };
+    
+    struct Thresholds {
+        double dragMs = 50;
+        double focusMs = 50;
+        double commitMs = 100;
+        int maxMissed = 0;
+    };
+    
+    LatencyHarness(int samples, const Thresholds& thresholds)
+        : m_samples(samples)
+        , m_thresholds(thresholds) {
+        m_timeout.setSingleShot(true);
+        m_timeout.setInterval(kSampleTimeoutMs);
+        connect(&m_timeout, &QTimer::timeout, this, [this]() { onTimeout(); });
+    }
+    
+    ~LatencyHarness() {
+        if (m_client.state() != QProcess::NotRunning) {
+            m_client.closeWriteChannel();
+            if (!m_client.waitForFinished(2000)) {
+                m_client.kill();
+            }
+        }
+    }
+    
+    bool start() {
+        m_clock.start();
+        m_compositor.setSocketName(QByteArray("pulse-latency-") + QByteArray::number(QCoreApplication::applicationPid()));
+        
+        m_engine.setInitialProperties({{"compositor", QVariant::fromValue(&m_compositor)}});
+        m_engine.load(QUrl(QStringLiteral("qrc:/qt/qml/Pulse/CompositorView.qml")));
+        m_window = m_engine.rootObjects().isEmpty() ? nullptr
+            : qobject_cast<QQuickWindow*>(m_engine.rootObjects().constFirst());
+        if (!m_window) {
+            qWarning() << "Latency harness: failed to load CompositorView";
+            return false;
+        }
+        m_window->resize(kOutputWidth, kOutputHeight);
+        
+        m_compositor.create();
+        auto* output = new QWaylandOutput(&m_compositor, m_window);
+        output->setSizeFollowsWindow(true);
+        
+        // No devices are read; the samples inject their own input
+        if (!m_compositor.input()->startInjected(m_window)) {
+            qWarning() << "Latency harness: input thread did not start";
+            return false;
+        }
+        
+        // Render thread: read the probe right after the scene is drawn,
+        // stamp it once the frame has been handed to the output
+        connect(m_window, &QQuickWindow::afterRendering, this, [this]() { readProbe(); },
+                Qt::DirectConnection);
+        connect(m_window, &QQuickWindow::afterFrameEnd, this, [this]() { frameEnded(); },
+                Qt::DirectConnection);
+        
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        environment.insert("WAYLAND_DISPLAY", QString::fromUtf8(m_compositor.socketName()));
+        environment.insert("QT_QPA_PLATFORM", "wayland");
+        environment.insert("QT_WAYLAND_DISABLE_WINDOWDECORATION", "1");
+        environment.remove("QSG_RHI_BACKEND");
+        m_client.setProcessEnvironment(environment);
+        m_client.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        m_client.start(QCoreApplication::applicationFilePath(), {"--client"});
+        
+        waitForClientWindows(QDeadlineTimer(10000));
+        return true;
+    }
+    
+    int exitCode() const { return m_exitCode; }
+    
+private:
+    struct ScenarioRun {
+        Scenario scenario;
+        const char* name;
+        double thresholdMs;
+        QVector<double> latencies;
+        int missed = 0;
+    };
+    
+    enum class Phase {
+        Idle,
+        Baseline,
+        Waiting
+    };
+    
+    Window* windowTitled(const QString& title) const {
+        for (Window* window : m_compositor.windowManager()->windows()) {
+            if (window->title() == title) return window;
+        }
+        return nullptr;
+    }
+    
+    void waitForClientWindows(const QDeadlineTimer& deadline) {
+        m_windowA = windowTitled("latency-a");
+        m_windowB = windowTitled("latency-b");
+        if (m_windowA && m_windowB) {
+            m_windowA->requestGeometry(kPlacementA);
+            m_windowB->requestGeometry(kPlacementB);
+            m_runs = {
+                {Scenario::Drag, "drag", m_thresholds.dragMs, {}},
+                {Scenario::Focus, "focus", m_thresholds.focusMs, {}},
+                {Scenario::Commit, "commit", m_thresholds.commitMs, {}}
+            };
+            
+            // Drags need the dragged window focused already, so the press
+            // itself changes nothing on screen
+            m_compositor.windowManager()->setActiveWindow(m_windowA);
+            QTimer::singleShot(kSettleMs * 4, this, [this]() { startSample(); });
+            return;
+        }
+        
+        if (deadline.hasExpired() || m_client.state() == QProcess::NotRunning) {
+            qWarning() << "Latency harness: client windows did not appear";
+            finish(2);
+            return;
+        }
+        QTimer::singleShot(50, this, [this, deadline]() { waitForClientWindows(deadline); });
+    }
+    
+    void startSample() {
+        ScenarioRun& run = m_runs[m_run];
+        Window* target = m_windowA;
+        const bool even = m_sample % 2 == 0;
+        
+        switch (run.scenario) {
+        case Scenario::Drag:
+            // Left border column: any horizontal move changes it
+            m_probe = QPoint(target->geometry().x(), target->geometry().y() + 15);
+            break;
+        case Scenario::Focus:
+            // Clicking A then B and so on; the clicked title bar recolors
+            target = even ? m_windowA : m_windowB;
+            m_probe = target->geometry().topLeft() + QPoint(5, 15);
+            if (m_sample == 0) {
+                m_compositor.windowManager()->setActiveWindow(m_windowB);
+                QTimer::singleShot(kSettleMs, this, [this]() { armBaseline(); });
+                return;
+            }
+            break;
+        case Scenario::Commit:
+            // Right border column: grows into the title bar or out of it
+            m_probe = QPoint(target->geometry().right(), target->geometry().y() + 15);
+            break;
+        }
+        armBaseline();
+    }
+    
+    void armBaseline() {
+        m_phase = Phase::Baseline;
+        m_probePacked.store((quint64(quint32(m_probe.x())) << 32) | quint32(m_probe.y()),
+                            std::memory_order_relaxed);
+        m_probeArmed.store(true, std::memory_order_release);
+        m_timeout.start();
+        m_window->update();
+    }
+    
+    void inject() {
+        ScenarioRun& run = m_runs[m_run];
+        const bool even = m_sample % 2 == 0;
+        m_t0 = m_clock.nsecsElapsed();
+        
+        switch (run.scenario) {
+        case Scenario::Drag: {
+            const QRect frame = m_windowA->geometry();
+            const QPointF press(frame.center().x(), frame.y() + 5);
+            const qreal dx = even ? 40 : -40;
+            InputDispatcher* input = m_compositor.input();
+            input->injectMotion(press);
+            input->injectButton(BTN_LEFT, true);
+            for (int step = 1; step <= 4; ++step) {
+                input->injectMotion(press + QPointF(dx * step / 4, 0));
+            }
+            input->injectButton(BTN_LEFT, false);
+            break;
+        }
+        case Scenario::Focus: {
+            Window* target = even ? m_windowA : m_windowB;
+            const QPointF press(target->geometry().center().x(), target->geometry().y() + 5);
+            InputDispatcher* input = m_compositor.input();
+            input->injectMotion(press);
+            input->injectButton(BTN_LEFT, true);
+            input->injectButton(BTN_LEFT, false);
+            break;
+        }
+        case Scenario::Commit:
+            m_client.write(even ? "resize a 20\n" : "resize a -20\n");
+            break;
+        }
+    }
+    
+    void readProbe() {
+        // Render thread
+        if (!m_probeArmed.load(std::memory_order_acquire)) return;
+        
+        const quint64 packed = m_probePacked.load(std::memory_order_relaxed);
+        const qreal dpr = m_window->effectiveDevicePixelRatio();
+        const int x = int(qint32(packed >> 32) * dpr);
+        const int y = int(m_window->height() * dpr) - 1 - int(qint32(packed & 0xffffffffu) * dpr);
+        
+        // Flushes the scene graph's recorded commands so the read sees them
+        m_window->beginExternalCommands();
+        uchar rgba[4] = {0, 0, 0, 0};
+        if (QOpenGLContext* context = QOpenGLContext::currentContext()) {
+            QOpenGLFunctions* gl = context->functions();
+            gl->glBindFramebuffer(GL_FRAMEBUFFER, context->defaultFramebufferObject());
+            gl->glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+        }
+        m_window->endExternalCommands();
+        
+        m_framePixel = qRgba(rgba[0], rgba[1], rgba[2], rgba[3]);
+        m_frameRead = true;
+    }
+    
+    void frameEnded() {
+        // Render thread
+        if (!m_frameRead) return;
+        m_frameRead = false;
+        
+        const qint64 presented = m_clock.nsecsElapsed();
+        const QRgb pixel = m_framePixel;
+        QMetaObject::invokeMethod(this, [this, presented, pixel]() {
+            onFrame(presented, pixel);
+        }, Qt::QueuedConnection);
+    }
+    
+    void onFrame(qint64 presented, QRgb pixel) {
+        if (m_phase == Phase::Baseline) {
+            m_baseline = pixel;
+            m_phase = Phase::Waiting;
+            inject();
+            return;
+        }
+        
+        // Frames synced before the input cannot contain it, and their
+        // probe still matches the baseline
+        if (m_phase != Phase::Waiting || presented <= m_t0 || pixel == m_baseline) {
+            return;
+        }
+        
+        m_runs[m_run].latencies.append((presented - m_t0) / 1e6);
+        endSample();
+    }
+    
+    void onTimeout() {
+        if (m_phase == Phase::Baseline) {
+            qWarning() << "Latency harness: no frames rendered";
+            finish(2);
+            return;
+        }
+        if (m_phase == Phase::Waiting) {
+            m_runs[m_run].missed++;
+            endSample();
+        }
+    }
+    
+    void endSample() {
+        m_probeArmed.store(false, std::memory_order_release);
+        m_phase = Phase::Idle;
+        m_timeout.stop();
+        
+        if (++m_sample >= m_samples) {
+            m_sample = 0;
+            if (++m_run >= m_runs.size()) {
+                report();
+                return;
+            }
+        }
+        QTimer::singleShot(kSettleMs, this, [this]() { startSample(); });
+    }
+    
+    void report() {
+        int exitCode = 0;
+        for (const ScenarioRun& run : std::as_const(m_runs)) {
+            const Stats stats = summarize(run.latencies, run.missed);
+            const bool failed = stats.p95 > run.thresholdMs || stats.missed > m_thresholds.maxMissed;
+            qInfo().noquote() << QString("%1: n=%2 missed=%3 min=%4 p50=%5 p95=%6 p99=%7 max=%8 ms (p95 limit %9)%10")
+                .arg(run.name, -6).arg(stats.samples).arg(stats.missed)
+                .arg(stats.min, 0, 'f', 2).arg(stats.p50, 0, 'f', 2).arg(stats.p95, 0, 'f', 2)
+                .arg(stats.p99, 0, 'f', 2).arg(stats.max, 0, 'f', 2).arg(run.thresholdMs)
+                .arg(failed ? " FAILED" : "");
+            if (failed) exitCode = 1;
+        }
+        finish(exitCode);
+    }
+    
+    void finish(int exitCode) {
+        m_exitCode = exitCode;
+        QCoreApplication::exit(exitCode);
+    }
+    
+    const int m_samples;
+    const Thresholds m_thresholds;
+    
+    Compositor m_compositor;
+    QQmlApplicationEngine m_engine;
+    QQuickWindow* m_window = nullptr;
+    QProcess m_client;
+    QElapsedTimer m_clock;
+    QTimer m_timeout;
+    
+    Window* m_windowA = nullptr;
+    Window* m_windowB = nullptr;
+    
+    QVector<ScenarioRun> m_runs;
+    int m_run = 0;
+    int m_sample = 0;
+    Phase m_phase = Phase::Idle;
+    QPoint m_probe;
+    QRgb m_baseline = 0;
+    qint64 m_t0 = 0;
+    int m_exitCode = 0;
+    
+    // Shared with the render thread
+    std::atomic<bool> m_probeArmed{false};
+    std::atomic<quint64> m_probePacked{0};
+    
+    // Render thread only
+    QRgb m_framePixel = 0;
+    bool m_frameRead = false;
+};
+
+} // namespace Pulse
+
+// The Pulse module is linked statically
+Q_IMPORT_QML_PLUGIN(PulsePlugin)
+
+int main(int argc, char *argv[]) {
+    const bool client = std::any_of(argv + 1, argv + argc, [](const char* arg) {
+        return qstrcmp(arg, "--client") == 0;
+    });
+    
+    if (!client) {
+        // Keeps the window manager's session file out of the user's data
+        QStandardPaths::setTestModeEnabled(true);
+        
+        // Headless by default; the probe readback needs OpenGL
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
+    }
+    
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("pulse-latency-test");
+    
+    if (client) {
+        return Pulse::runClient(app);
+    }
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Input-to-photon latency harness for the Pulse compositor");
+    parser.addHelpOption();
+    parser.addOption({"client", "Run as the test client (started by the harness)"});
+    parser.addOption({"samples", "Samples per scenario", "count", "50"});
+    parser.addOption({"max-p95-drag-ms", "Window drag p95 limit", "ms", "50"});
+    parser.addOption({"max-p95-focus-ms", "Focus change p95 limit", "ms", "50"});
+    parser.addOption({"max-p95-commit-ms", "Client commit p95 limit", "ms", "100"});
+    parser.addOption({"max-missed", "Samples per scenario allowed to time out", "count", "0"});
+    parser.process(app);
+    
+    Pulse::LatencyHarness::Thresholds thresholds;
+    thresholds.dragMs = parser.value("max-p95-drag-ms").toDouble();
+    thresholds.focusMs = parser.value("max-p95-focus-ms").toDouble();
+    thresholds.commitMs = parser.value("max-p95-commit-ms").toDouble();
+    thresholds.maxMissed = parser.value("max-missed").toInt();
+    
+    Pulse::LatencyHarness harness(qMax(1, parser.value("samples").toInt()), thresholds);
+    if (!harness.start()) {
+        return 2;
+    }
+    
+    return app.exec();
+}
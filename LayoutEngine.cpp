@@ -0,0 +1,151 @@
+#include "LayoutEngine.h"
+#include "Tracer.h"
+#include <QFutureWatcher>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDebug>
+
+namespace Pulse {
+
+namespace {
+
+void tile(const LayoutSnapshot& snapshot, LayoutResult& result) {
+    const int count = snapshot.windows.size();
+    if (count == 0) return;
+    
+    // Simple 2-column tiling
+    const int columns = qMin(2, count);
+    const int rows = (count + columns - 1) / columns;
+    const int colWidth = snapshot.output.width() / columns;
+    const int rowHeight = snapshot.output.height() / rows;
+    
+    for (int i = 0; i < count; ++i) {
+        const int col = i % columns;
+        const int row = i / columns;
+        result.geometries.append({snapshot.windows[i].windowId,
+                                  QRect(snapshot.output.x() + col * colWidth,
+                                        snapshot.output.y() + row * rowHeight,
+                                        colWidth - 10,
+                                        rowHeight - 10)});
+    }
+}
+
+void arrange(const LayoutSnapshot& snapshot, LayoutResult& result) {
+    // Simple vertical arrangement
+    int y = 50;
+    for (const LayoutSnapshot::Entry& entry : snapshot.windows) {
+        QRect geometry = entry.geometry;
+        geometry.moveTopLeft(QPoint(50, y));
+        result.geometries.append({entry.windowId, geometry});
+        y += geometry.height() + 20;
+    }
+}
+
+void cascade(const LayoutSnapshot& snapshot, LayoutResult& result) {
+    int offset = 30;
+    for (const LayoutSnapshot::Entry& entry : snapshot.windows) {
+        QRect geometry = entry.geometry;
+        geometry.moveTopLeft(QPoint(offset, offset));
+        result.geometries.append({entry.windowId, geometry});
+        offset += 30;
+    }
+}
+
+} // namespace
+
+LayoutEngine::LayoutEngine(QObject* parent)
+    : QObject(parent) {
+    // Passes of different workspaces may overlap; one pass never needs more
+    m_pool.setObjectName("Layout");
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+}
+
+LayoutEngine::~LayoutEngine() {
+    m_pool.waitForDone();
+}
+
+void LayoutEngine::request(Algorithm algorithm, const LayoutSnapshot& snapshot) {
+    WorkspaceState& state = m_workspaces[snapshot.workspace];
+    const Job job{algorithm, snapshot, ++state.generation};
+    
+    if (state.running) {
+        state.pending = job;
+        state.hasPending = true;
+        return;
+    }
+    start(job);
+}
+
+std::optional<LayoutEngine::Algorithm> LayoutEngine::invalidate(int workspace) {
+    auto it = m_workspaces.find(workspace);
+    if (it == m_workspaces.end()) return std::nullopt;
+    
+    std::optional<Algorithm> dropped;
+    if (it->hasPending) {
+        dropped = it->pending.algorithm;
+    } else if (it->running) {
+        dropped = it->runningAlgorithm;
+    }
+    
+    // The pending snapshot is as stale as the running one
+    it->generation++;
+    it->hasPending = false;
+    return dropped;
+}
+
+void LayoutEngine::start(const Job& job) {
+    WorkspaceState& state = m_workspaces[job.snapshot.workspace];
+    state.running = true;
+    state.runningAlgorithm = job.algorithm;
+    
+    auto* watcher = new QFutureWatcher<LayoutResult>(this);
+    connect(watcher, &QFutureWatcher<LayoutResult>::finished, this, [this, watcher]() {
+        finished(watcher->result());
+        watcher->deleteLater();
+    });
+    
+    watcher->setFuture(QtConcurrent::run(&m_pool, [job]() {
+        LayoutResult result = compute(job.algorithm, job.snapshot);
+        result.generation = job.generation;
+        return result;
+    }));
+}
+
+void LayoutEngine::finished(const LayoutResult& result) {
+    WorkspaceState& state = m_workspaces[result.workspace];
+    state.running = false;
+    
+    if (result.generation == state.generation) {
+        emit layoutReady(result);
+    } else {
+        PULSE_TRACE_COUNTER("layout", "discardedPasses", ++m_discarded);
+    }
+    
+    if (state.hasPending) {
+        state.hasPending = false;
+        start(state.pending);
+    }
+}
+
+LayoutResult LayoutEngine::compute(Algorithm algorithm, const LayoutSnapshot& snapshot) {
+    PULSE_TRACE_SCOPE("layout", "compute");
+    
+    LayoutResult result;
+    result.workspace = snapshot.workspace;
+    result.geometries.reserve(snapshot.windows.size());
+    
+    switch (algorithm) {
+    case Algorithm::Tile:
+        tile(snapshot, result);
+        break;
+    case Algorithm::Arrange:
+        arrange(snapshot, result);
+        break;
+    case Algorithm::Cascade:
+        cascade(snapshot, result);
+        break;
+    }
+    return result;
+}
+
+} // namespace Pulse
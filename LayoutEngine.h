@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QRect>
+#include <QThreadPool>
+#include <QVector>
+#include <optional>
+
+namespace Pulse {
+
+// Immutable input to one layout pass, captured on the GUI thread
+struct LayoutSnapshot {
+    struct Entry {
+        quint32 windowId = 0;
+        QRect geometry;
+        bool minimized = false;
+    };
+    
+    int workspace = 0;
+    QRect output;
+    QVector<Entry> windows;     // stacking order, bottom first
+};
+
+struct LayoutResult {
+    int workspace = 0;
+    quint64 generation = 0;
+    QVector<QPair<quint32, QRect>> geometries;
+};
+
+// Computes layouts on worker threads. Each workspace has a generation;
+// a result is delivered only if nothing newer was requested for its
+// workspace (or invalidated it) while it was computed. Requests made
+// while a pass is running are coalesced into one follow-up pass.
+class LayoutEngine : public QObject {
+    Q_OBJECT
+    
+public:
+    enum class Algorithm {
+        Tile,
+        Arrange,
+        Cascade
+    };
+    
+    explicit LayoutEngine(QObject* parent = nullptr);
+    ~LayoutEngine();
+    
+    void request(Algorithm algorithm, const LayoutSnapshot& snapshot);
+    
+    // The workspace changed under any in-flight pass (windows came or
+    // went). Returns the algorithm of the newest pass dropped, if any, so
+    // the caller can request it again on a fresh snapshot.
+    std::optional<Algorithm> invalidate(int workspace);
+    
+    // Pure layout functions; run on the pool
+    static LayoutResult compute(Algorithm algorithm, const LayoutSnapshot& snapshot);
+    
+signals:
+    // GUI thread; commit as one batch
+    void layoutReady(const Pulse::LayoutResult& result);
+    
+private:
+    struct Job {
+        Algorithm algorithm;
+        LayoutSnapshot snapshot;
+        quint64 generation;
+    };
+    
+    struct WorkspaceState {
+        quint64 generation = 0;
+        bool running = false;
+        Algorithm runningAlgorithm = Algorithm::Tile;
+        bool hasPending = false;
+        Job pending;
+    };
+    
+    void start(const Job& job);
+    void finished(const LayoutResult& result);
+    
+    QThreadPool m_pool;
+    QHash<int, WorkspaceState> m_workspaces;
+    qint64 m_discarded = 0;
+};
+
+} // namespace Pulse
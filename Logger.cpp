@@ -1,7 +1,10 @@
 #include "Logger.h"
 #include <QFile>
+#include <QMutex>
 #include <QTextStream>
 #include <QDateTime>
+#include <QStringEncoder>
+#include <cstdio>
 #include <iostream>
 
 namespace Pulse {
@@ -14,14 +17,63 @@ public:
     QTextStream fileStream;
     bool consoleOutput = true;
     
-    QString levelToString(LogLevel level) {
+    // Reused for every message, so logging stops allocating once warm;
+    // any thread may log, so they are only touched under mutex
+    QMutex mutex;
+    QString line;
+    QByteArray encoded;
+    QStringEncoder encoder{QStringEncoder::Utf8};
+    
+    QLatin1String levelToString(LogLevel level) {
         switch(level) {
-            case LogLevel::Debug: return "DEBUG";
-            case LogLevel::Info: return "INFO";
-            case LogLevel::Warning: return "WARNING";
-            case LogLevel::Error: return "ERROR";
-            case LogLevel::Critical: return "CRITICAL";
-            default: return "UNKNOWN";
+            case LogLevel::Debug: return QLatin1String("DEBUG");
+            case LogLevel::Info: return QLatin1String("INFO");
+            case LogLevel::Warning: return QLatin1String("WARNING");
+            case LogLevel::Error: return QLatin1String("ERROR");
+            case LogLevel::Critical: return QLatin1String("CRITICAL");
+            default: return QLatin1String("UNKNOWN");
+        }
+    }
+    
+    void write(LogLevel level, const QString& message, const QString& component) {
+        QMutexLocker locker(&mutex);
+        
+        const QDateTime now = QDateTime::currentDateTime();
+        const QDate date = now.date();
+        const QTime time = now.time();
+        char timestamp[32];
+        std::snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+                      date.year(), date.month(), date.day(),
+                      time.hour(), time.minute(), time.second(), time.msec());
+        
+        // "[timestamp] [LEVEL] [component] message", built in place
+        QString& logMessage = line;
+        logMessage.resize(0);
+        logMessage += QLatin1Char('[');
+        logMessage += QLatin1String(timestamp);
+        logMessage += QLatin1String("] [");
+        logMessage += levelToString(level);
+        logMessage += QLatin1String("] ");
+        if (!component.isEmpty()) {
+            logMessage += QLatin1Char('[');
+            logMessage += component;
+            logMessage += QLatin1String("] ");
+        }
+        logMessage += message;
+        
+        // Console output
+        if (consoleOutput) {
+            encoded.resize(encoder.requiredSpace(logMessage.size()));
+            const char* end = encoder.appendToBuffer(encoded.data(), logMessage);
+            std::ostream& stream = (level >= LogLevel::Warning) ? std::cerr : std::cout;
+            stream.write(encoded.constData(), end - encoded.constData());
+            stream << std::endl;
+        }
+        
+        // File output
+        if (logFile.isOpen()) {
+            fileStream << logMessage << "\n";
+            fileStream.flush();
         }
     }
 };
@@ -99,29 +151,7 @@ void Logger::log(LogLevel level, const QString& message, const QString& componen
         return;
     }
     
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz");
-    QString levelStr = d->levelToString(level);
-    QString logMessage;
-    
-    if (!component.isEmpty()) {
-        logMessage = QString("[%1] [%2] [%3] %4")
-            .arg(timestamp, levelStr, component, message);
-    } else {
-        logMessage = QString("[%1] [%2] %3")
-            .arg(timestamp, levelStr, message);
-    }
-    
-    // Console output
-    if (d->consoleOutput) {
-        std::ostream& stream = (level >= LogLevel::Warning) ? std::cerr : std::cout;
-        stream << logMessage.toStdString() << std::endl;
-    }
-    
-    // File output
-    if (d->logFile.isOpen()) {
-        d->fileStream << logMessage << "\n";
-        d->fileStream.flush();
-    }
+    d->write(level, message, component);
     
     // Signal for GUI log viewers
     emit messageLogged(level, message, component);
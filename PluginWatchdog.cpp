@@ -0,0 +1,375 @@
+#include "PluginWatchdog.h"
+#include "Tracer.h"
+#include <QDBusConnection>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtAlgorithms>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Pulse {
+
+namespace {
+
+constexpr qint64 kDefaultBudgetUs = 1000;           // 1 ms of a 16 ms frame
+constexpr int kDefaultDeferAfter = 8;
+constexpr int kDefaultDisableAfter = 32;
+constexpr qint64 kDefaultHangLimitMs = 1000;       // one call over 1 s is a hang
+constexpr int kMonitorIntervalMs = 100;
+constexpr int kMaxBacklog = 256;
+
+// Counters are atomics so inline (compositor thread) and deferred (worker)
+// invocations can update them without a lock
+struct PluginEntry {
+    QString id;
+    std::atomic<qint64> budgetNs{kDefaultBudgetUs * 1000};
+    std::atomic<int> mode{int(PluginWatchdog::Mode::Inline)};
+    std::atomic<quint64> recent{0};     // overrun bit per call, newest in bit 0
+    std::atomic<quint64> calls{0};
+    std::atomic<quint64> overruns{0};
+    std::atomic<qint64> totalNs{0};
+    std::atomic<qint64> maxNs{0};
+    std::atomic<int> backlog{0};
+    
+    // Set while a hook runs, for the monitor thread
+    std::atomic<qint64> startedAt{0};
+    std::atomic<const char*> runningHook{nullptr};
+};
+
+} // namespace
+
+class PluginWatchdog::Private {
+public:
+    explicit Private(PluginWatchdog* watchdog)
+        : q(watchdog) {
+    }
+    
+    // Moves the plugin from one mode to another unless someone else
+    // already has; the warning and signal follow on the watchdog's thread
+    void demote(PluginEntry* entry, Mode from, Mode to, const QString& reason);
+    
+    // Monitor thread: disables plugins whose hook is still running past
+    // the hang limit, without waiting for it to return
+    void monitorLoop();
+    
+    PluginWatchdog* q;
+    
+    // Guards the plugin list and configuration; invoke() only holds it
+    // for the handle lookup
+    mutable QMutex mutex;
+    std::vector<std::unique_ptr<PluginEntry>> plugins;
+    QHash<QString, int> handles;
+    QHash<QString, qint64> budgetsUs;   // may be set before the plugin loads
+    qint64 defaultBudgetUs = kDefaultBudgetUs;
+    std::atomic<int> deferAfter{kDefaultDeferAfter};
+    std::atomic<int> disableAfter{kDefaultDisableAfter};
+    std::atomic<qint64> hangLimitNs{kDefaultHangLimitMs * 1000 * 1000};
+    
+    QThreadPool worker;
+    bool dbusRegistered = false;
+    
+    // Guarded by mutex
+    QWaitCondition monitorWake;
+    bool stopping = false;
+    std::unique_ptr<QThread> monitor;
+    
+    PluginEntry* find(const QString& pluginId) const {
+        auto it = handles.constFind(pluginId);
+        return it == handles.constEnd() ? nullptr : plugins[*it].get();
+    }
+};
+
+void PluginWatchdog::Private::demote(PluginEntry* entry, Mode from, Mode to, const QString& reason) {
+    int expected = int(from);
+    if (!entry->mode.compare_exchange_strong(expected, int(to))) {
+        return;
+    }
+    
+    // Start the new mode with a clean history
+    entry->recent.store(0, std::memory_order_relaxed);
+    QMetaObject::invokeMethod(q, [watchdog = q, entry, to, reason]() {
+        if (to == Mode::Deferred) {
+            qWarning() << "Plugin" << entry->id << "keeps exceeding its budget, deferring to idle worker";
+            emit watchdog->pluginDeferred(entry->id);
+        } else {
+            qWarning() << "Plugin" << entry->id << "disabled:" << reason;
+            emit watchdog->pluginDisabled(entry->id, reason);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void PluginWatchdog::Private::monitorLoop() {
+    QMutexLocker locker(&mutex);
+    while (!stopping) {
+        monitorWake.wait(&mutex, kMonitorIntervalMs);
+        
+        const qint64 now = Tracer::now();
+        const qint64 limitNs = hangLimitNs.load(std::memory_order_relaxed);
+        for (const auto& entry : plugins) {
+            const qint64 startedAt = entry->startedAt.load(std::memory_order_acquire);
+            const Mode current = Mode(entry->mode.load(std::memory_order_relaxed));
+            if (startedAt == 0 || now - startedAt <= limitNs || current == Mode::Disabled) {
+                continue;
+            }
+            demote(entry.get(), current, Mode::Disabled,
+                   QStringLiteral("%1 stuck for over %2 ms")
+                       .arg(entry->runningHook.load(std::memory_order_relaxed)).arg(limitNs / 1000000));
+        }
+    }
+}
+
+PluginWatchdog::PluginWatchdog(QObject* parent)
+    : QObject(parent)
+    , d(std::make_unique<Private>(this)) {
+    
+    // One idle-priority thread: deferred hooks never compete with the
+    // compositor or render threads and never run concurrently
+    d->worker.setMaxThreadCount(1);
+    d->worker.setThreadPriority(QThread::IdlePriority);
+    d->worker.setObjectName("PluginWorker");
+    
+    // A hook that never returns blocks its caller, so hangs are caught
+    // from a thread of our own
+    d->monitor.reset(QThread::create([this]() { d->monitorLoop(); }));
+    d->monitor->setObjectName("PluginMonitor");
+    d->monitor->start();
+}
+
+PluginWatchdog::~PluginWatchdog() {
+    {
+        QMutexLocker locker(&d->mutex);
+        d->stopping = true;
+        d->monitorWake.wakeAll();
+    }
+    d->monitor->wait();
+    
+    d->worker.clear();
+    d->worker.waitForDone();
+}
+
+int PluginWatchdog::registerPlugin(const QString& pluginId) {
+    QMutexLocker locker(&d->mutex);
+    
+    auto it = d->handles.constFind(pluginId);
+    if (it != d->handles.constEnd()) {
+        return *it;
+    }
+    
+    auto entry = std::make_unique<PluginEntry>();
+    entry->id = pluginId;
+    entry->budgetNs.store(d->budgetsUs.value(pluginId, d->defaultBudgetUs) * 1000,
+                          std::memory_order_relaxed);
+    
+    const int handle = int(d->plugins.size());
+    d->plugins.push_back(std::move(entry));
+    d->handles.insert(pluginId, handle);
+    return handle;
+}
+
+QString PluginWatchdog::pluginId(int handle) const {
+    QMutexLocker locker(&d->mutex);
+    return handle >= 0 && handle < int(d->plugins.size()) ? d->plugins[handle]->id : QString();
+}
+
+void PluginWatchdog::setDefaultBudget(qint64 budgetUs) {
+    QMutexLocker locker(&d->mutex);
+    d->defaultBudgetUs = budgetUs;
+    for (const auto& entry : d->plugins) {
+        if (!d->budgetsUs.contains(entry->id)) {
+            entry->budgetNs.store(budgetUs * 1000, std::memory_order_relaxed);
+        }
+    }
+}
+
+void PluginWatchdog::setBudget(const QString& pluginId, qint64 budgetUs) {
+    QMutexLocker locker(&d->mutex);
+    d->budgetsUs.insert(pluginId, budgetUs);
+    if (PluginEntry* entry = d->find(pluginId)) {
+        entry->budgetNs.store(budgetUs * 1000, std::memory_order_relaxed);
+    }
+}
+
+qint64 PluginWatchdog::budget(const QString& pluginId) const {
+    QMutexLocker locker(&d->mutex);
+    return d->budgetsUs.value(pluginId, d->defaultBudgetUs);
+}
+
+void PluginWatchdog::setOverrunLimits(int deferAfter, int disableAfter) {
+    d->deferAfter.store(qBound(1, deferAfter, 64), std::memory_order_relaxed);
+    d->disableAfter.store(qBound(1, disableAfter, 64), std::memory_order_relaxed);
+}
+
+void PluginWatchdog::setHangLimit(qint64 limitMs) {
+    d->hangLimitNs.store(qMax<qint64>(1, limitMs) * 1000 * 1000, std::memory_order_relaxed);
+}
+
+PluginWatchdog::Mode PluginWatchdog::mode(const QString& pluginId) const {
+    QMutexLocker locker(&d->mutex);
+    PluginEntry* entry = d->find(pluginId);
+    return entry ? Mode(entry->mode.load(std::memory_order_relaxed)) : Mode::Inline;
+}
+
+bool PluginWatchdog::invoke(int handle, const char* hook, std::function<void()> callback) {
+    // Registration may grow the list from another thread; entries
+    // themselves never move
+    PluginEntry* entry = nullptr;
+    {
+        QMutexLocker locker(&d->mutex);
+        Q_ASSERT(handle >= 0 && handle < int(d->plugins.size()));
+        entry = d->plugins[handle].get();
+    }
+    
+    auto run = [this, entry, hook](const std::function<void()>& function) {
+        const qint64 start = Tracer::now();
+        entry->runningHook.store(hook, std::memory_order_relaxed);
+        entry->startedAt.store(start, std::memory_order_release);
+        function();
+        entry->startedAt.store(0, std::memory_order_release);
+        const qint64 elapsed = Tracer::now() - start;
+        
+        if (Tracer::enabled()) {
+            Tracer::complete("plugin", hook, start, elapsed);
+        }
+        
+        entry->calls.fetch_add(1, std::memory_order_relaxed);
+        entry->totalNs.fetch_add(elapsed, std::memory_order_relaxed);
+        qint64 max = entry->maxNs.load(std::memory_order_relaxed);
+        while (elapsed > max && !entry->maxNs.compare_exchange_weak(max, elapsed, std::memory_order_relaxed)) {
+        }
+        
+        const bool overrun = elapsed > entry->budgetNs.load(std::memory_order_relaxed);
+        const quint64 recent = (entry->recent.load(std::memory_order_relaxed) << 1) | (overrun ? 1 : 0);
+        entry->recent.store(recent, std::memory_order_relaxed);
+        if (!overrun) return;
+        
+        entry->overruns.fetch_add(1, std::memory_order_relaxed);
+        const int recentOverruns = qPopulationCount(recent);
+        const Mode current = Mode(entry->mode.load(std::memory_order_relaxed));
+        
+        QString reason;
+        Mode next = current;
+        if (elapsed > d->hangLimitNs.load(std::memory_order_relaxed)) {
+            next = Mode::Disabled;
+            reason = QStringLiteral("%1 blocked for %2 ms").arg(hook).arg(elapsed / 1000000);
+        } else if (current == Mode::Inline && recentOverruns >= d->deferAfter.load(std::memory_order_relaxed)) {
+            next = Mode::Deferred;
+        } else if (current == Mode::Deferred && recentOverruns >= d->disableAfter.load(std::memory_order_relaxed)) {
+            next = Mode::Disabled;
+            reason = QStringLiteral("over budget on %1 of its last 64 calls").arg(recentOverruns);
+        }
+        
+        if (next != current) {
+            d->demote(entry, current, next, reason);
+        }
+    };
+    
+    switch (Mode(entry->mode.load(std::memory_order_relaxed))) {
+    case Mode::Inline:
+        run(callback);
+        return true;
+        
+    case Mode::Deferred:
+        if (entry->backlog.load(std::memory_order_relaxed) >= kMaxBacklog) {
+            // The worker cannot keep up either; stop feeding it
+            d->demote(entry, Mode::Deferred, Mode::Disabled,
+                      QStringLiteral("deferred backlog exceeded %1 calls").arg(kMaxBacklog));
+            return false;
+        }
+        entry->backlog.fetch_add(1, std::memory_order_relaxed);
+        d->worker.start([run, entry, callback = std::move(callback)]() {
+            // Re-check: the plugin may have been disabled while queued
+            if (entry->mode.load(std::memory_order_relaxed) == int(Mode::Deferred)) {
+                run(callback);
+            }
+            entry->backlog.fetch_sub(1, std::memory_order_relaxed);
+        });
+        return false;
+        
+    case Mode::Disabled:
+        return false;
+    }
+    
+    return false;
+}
+
+bool PluginWatchdog::enablePlugin(const QString& pluginId) {
+    QMutexLocker locker(&d->mutex);
+    PluginEntry* entry = d->find(pluginId);
+    if (!entry) return false;
+    
+    entry->recent.store(0, std::memory_order_relaxed);
+    entry->mode.store(int(Mode::Inline), std::memory_order_relaxed);
+    qDebug() << "Plugin" << pluginId << "re-enabled on the compositor thread";
+    return true;
+}
+
+bool PluginWatchdog::setPluginBudget(const QString& pluginId, int budgetUs) {
+    if (budgetUs <= 0) return false;
+    setBudget(pluginId, budgetUs);
+    return true;
+}
+
+QString PluginWatchdog::costReport() const {
+    struct Row {
+        QJsonObject object;
+        qint64 totalNs;
+    };
+    std::vector<Row> rows;
+    
+    {
+        QMutexLocker locker(&d->mutex);
+        for (const auto& entry : d->plugins) {
+            const quint64 calls = entry->calls.load(std::memory_order_relaxed);
+            const qint64 totalNs = entry->totalNs.load(std::memory_order_relaxed);
+            const Mode mode = Mode(entry->mode.load(std::memory_order_relaxed));
+            
+            QJsonObject object;
+            object["id"] = entry->id;
+            object["mode"] = mode == Mode::Inline ? "inline" : mode == Mode::Deferred ? "deferred" : "disabled";
+            object["budgetUs"] = entry->budgetNs.load(std::memory_order_relaxed) / 1000;
+            object["calls"] = qint64(calls);
+            object["overruns"] = qint64(entry->overruns.load(std::memory_order_relaxed));
+            object["totalUs"] = totalNs / 1000;
+            object["averageUs"] = calls ? double(totalNs) / calls / 1000.0 : 0.0;
+            object["maxUs"] = entry->maxNs.load(std::memory_order_relaxed) / 1000;
+            object["backlog"] = entry->backlog.load(std::memory_order_relaxed);
+            rows.push_back({object, totalNs});
+        }
+    }
+    
+    // Most expensive first
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        return a.totalNs > b.totalNs;
+    });
+    
+    QJsonArray report;
+    for (const Row& row : rows) {
+        report.append(row.object);
+    }
+    return QString::fromUtf8(QJsonDocument(report).toJson(QJsonDocument::Compact));
+}
+
+bool PluginWatchdog::exportOnDBus() {
+    if (d->dbusRegistered) {
+        return true;
+    }
+    
+    d->dbusRegistered = QDBusConnection::sessionBus().registerObject(
+        "/org/pulse/PluginWatchdog", this,
+        QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportScriptableSignals);
+    
+    if (!d->dbusRegistered) {
+        qWarning() << "Failed to register plugin watchdog on DBus";
+    }
+    return d->dbusRegistered;
+}
+
+} // namespace Pulse
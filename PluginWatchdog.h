@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <functional>
+#include <memory>
+
+namespace Pulse {
+
+// Times every plugin hook invocation against a per-plugin budget. Plugins
+// that keep overrunning are moved to an idle-priority worker thread, and
+// disabled if they still misbehave there, so a slow plugin shows up in the
+// cost report instead of as dropped frames. A monitor thread disables a
+// plugin whose hook hangs without waiting for it to return.
+class PluginWatchdog : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.pulse.PluginWatchdog")
+    
+public:
+    enum class Mode {
+        Inline,         // runs on the calling (compositor) thread
+        Deferred,       // runs on the idle worker, off the frame path
+        Disabled
+    };
+    Q_ENUM(Mode)
+    
+    explicit PluginWatchdog(QObject* parent = nullptr);
+    ~PluginWatchdog();
+    
+    // Returns a handle for invoke(); registering an id twice returns the same handle
+    int registerPlugin(const QString& pluginId);
+    QString pluginId(int handle) const;
+    
+    // Budgets, in microseconds per hook invocation
+    void setDefaultBudget(qint64 budgetUs);
+    void setBudget(const QString& pluginId, qint64 budgetUs);
+    qint64 budget(const QString& pluginId) const;
+    
+    // Overruns among the last 64 invocations before deferring / disabling
+    void setOverrunLimits(int deferAfter, int disableAfter);
+    
+    // A single call running longer disables the plugin, even while the
+    // call is still stuck
+    void setHangLimit(qint64 limitMs);
+    
+    // Run a hook under the watchdog. hook must be a string literal. Returns
+    // true if the hook ran synchronously; deferred hooks run later on the
+    // worker and disabled plugins are skipped.
+    bool invoke(int handle, const char* hook, std::function<void()> callback);
+    
+    Mode mode(const QString& pluginId) const;
+    
+    // Publish this object on the session bus at /org/pulse/PluginWatchdog
+    bool exportOnDBus();
+    
+public slots:
+    // JSON array: id, mode, budget, calls, overruns, total/avg/max cost
+    Q_SCRIPTABLE QString costReport() const;
+    Q_SCRIPTABLE bool setPluginBudget(const QString& pluginId, int budgetUs);
+    // Put a deferred or disabled plugin back on the compositor thread
+    Q_SCRIPTABLE bool enablePlugin(const QString& pluginId);
+    
+signals:
+    Q_SCRIPTABLE void pluginDeferred(const QString& pluginId);
+    Q_SCRIPTABLE void pluginDisabled(const QString& pluginId, const QString& reason);
+    
+private:
+    class Private;
+    std::unique_ptr<Private> d;
+};
+
+} // namespace Pulse
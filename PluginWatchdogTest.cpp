@@ -0,0 +1,156 @@
+// Plugin watchdog test: demotion and the cost report.
+//
+// Drives PluginWatchdog with hooks of known cost, with small budgets and
+// overrun limits so every step takes a few calls:
+//   defer    a plugin over budget on every call moves to the idle worker
+//   disable  it keeps overrunning there and is disabled
+//   hang     a hook blocks past the hang limit; the monitor thread must
+//            disable the plugin while the call is still running
+//   report   costReport() lists every plugin with its mode and counters,
+//            most expensive first
+// Exits non-zero on any failed check.
+
+#include "PluginWatchdog.h"
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QDebug>
+#include <limits>
+
+namespace Pulse {
+
+namespace {
+
+constexpr qint64 kBudgetUs = 200;
+constexpr int kDeferAfter = 4;
+constexpr int kDisableAfter = 8;
+constexpr qint64 kHangLimitMs = 200;
+constexpr int kSettleTimeoutMs = 5000;
+
+int s_failures = 0;
+
+void check(bool condition, const char* scenario, const QString& what) {
+    if (!condition) {
+        qWarning().noquote() << scenario << "failed:" << what;
+        s_failures++;
+    }
+}
+
+void overrun() {
+    QThread::msleep(2);
+}
+
+// Deferred calls finish on the worker and signals arrive queued
+bool waitForMode(PluginWatchdog& watchdog, const QString& pluginId, PluginWatchdog::Mode mode) {
+    QDeadlineTimer deadline(kSettleTimeoutMs);
+    while (watchdog.mode(pluginId) != mode && !deadline.hasExpired()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    QCoreApplication::processEvents();
+    return watchdog.mode(pluginId) == mode;
+}
+
+void demotesSlowPlugin(PluginWatchdog& watchdog) {
+    const int handle = watchdog.registerPlugin("slow");
+    QStringList deferred;
+    QStringList disabled;
+    QObject receiver;
+    QObject::connect(&watchdog, &PluginWatchdog::pluginDeferred, &receiver, [&deferred](const QString& id) {
+        deferred << id;
+    });
+    QObject::connect(&watchdog, &PluginWatchdog::pluginDisabled, &receiver, [&disabled](const QString& id) {
+        disabled << id;
+    });
+    
+    for (int i = 0; i < kDeferAfter; ++i) {
+        check(watchdog.invoke(handle, "slowHook", overrun), "defer", "inline call did not run synchronously");
+    }
+    check(waitForMode(watchdog, "slow", PluginWatchdog::Mode::Deferred), "defer", "plugin not deferred");
+    check(deferred == QStringList{"slow"}, "defer", "pluginDeferred not emitted once");
+    
+    for (int i = 0; i < kDisableAfter; ++i) {
+        check(!watchdog.invoke(handle, "slowHook", overrun), "disable", "deferred call ran synchronously");
+    }
+    check(waitForMode(watchdog, "slow", PluginWatchdog::Mode::Disabled), "disable", "plugin not disabled");
+    check(disabled == QStringList{"slow"}, "disable", "pluginDisabled not emitted once");
+    
+    bool ran = false;
+    watchdog.invoke(handle, "slowHook", [&ran]() { ran = true; });
+    QThread::msleep(50);
+    check(!ran, "disable", "disabled plugin still called");
+}
+
+void disablesHungPlugin(PluginWatchdog& watchdog) {
+    const int handle = watchdog.registerPlugin("hung");
+    
+    // Checked from inside the hook: demotion must not wait for it to return
+    PluginWatchdog::Mode modeWhileStuck = PluginWatchdog::Mode::Inline;
+    watchdog.invoke(handle, "hungHook", [&watchdog, &modeWhileStuck]() {
+        QDeadlineTimer deadline(kSettleTimeoutMs);
+        while (watchdog.mode("hung") != PluginWatchdog::Mode::Disabled && !deadline.hasExpired()) {
+            QThread::msleep(10);
+        }
+        modeWhileStuck = watchdog.mode("hung");
+    });
+    check(modeWhileStuck == PluginWatchdog::Mode::Disabled, "hang", "plugin not disabled while stuck");
+}
+
+void reportsCosts(PluginWatchdog& watchdog) {
+    const int handle = watchdog.registerPlugin("cheap");
+    for (int i = 0; i < 3; ++i) {
+        watchdog.invoke(handle, "cheapHook", []() {});
+    }
+    
+    const QJsonArray report = QJsonDocument::fromJson(watchdog.costReport().toUtf8()).array();
+    check(report.size() == 3, "report", QStringLiteral("%1 plugins listed, expected 3").arg(report.size()));
+    
+    qint64 previousTotal = std::numeric_limits<qint64>::max();
+    for (const QJsonValue& value : report) {
+        const QJsonObject plugin = value.toObject();
+        const QString id = plugin["id"].toString();
+        const qint64 total = plugin["totalUs"].toInteger();
+        check(total <= previousTotal, "report", QStringLiteral("%1 listed out of cost order").arg(id));
+        previousTotal = total;
+        
+        if (id == "slow") {
+            check(plugin["mode"].toString() == "disabled", "report", "slow not reported disabled");
+            check(plugin["calls"].toInteger() == kDeferAfter + kDisableAfter, "report", "slow call count");
+            check(plugin["overruns"].toInteger() == kDeferAfter + kDisableAfter, "report", "slow overrun count");
+            check(plugin["budgetUs"].toInteger() == kBudgetUs, "report", "slow budget");
+        } else if (id == "hung") {
+            check(plugin["mode"].toString() == "disabled", "report", "hung not reported disabled");
+            check(plugin["maxUs"].toInteger() >= kHangLimitMs * 1000, "report", "hung maximum cost");
+        } else if (id == "cheap") {
+            check(plugin["mode"].toString() == "inline", "report", "cheap not reported inline");
+            check(plugin["calls"].toInteger() == 3, "report", "cheap call count");
+            check(plugin["overruns"].toInteger() == 0, "report", "cheap overrun count");
+        } else {
+            check(false, "report", QStringLiteral("unknown plugin %1").arg(id));
+        }
+    }
+}
+
+} // namespace
+
+} // namespace Pulse
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("pulse-plugin-watchdog-test");
+    
+    Pulse::PluginWatchdog watchdog;
+    watchdog.setDefaultBudget(Pulse::kBudgetUs);
+    watchdog.setOverrunLimits(Pulse::kDeferAfter, Pulse::kDisableAfter);
+    watchdog.setHangLimit(Pulse::kHangLimitMs);
+    
+    Pulse::demotesSlowPlugin(watchdog);
+    Pulse::disablesHungPlugin(watchdog);
+    Pulse::reportsCosts(watchdog);
+    
+    qDebug().noquote() << "Plugin watchdog:" << (Pulse::s_failures ? "FAILED" : "passed");
+    qDebug().noquote() << watchdog.costReport();
+    return Pulse::s_failures == 0 ? 0 : 1;
+}
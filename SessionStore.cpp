@@ -0,0 +1,285 @@
+#include "SessionStore.h"
+#include "Tracer.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+#include <cstring>
+
+namespace Pulse {
+
+namespace {
+
+constexpr quint32 kMagic = 0x53455350;    // "PSES"
+constexpr quint32 kVersion = 1;
+
+// Stable across runs and Qt versions, unlike qHash
+quint64 fnv1a(const QByteArray& data, quint64 hash = 1469598103934665603ull) {
+    for (char c : data) {
+        hash ^= quint8(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+quint64 appHash(const QString& appId) {
+    return fnv1a(appId.toUtf8());
+}
+
+quint64 fullHash(const QString& appId, const QString& title) {
+    return fnv1a(title.toUtf8(), appHash(appId) ^ 0x9e3779b97f4a7c15ull);
+}
+
+} // namespace
+
+// On-disk layout (native endianness): header, two slot tables of
+// tableSize quint32s holding entry index + 1, entries, then UTF-8 strings
+struct SessionStore::Header {
+    quint32 magic;
+    quint32 version;
+    quint32 entryCount;
+    quint32 tableSize;          // power of two, at least twice entryCount
+    quint32 fullTableOffset;
+    quint32 appTableOffset;
+    quint32 entriesOffset;
+    quint32 stringsOffset;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+struct SessionStore::Entry {
+    quint64 fullHash;
+    quint64 appHash;
+    qint32 x;
+    qint32 y;
+    qint32 width;
+    qint32 height;
+    qint32 state;
+    qint32 workspace;
+    qint32 stackPosition;
+    quint32 appIdOffset;
+    quint32 appIdLength;
+    quint32 titleOffset;
+    quint32 titleLength;
+    quint32 outputOffset;
+    quint32 outputLength;
+    quint32 reserved;
+};
+
+SessionStore::SessionStore() {
+}
+
+SessionStore::~SessionStore() {
+    clear();
+}
+
+QString SessionStore::defaultPath() {
+    const QString overridden = qEnvironmentVariable("PULSE_SESSION_FILE");
+    if (!overridden.isEmpty()) {
+        return overridden;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+        + QStringLiteral("/session.bin");
+}
+
+bool SessionStore::save(const QString& path, const QVector<Record>& records) {
+    PULSE_TRACE_SCOPE("session", "save");
+    
+    quint32 tableSize = 16;
+    while (tableSize < quint32(records.size()) * 2) {
+        tableSize *= 2;
+    }
+    const quint32 mask = tableSize - 1;
+    
+    Header header = {};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.entryCount = records.size();
+    header.tableSize = tableSize;
+    header.fullTableOffset = sizeof(Header);
+    header.appTableOffset = header.fullTableOffset + tableSize * sizeof(quint32);
+    header.entriesOffset = header.appTableOffset + tableSize * sizeof(quint32);
+    header.stringsOffset = header.entriesOffset + records.size() * sizeof(Entry);
+    
+    QVector<quint32> fullTable(tableSize, 0);
+    QVector<quint32> appTable(tableSize, 0);
+    QVector<Entry> entries(records.size());
+    QByteArray strings;
+    
+    auto appendString = [&strings](const QString& value, quint32* offset, quint32* length) {
+        const QByteArray utf8 = value.toUtf8();
+        *offset = strings.size();
+        *length = utf8.size();
+        strings.append(utf8);
+    };
+    auto insertSlot = [mask](QVector<quint32>& table, quint64 hash, quint32 index) {
+        quint32 slot = quint32(hash) & mask;
+        while (table[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        table[slot] = index + 1;
+    };
+    
+    for (int i = 0; i < records.size(); ++i) {
+        const Record& record = records[i];
+        Entry& entry = entries[i];
+        std::memset(&entry, 0, sizeof(Entry));
+        entry.fullHash = fullHash(record.appId, record.title);
+        entry.appHash = appHash(record.appId);
+        entry.x = record.geometry.x();
+        entry.y = record.geometry.y();
+        entry.width = record.geometry.width();
+        entry.height = record.geometry.height();
+        entry.state = record.state;
+        entry.workspace = record.workspace;
+        entry.stackPosition = record.stackPosition;
+        appendString(record.appId, &entry.appIdOffset, &entry.appIdLength);
+        appendString(record.title, &entry.titleOffset, &entry.titleLength);
+        appendString(record.output, &entry.outputOffset, &entry.outputLength);
+        
+        insertSlot(fullTable, entry.fullHash, i);
+        insertSlot(appTable, entry.appHash, i);
+    }
+    header.stringsSize = strings.size();
+    
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open session snapshot" << path << file.errorString();
+        return false;
+    }
+    
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(fullTable.constData()), tableSize * sizeof(quint32));
+    file.write(reinterpret_cast<const char*>(appTable.constData()), tableSize * sizeof(quint32));
+    file.write(reinterpret_cast<const char*>(entries.constData()), entries.size() * sizeof(Entry));
+    file.write(strings);
+    
+    // Rename over the old snapshot only once everything is on disk
+    if (!file.commit()) {
+        qWarning() << "Failed to write session snapshot" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool SessionStore::load(const QString& path) {
+    PULSE_TRACE_SCOPE("session", "load");
+    clear();
+    
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    m_size = m_file.size();
+    m_data = m_size >= qint64(sizeof(Header)) ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        clear();
+        return false;
+    }
+    
+    // Reject anything truncated or from another layout version
+    const Header* h = header();
+    const quint64 tableBytes = quint64(h->tableSize) * sizeof(quint32);
+    const bool valid = h->magic == kMagic && h->version == kVersion &&
+        h->tableSize && (h->tableSize & (h->tableSize - 1)) == 0 &&
+        h->entryCount <= h->tableSize / 2 &&
+        h->fullTableOffset == sizeof(Header) &&
+        h->appTableOffset == h->fullTableOffset + tableBytes &&
+        h->entriesOffset == h->appTableOffset + tableBytes &&
+        h->stringsOffset == h->entriesOffset + quint64(h->entryCount) * sizeof(Entry) &&
+        quint64(h->stringsOffset) + h->stringsSize <= quint64(m_size);
+    if (!valid) {
+        qWarning() << "Ignoring invalid session snapshot" << path;
+        clear();
+        return false;
+    }
+    
+    m_claimed = QBitArray(h->entryCount);
+    qDebug() << "Session snapshot mapped:" << h->entryCount << "windows";
+    return true;
+}
+
+void SessionStore::clear() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+    m_claimed.clear();
+}
+
+int SessionStore::count() const {
+    return m_data ? int(header()->entryCount) : 0;
+}
+
+const SessionStore::Header* SessionStore::header() const {
+    return reinterpret_cast<const Header*>(m_data);
+}
+
+const SessionStore::Entry* SessionStore::entries() const {
+    return reinterpret_cast<const Entry*>(m_data + header()->entriesOffset);
+}
+
+QString SessionStore::string(quint32 offset, quint32 length) const {
+    const Header* h = header();
+    if (quint64(offset) + length > h->stringsSize) {
+        return QString();
+    }
+    return QString::fromUtf8(reinterpret_cast<const char*>(m_data + h->stringsOffset + offset), length);
+}
+
+int SessionStore::find(const QString& appId, const QString* title) const {
+    const Header* h = header();
+    const quint32 mask = h->tableSize - 1;
+    const quint32 tableOffset = title ? h->fullTableOffset : h->appTableOffset;
+    const quint32* table = reinterpret_cast<const quint32*>(m_data + tableOffset);
+    const quint64 hash = title ? fullHash(appId, *title) : appHash(appId);
+    
+    // Linear probing; stops at the first empty slot
+    for (quint32 slot = quint32(hash) & mask, probes = 0; table[slot] && probes < h->tableSize;
+         slot = (slot + 1) & mask, ++probes) {
+        const quint32 index = table[slot] - 1;
+        if (index >= h->entryCount || m_claimed.testBit(index)) continue;
+        
+        const Entry& entry = entries()[index];
+        if ((title ? entry.fullHash : entry.appHash) != hash) continue;
+        
+        // Hashes only narrow it down; confirm the strings
+        if (string(entry.appIdOffset, entry.appIdLength) != appId) continue;
+        if (title && string(entry.titleOffset, entry.titleLength) != *title) continue;
+        return int(index);
+    }
+    return -1;
+}
+
+bool SessionStore::take(const QString& appId, const QString& title, Record* record) {
+    if (!m_data || appId.isEmpty()) {
+        return false;
+    }
+    
+    int index = find(appId, &title);
+    if (index < 0) {
+        index = find(appId, nullptr);
+    }
+    if (index < 0) {
+        return false;
+    }
+    
+    m_claimed.setBit(index);
+    
+    const Entry& entry = entries()[index];
+    record->appId = appId;
+    record->title = string(entry.titleOffset, entry.titleLength);
+    record->output = string(entry.outputOffset, entry.outputLength);
+    record->geometry = QRect(entry.x, entry.y, entry.width, entry.height);
+    record->state = entry.state;
+    record->workspace = entry.workspace;
+    record->stackPosition = entry.stackPosition;
+    return true;
+}
+
+} // namespace Pulse
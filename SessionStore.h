@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QBitArray>
+#include <QFile>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+namespace Pulse {
+
+// Compact binary snapshot of window placement. Saved atomically, then read
+// back through a memory map with two open-addressed hash tables (app id +
+// title, and app id alone), so finding a window's saved placement is O(1)
+// and nothing is parsed up front.
+class SessionStore {
+public:
+    struct Record {
+        QString appId;
+        QString title;
+        QString output;
+        QRect geometry;
+        int state = 0;          // Window::State
+        int workspace = 0;
+        int stackPosition = 0;  // index within its workspace, bottom first
+    };
+    
+    SessionStore();
+    ~SessionStore();
+    
+    // PULSE_SESSION_FILE if set, else session.bin in the app data directory
+    static QString defaultPath();
+    
+    // Writes records to path via a temporary file and rename
+    static bool save(const QString& path, const QVector<Record>& records);
+    
+    // Maps a snapshot; the previous one is dropped
+    bool load(const QString& path);
+    void clear();
+    bool isLoaded() const { return m_data != nullptr; }
+    int count() const;
+    
+    // Best unclaimed match: same app id and title, else same app id. The
+    // match is claimed so a second window of the same app gets the next one.
+    bool take(const QString& appId, const QString& title, Record* record);
+    
+private:
+    struct Header;
+    struct Entry;
+    
+    const Header* header() const;
+    const Entry* entries() const;
+    QString string(quint32 offset, quint32 length) const;
+    int find(const QString& appId, const QString* title) const;
+    
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    QBitArray m_claimed;
+};
+
+} // namespace Pulse
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Pulse {
+
+// Bounded wait-free single-producer/single-consumer ring buffer.
+// push() is called from exactly one thread and pop() from exactly one other.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+    
+public:
+    // Producer side; returns false when the queue is full
+    bool push(const T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tailCache >= Capacity) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head - m_tailCache >= Capacity) {
+                return false;
+            }
+        }
+        m_buffer[head & (Capacity - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side; returns false when the queue is empty
+    bool pop(T& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_headCache) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail == m_headCache) {
+                return false;
+            }
+        }
+        value = m_buffer[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Approximate when called concurrently
+    size_t size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+    
+private:
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> m_head{0};
+    size_t m_tailCache = 0;
+    
+    alignas(64) std::atomic<size_t> m_tail{0};
+    size_t m_headCache = 0;
+    
+    alignas(64) std::array<T, Capacity> m_buffer{};
+};
+
+} // namespace Pulse
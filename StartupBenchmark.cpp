@@ -0,0 +1,157 @@
+// Shell startup benchmark.
+//
+// Launches the shell repeatedly with PULSE_STARTUP_BENCHMARK=1, which makes
+// it quit after its first frame, in two modes:
+//   disk      QML read from --qml-dir and compiled at startup with the disk
+//             cache off, as the shell started before the Pulse module
+//   compiled  QML compiled ahead of time into the binary
+// Runs alternate between the modes so drift hits both alike. The shell's
+// session file lives in a temporary directory, so the user's saved session
+// is neither restored nor overwritten. Reports wall
+// time to exit and the shell's own time to first frame per mode. Exits
+// non-zero when a launch fails, or when --min-speedup is given and the
+// compiled median is not that much faster.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace Pulse {
+
+namespace {
+
+constexpr int kLaunchTimeoutMs = 30000;
+
+struct Mode {
+    const char* name;
+    bool fromDisk;
+    QVector<double> wallMs;
+    QVector<double> firstFrameMs;
+};
+
+double percentile(QVector<double> values, double p) {
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    const int rank = int(std::ceil(p * values.size())) - 1;
+    return values[qBound(0, rank, int(values.size()) - 1)];
+}
+
+bool launch(const QString& shell, const QString& qmlDir, const QString& sessionFile, Mode& mode) {
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("PULSE_STARTUP_BENCHMARK", "1");
+    environment.insert("PULSE_SESSION_FILE", sessionFile);
+    if (!environment.contains("QT_QPA_PLATFORM")) {
+        environment.insert("QT_QPA_PLATFORM", "offscreen");
+    }
+    if (mode.fromDisk) {
+        environment.insert("PULSE_QML_DIR", qmlDir);
+        environment.insert("QML_DISABLE_DISK_CACHE", "1");
+    }
+    
+    QProcess process;
+    process.setProcessEnvironment(environment);
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    
+    QElapsedTimer timer;
+    timer.start();
+    process.start(shell, {});
+    if (!process.waitForFinished(kLaunchTimeoutMs)) {
+        qWarning() << mode.name << "launch did not finish:" << process.errorString();
+        process.kill();
+        process.waitForFinished();
+        return false;
+    }
+    const double wallMs = timer.nsecsElapsed() / 1e6;
+    
+    const QString output = QString::fromLocal8Bit(process.readAll());
+    static const QRegularExpression firstFrame("first frame after (\\d+) ms");
+    const QRegularExpressionMatch match = firstFrame.match(output);
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0 || !match.hasMatch()) {
+        qWarning().noquote() << mode.name << "launch failed with exit code" << process.exitCode() << "\n" << output;
+        return false;
+    }
+    
+    mode.wallMs.append(wallMs);
+    mode.firstFrameMs.append(match.captured(1).toDouble());
+    return true;
+}
+
+} // namespace
+
+} // namespace Pulse
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("pulse-startup-benchmark");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares shell startup with compiled and on-disk QML");
+    parser.addHelpOption();
+    parser.addOption({"shell", "Shell executable", "path"});
+    parser.addOption({"qml-dir", "Directory holding main.qml for the disk mode", "path"});
+    parser.addOption({"runs", "Launches per mode", "count", "20"});
+    parser.addOption({"min-speedup", "Required disk/compiled ratio of median first frame", "ratio", "0"});
+    parser.process(app);
+    
+    const QString shell = parser.value("shell");
+    const QString qmlDir = parser.value("qml-dir");
+    if (shell.isEmpty() || qmlDir.isEmpty()) {
+        qWarning() << "--shell and --qml-dir are required";
+        return 2;
+    }
+    
+    QTemporaryDir sessionDir;
+    if (!sessionDir.isValid()) {
+        qWarning() << "Failed to create a session directory:" << sessionDir.errorString();
+        return 2;
+    }
+    const QString sessionFile = sessionDir.filePath("session.bin");
+    
+    Pulse::Mode modes[] = {
+        { "disk", true, {}, {} },
+        { "compiled", false, {}, {} }
+    };
+    
+    // One untimed launch each warms the file cache
+    for (Pulse::Mode& mode : modes) {
+        Pulse::Mode warmup{ mode.name, mode.fromDisk, {}, {} };
+        if (!Pulse::launch(shell, qmlDir, sessionFile, warmup)) {
+            return 1;
+        }
+    }
+    
+    const int runs = qMax(1, parser.value("runs").toInt());
+    for (int i = 0; i < runs; ++i) {
+        for (Pulse::Mode& mode : modes) {
+            if (!Pulse::launch(shell, qmlDir, sessionFile, mode)) {
+                return 1;
+            }
+        }
+    }
+    
+    for (const Pulse::Mode& mode : modes) {
+        qDebug().nospace().noquote()
+            << QString("%1").arg(mode.name, -8) << " first frame p50 " << Pulse::percentile(mode.firstFrameMs, 0.5)
+            << " ms, p95 " << Pulse::percentile(mode.firstFrameMs, 0.95)
+            << " ms; process p50 " << Pulse::percentile(mode.wallMs, 0.5)
+            << " ms, p95 " << Pulse::percentile(mode.wallMs, 0.95) << " ms";
+    }
+    
+    const double disk = Pulse::percentile(modes[0].firstFrameMs, 0.5);
+    const double compiled = qMax(1.0, Pulse::percentile(modes[1].firstFrameMs, 0.5));
+    const double speedup = disk / compiled;
+    qDebug().nospace() << "Speedup (median first frame): " << speedup << "x";
+    
+    const double required = parser.value("min-speedup").toDouble();
+    if (required > 0 && speedup < required) {
+        qWarning() << "Speedup below" << required;
+        return 1;
+    }
+    return 0;
+}
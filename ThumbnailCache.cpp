@@ -0,0 +1,255 @@
+#include "ThumbnailCache.h"
+#include "EventBus.h"
+#include "Tracer.h"
+#include "WindowManager.h"
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QDebug>
+
+namespace Pulse {
+
+ThumbnailCache::ThumbnailCache(WindowManager* windowManager, QObject* parent)
+    : QObject(parent)
+    , m_windowManager(windowManager) {
+    
+    EventBus* bus = EventBus::instance();
+    bus->subscribe<WindowAdded, &ThumbnailCache::onWindowAdded>(this);
+    bus->subscribe<WindowRemoved, &ThumbnailCache::onWindowRemoved>(this);
+    
+    // Windows created before us; one whose WindowAdded is still queued
+    // reaches onWindowAdded twice
+    for (Window* window : m_windowManager->windows()) {
+        onWindowAdded(WindowAdded{window});
+    }
+    
+    m_releaseTimer.setInterval(5000);
+    connect(&m_releaseTimer, &QTimer::timeout, this, &ThumbnailCache::releaseIdleBuffers);
+}
+
+ThumbnailCache::~ThumbnailCache() {
+}
+
+QImage ThumbnailCache::thumbnail(quint32 windowId) {
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(windowId);
+        if (it != m_entries.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->lru);
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return it->image;
+        }
+    }
+    
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    QMetaObject::invokeMethod(this, [this, windowId]() {
+        if (Window* window = m_windowManager->windowById(windowId)) {
+            requestThumbnail(window);
+        }
+    }, Qt::QueuedConnection);
+    return QImage();
+}
+
+void ThumbnailCache::requestThumbnail(Window* window) {
+    if (!window || m_inFlight.contains(window->id())) return;
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(window->id());
+        if (it != m_entries.constEnd() && !it->stale) {
+            return;
+        }
+    }
+    
+    // CPU snapshots need a shared-memory buffer; GPU buffers keep their
+    // previous thumbnail until a render-thread readback path exists
+    QWaylandBufferRef buffer = window->currentBuffer();
+    if (!buffer.hasBuffer() || !buffer.isSharedMemory()) {
+        return;
+    }
+    
+    PULSE_TRACE_SCOPE("thumbnails", "requestThumbnail");
+    
+    const quint32 windowId = window->id();
+    const QImage source = buffer.image();
+    const QSize target = m_thumbnailSize;
+    m_inFlight.insert(windowId, buffer);
+    
+    auto* watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, windowId]() {
+        m_inFlight.remove(windowId);
+        if (m_windowManager->windowById(windowId)) {
+            insert(windowId, watcher->result());
+        }
+        watcher->deleteLater();
+    });
+    
+    watcher->setFuture(QtConcurrent::run([source, target]() {
+        PULSE_TRACE_SCOPE("thumbnails", "scale");
+        return source.scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }));
+}
+
+void ThumbnailCache::prepareOverview() {
+    PULSE_TRACE_SCOPE("thumbnails", "prepareOverview");
+    for (Window* window : m_windowManager->windows()) {
+        requestThumbnail(window);
+    }
+}
+
+void ThumbnailCache::setByteBudget(qint64 bytes) {
+    if (m_byteBudget == bytes) return;
+    
+    m_byteBudget = bytes;
+    {
+        QMutexLocker locker(&m_mutex);
+        evictToBudget();
+    }
+    emit statsChanged();
+}
+
+qint64 ThumbnailCache::bytesUsed() const {
+    QMutexLocker locker(&m_mutex);
+    return m_bytesUsed;
+}
+
+qint64 ThumbnailCache::bytesForWindow(quint32 windowId) const {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(windowId);
+    return it != m_entries.constEnd() ? it->bytes : 0;
+}
+
+int ThumbnailCache::count() const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+void ThumbnailCache::insert(quint32 windowId, const QImage& image) {
+    if (image.isNull()) return;
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(windowId);
+        if (it != m_entries.end()) {
+            m_bytesUsed -= it->bytes;
+            m_lru.erase(it->lru);
+            m_entries.erase(it);
+        }
+        
+        m_lru.push_front(windowId);
+        Entry entry;
+        entry.image = image;
+        entry.bytes = image.sizeInBytes();
+        entry.lru = m_lru.begin();
+        m_entries.insert(windowId, entry);
+        m_bytesUsed += entry.bytes;
+        
+        evictToBudget();
+        PULSE_TRACE_COUNTER("thumbnails", "bytes", m_bytesUsed);
+    }
+    
+    emit thumbnailReady(windowId);
+    emit statsChanged();
+}
+
+void ThumbnailCache::remove(quint32 windowId) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(windowId);
+    if (it == m_entries.end()) return;
+    
+    m_bytesUsed -= it->bytes;
+    m_lru.erase(it->lru);
+    m_entries.erase(it);
+}
+
+void ThumbnailCache::evictToBudget() {
+    // Caller holds m_mutex; always keep the most recent entry
+    while (m_bytesUsed > m_byteBudget && m_lru.size() > 1) {
+        quint32 victim = m_lru.back();
+        m_lru.pop_back();
+        m_bytesUsed -= m_entries.value(victim).bytes;
+        m_entries.remove(victim);
+    }
+}
+
+void ThumbnailCache::onWindowAdded(const WindowAdded& event) {
+    Window* window = event.window;
+    const quint32 windowId = window->id();
+    if (m_windows.contains(windowId)) return;
+    m_windows.insert(windowId);
+    
+    // New content makes the snapshot stale; it is refreshed on next request
+    if (QWaylandSurface* surface = window->surface()) {
+        connect(surface, &QWaylandSurface::redraw, this, [this, windowId]() {
+            QMutexLocker locker(&m_mutex);
+            auto it = m_entries.find(windowId);
+            if (it != m_entries.end()) {
+                it->stale = true;
+            }
+        });
+    }
+    
+    connect(window, &Window::stateChanged, this, [this, window](Window::State state) {
+        if (state == Window::State::Minimized) {
+            requestThumbnail(window);
+            m_minimizedSince.insert(window->id(), QDateTime::currentMSecsSinceEpoch());
+            if (!m_releaseTimer.isActive()) {
+                m_releaseTimer.start();
+            }
+        } else {
+            m_minimizedSince.remove(window->id());
+        }
+    });
+}
+
+void ThumbnailCache::onWindowRemoved(const WindowRemoved& event) {
+    Window* window = event.window;
+    // In-flight buffers stay referenced until their scale job completes
+    m_windows.remove(window->id());
+    m_minimizedSince.remove(window->id());
+    remove(window->id());
+    emit statsChanged();
+}
+
+void ThumbnailCache::releaseIdleBuffers() {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_minimizedSince.cbegin(); it != m_minimizedSince.cend(); ++it) {
+        if (now - it.value() < m_releaseDelayMs) continue;
+        
+        Window* window = m_windowManager->windowById(it.key());
+        if (!window || window->bufferReleased() || m_inFlight.contains(it.key())) continue;
+        
+        // Only drop the full-size buffer once a preview exists
+        bool hasThumbnail;
+        {
+            QMutexLocker locker(&m_mutex);
+            hasThumbnail = m_entries.contains(it.key());
+        }
+        if (hasThumbnail) {
+            window->releaseBuffer();
+        }
+    }
+    
+    if (m_minimizedSince.isEmpty()) {
+        m_releaseTimer.stop();
+    }
+}
+
+ThumbnailProvider::ThumbnailProvider(ThumbnailCache* cache)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_cache(cache) {
+}
+
+QImage ThumbnailProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize) {
+    QImage image = m_cache->thumbnail(id.toUInt());
+    if (!image.isNull() && requestedSize.isValid() && image.size() != requestedSize) {
+        image = image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    if (size) {
+        *size = image.size();
+    }
+    return image;
+}
+
+} // namespace Pulse
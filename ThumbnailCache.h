@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QQuickImageProvider>
+#include <QSet>
+#include <QTimer>
+#include <QWaylandBufferRef>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+#include <list>
+#include "WindowEvents.h"
+
+namespace Pulse {
+
+class Window;
+class WindowManager;
+
+// Downscaled window snapshots for overviews and task switchers, kept under
+// an LRU byte budget. Scaling runs on the global thread pool.
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by the compositor")
+    Q_PROPERTY(qint64 byteBudget READ byteBudget WRITE setByteBudget NOTIFY statsChanged)
+    Q_PROPERTY(qint64 bytesUsed READ bytesUsed NOTIFY statsChanged)
+    Q_PROPERTY(int count READ count NOTIFY statsChanged)
+    Q_PROPERTY(qint64 hits READ hits NOTIFY statsChanged)
+    Q_PROPERTY(qint64 misses READ misses NOTIFY statsChanged)
+    
+public:
+    explicit ThumbnailCache(WindowManager* windowManager, QObject* parent = nullptr);
+    ~ThumbnailCache();
+    
+    // Thread-safe lookup; a miss schedules a capture
+    QImage thumbnail(quint32 windowId);
+    
+    // Capture requests (GUI thread)
+    Q_INVOKABLE void requestThumbnail(Pulse::Window* window);
+    Q_INVOKABLE void prepareOverview();
+    
+    // Configuration
+    qint64 byteBudget() const { return m_byteBudget; }
+    void setByteBudget(qint64 bytes);
+    void setThumbnailSize(const QSize& size) { m_thumbnailSize = size; }
+    void setReleaseDelay(int ms) { m_releaseDelayMs = ms; }
+    
+    // Statistics
+    qint64 bytesUsed() const;
+    qint64 bytesForWindow(quint32 windowId) const;
+    int count() const;
+    qint64 hits() const { return m_hits.load(std::memory_order_relaxed); }
+    qint64 misses() const { return m_misses.load(std::memory_order_relaxed); }
+    
+signals:
+    void thumbnailReady(quint32 windowId);
+    void statsChanged();
+    
+private slots:
+    void releaseIdleBuffers();
+    
+private:
+    void onWindowAdded(const WindowAdded& event);
+    void onWindowRemoved(const WindowRemoved& event);
+    
+    struct Entry {
+        QImage image;
+        qint64 bytes = 0;
+        bool stale = false;
+        std::list<quint32>::iterator lru;
+    };
+    
+    void insert(quint32 windowId, const QImage& image);
+    void remove(quint32 windowId);
+    void evictToBudget();
+    
+    WindowManager* m_windowManager;
+    
+    // Guarded by m_mutex: the image provider reads from loader threads
+    mutable QMutex m_mutex;
+    QHash<quint32, Entry> m_entries;
+    std::list<quint32> m_lru;            // front = most recently used
+    qint64 m_bytesUsed = 0;
+    
+    // Buffers are held until their scale job finishes
+    QHash<quint32, QWaylandBufferRef> m_inFlight;
+    QHash<quint32, qint64> m_minimizedSince;
+    QTimer m_releaseTimer;
+    
+    // Windows hooked up by onWindowAdded, whether replayed or delivered
+    QSet<quint32> m_windows;
+    
+    qint64 m_byteBudget = 32 * 1024 * 1024;
+    QSize m_thumbnailSize = QSize(320, 200);
+    int m_releaseDelayMs = 30000;
+    
+    std::atomic<qint64> m_hits{0};
+    std::atomic<qint64> m_misses{0};
+};
+
+// Serves "image://thumbnails/<window id>"
+class ThumbnailProvider : public QQuickImageProvider {
+public:
+    explicit ThumbnailProvider(ThumbnailCache* cache);
+    
+    QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
+    
+private:
+    ThumbnailCache* m_cache;
+};
+
+} // namespace Pulse
@@ -0,0 +1,213 @@
+#include "TitleItem.h"
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGMaterial>
+#include <QSGMaterialShader>
+#include <QSGDynamicTexture>
+#include <cmath>
+#include <cstring>
+
+namespace Pulse {
+
+namespace {
+
+// Distance-field text over the shared atlas; must match titletext.vert/.frag
+class TitleMaterial : public QSGMaterial {
+public:
+    TitleMaterial() {
+        setFlag(Blending, true);
+    }
+    
+    QSGMaterialType* type() const override {
+        static QSGMaterialType type;
+        return &type;
+    }
+    
+    QSGMaterialShader* createShader(QSGRendererInterface::RenderMode renderMode) const override;
+    
+    int compare(const QSGMaterial* other) const override {
+        auto* material = static_cast<const TitleMaterial*>(other);
+        if (texture != material->texture) {
+            return texture < material->texture ? -1 : 1;
+        }
+        return color == material->color ? 0 : (color.rgba() < material->color.rgba() ? -1 : 1);
+    }
+    
+    QSGTexture* texture = nullptr;
+    QColor color = Qt::white;
+};
+
+class TitleShader : public QSGMaterialShader {
+public:
+    TitleShader() {
+        setShaderFileName(VertexStage, QStringLiteral(":/shaders/titletext.vert.qsb"));
+        setShaderFileName(FragmentStage, QStringLiteral(":/shaders/titletext.frag.qsb"));
+    }
+    
+    bool updateUniformData(RenderState& state, QSGMaterial* newMaterial,
+                           QSGMaterial* oldMaterial) override {
+        QByteArray* buffer = state.uniformData();
+        bool changed = false;
+        
+        if (state.isMatrixDirty()) {
+            std::memcpy(buffer->data(), state.combinedMatrix().constData(), 64);
+            changed = true;
+        }
+        if (state.isOpacityDirty()) {
+            const float opacity = state.opacity();
+            std::memcpy(buffer->data() + 64, &opacity, 4);
+            changed = true;
+        }
+        
+        auto* material = static_cast<TitleMaterial*>(newMaterial);
+        auto* previous = static_cast<TitleMaterial*>(oldMaterial);
+        if (!previous || previous->color != material->color) {
+            const float color[4] = { float(material->color.redF()), float(material->color.greenF()),
+                                     float(material->color.blueF()), float(material->color.alphaF()) };
+            std::memcpy(buffer->data() + 80, color, sizeof(color));
+            changed = true;
+        }
+        
+        return changed;
+    }
+    
+    void updateSampledImage(RenderState& state, int binding, QSGTexture** texture,
+                            QSGMaterial* newMaterial, QSGMaterial* oldMaterial) override {
+        Q_UNUSED(binding)
+        Q_UNUSED(oldMaterial)
+        
+        QSGTexture* atlas = static_cast<TitleMaterial*>(newMaterial)->texture;
+        if (auto* dynamic = qobject_cast<QSGDynamicTexture*>(atlas)) {
+            dynamic->updateTexture();
+        }
+        atlas->commitTextureOperations(state.rhi(), state.resourceUpdateBatch());
+        *texture = atlas;
+    }
+};
+
+QSGMaterialShader* TitleMaterial::createShader(QSGRendererInterface::RenderMode renderMode) const {
+    Q_UNUSED(renderMode)
+    return new TitleShader;
+}
+
+} // namespace
+
+TitleItem::TitleItem(QQuickItem* parent)
+    : QQuickItem(parent) {
+    setFlag(ItemHasContents, true);
+}
+
+TitleItem::~TitleItem() {
+}
+
+void TitleItem::setText(const QString& text) {
+    if (m_text != text) {
+        m_text = text;
+        emit textChanged(text);
+        polish();
+    }
+}
+
+void TitleItem::setFont(const QFont& font) {
+    if (m_font != font) {
+        m_font = font;
+        emit fontChanged(font);
+        polish();
+    }
+}
+
+void TitleItem::setColor(const QColor& color) {
+    if (m_color != color) {
+        m_color = color;
+        emit colorChanged(color);
+        update();
+    }
+}
+
+void TitleItem::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        polish();
+    }
+}
+
+void TitleItem::updatePolish() {
+    // A resize within the same width bucket returns the same run
+    if (m_text.isEmpty() || width() <= 0) {
+        m_shaped.reset();
+    } else {
+        m_shaped = TitleTextCache::instance()->shape(m_text, m_font, width());
+    }
+    update();
+}
+
+QSGNode* TitleItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) {
+    Q_UNUSED(data)
+    
+    // The GUI thread is blocked during sync, so m_shaped is stable here
+    if (!m_shaped) {
+        delete oldNode;
+        m_nodeShaped.reset();
+        return nullptr;
+    }
+    
+    auto* node = static_cast<QSGGeometryNode*>(oldNode);
+    if (!node) {
+        node = new QSGGeometryNode;
+        node->setGeometry(new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0, 0,
+                                          QSGGeometry::UnsignedShortType));
+        node->geometry()->setDrawingMode(QSGGeometry::DrawTriangles);
+        node->setFlag(QSGNode::OwnsGeometry);
+        
+        auto* material = new TitleMaterial;
+        material->texture = TitleTextCache::instance()->texture(window());
+        node->setMaterial(material);
+        node->setFlag(QSGNode::OwnsMaterial);
+        m_nodeShaped.reset();
+    }
+    
+    auto* material = static_cast<TitleMaterial*>(node->material());
+    if (material->color != m_color) {
+        material->color = m_color;
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
+    
+    // The same run at the same offset leaves the geometry untouched
+    const ShapedTitlePtr shaped = m_shaped;
+    const qreal offset = std::floor((height() - shaped->height) / 2);
+    if (shaped == m_nodeShaped && offset == m_nodeOffset) {
+        return node;
+    }
+    m_nodeShaped = shaped;
+    m_nodeOffset = offset;
+    
+    QSGGeometry* geometry = node->geometry();
+    geometry->allocate(shaped->glyphs.size() * 4, shaped->glyphs.size() * 6);
+    QSGGeometry::TexturedPoint2D* vertices = geometry->vertexDataAsTexturedPoint2D();
+    quint16* indices = geometry->indexDataAsUShort();
+    
+    for (int i = 0; i < shaped->glyphs.size(); ++i) {
+        const QRectF quad = shaped->glyphs[i].quad.translated(0, offset);
+        const QRectF source = shaped->glyphs[i].atlasRect;
+        
+        QSGGeometry::TexturedPoint2D* v = vertices + i * 4;
+        v[0].set(quad.left(), quad.top(), source.left(), source.top());
+        v[1].set(quad.right(), quad.top(), source.right(), source.top());
+        v[2].set(quad.left(), quad.bottom(), source.left(), source.bottom());
+        v[3].set(quad.right(), quad.bottom(), source.right(), source.bottom());
+        
+        const quint16 base = quint16(i * 4);
+        quint16* index = indices + i * 6;
+        index[0] = base;
+        index[1] = base + 1;
+        index[2] = base + 2;
+        index[3] = base + 1;
+        index[4] = base + 3;
+        index[5] = base + 2;
+    }
+    node->markDirty(QSGNode::DirtyGeometry);
+    
+    return node;
+}
+
+} // namespace Pulse
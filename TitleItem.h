@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QQuickItem>
+#include <QColor>
+#include <QFont>
+#include <QtQml/qqmlregistration.h>
+#include "TitleTextCache.h"
+
+namespace Pulse {
+
+// Window title drawn from TitleTextCache: cached shaped runs rendered as
+// quads over the shared glyph atlas. Shaping happens on the GUI thread in
+// updatePolish(); the render thread only builds geometry. Titles with the
+// same colour batch into one draw call across windows.
+class TitleItem : public QQuickItem {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(QString text READ text WRITE setText NOTIFY textChanged)
+    Q_PROPERTY(QFont font READ font WRITE setFont NOTIFY fontChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    
+public:
+    explicit TitleItem(QQuickItem* parent = nullptr);
+    ~TitleItem();
+    
+    QString text() const { return m_text; }
+    void setText(const QString& text);
+    
+    QFont font() const { return m_font; }
+    void setFont(const QFont& font);
+    
+    QColor color() const { return m_color; }
+    void setColor(const QColor& color);
+    
+signals:
+    void textChanged(const QString& text);
+    void fontChanged(const QFont& font);
+    void colorChanged(const QColor& color);
+    
+protected:
+    void updatePolish() override;
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+    
+private:
+    QString m_text;
+    QFont m_font;
+    QColor m_color = Qt::white;
+    
+    // GUI thread: the run for the current text, font and width
+    ShapedTitlePtr m_shaped;
+    
+    // Render thread: what the current geometry was built from
+    ShapedTitlePtr m_nodeShaped;
+    qreal m_nodeOffset = 0;
+};
+
+} // namespace Pulse
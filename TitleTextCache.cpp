@@ -0,0 +1,225 @@
+#include "TitleTextCache.h"
+#include "Tracer.h"
+#include <QFontMetricsF>
+#include <QGlyphRun>
+#include <QQuickWindow>
+#include <QSGDynamicTexture>
+#include <QTextLayout>
+#include <QDebug>
+#include <limits>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+#include <rhi/qrhi.h>
+#else
+#include <QtGui/private/qrhi_p.h>
+#endif
+
+namespace Pulse {
+
+namespace {
+
+// Elided titles are shaped per bucket of available width, not per pixel
+constexpr int kBucketWidth = 16;
+
+} // namespace
+
+// Stable per-window R8 texture over the atlas. The atlas is one byte per
+// texel, so it is uploaded directly instead of through
+// createTextureFromImage(), which expands every image to RGBA. When the
+// atlas grows the texture is replaced, but materials keep pointing at
+// this object.
+class TitleTextCache::AtlasTexture : public QSGDynamicTexture {
+public:
+    explicit AtlasTexture(TitleTextCache* cache)
+        : m_cache(cache) {
+        setFiltering(QSGTexture::Linear);
+    }
+    
+    ~AtlasTexture() {
+        delete m_texture;
+    }
+    
+    bool updateTexture() override {
+        QMutexLocker locker(&m_cache->m_mutex);
+        const quint64 generation = m_cache->m_atlas.generation();
+        if (generation == m_generation) {
+            return false;
+        }
+        
+        // Shared, not copied; the GUI thread detaches on its next glyph
+        m_pending = m_cache->m_atlas.image();
+        m_generation = generation;
+        return true;
+    }
+    
+    qint64 comparisonKey() const override { return qint64(quintptr(this)); }
+    QSize textureSize() const override { return m_texture ? m_texture->pixelSize() : QSize(1, 1); }
+    bool hasAlphaChannel() const override { return true; }
+    bool hasMipmaps() const override { return false; }
+    QRhiTexture* rhiTexture() const override { return m_texture; }
+    
+    void commitTextureOperations(QRhi* rhi, QRhiResourceUpdateBatch* resourceUpdates) override {
+        if (m_pending.isNull()) {
+            return;
+        }
+        
+        PULSE_TRACE_SCOPE("render", "uploadGlyphAtlas");
+        if (!m_texture || m_texture->pixelSize() != m_pending.size()) {
+            // Frames in flight may still sample the old one
+            if (m_texture) {
+                m_texture->deleteLater();
+            }
+            m_texture = rhi->newTexture(QRhiTexture::R8, m_pending.size());
+            if (!m_texture->create()) {
+                qWarning() << "Failed to create the glyph atlas texture";
+                delete m_texture;
+                m_texture = nullptr;
+                m_pending = QImage();
+                return;
+            }
+        }
+        resourceUpdates->uploadTexture(m_texture, m_pending);
+        m_pending = QImage();
+    }
+    
+private:
+    TitleTextCache* m_cache;
+    QRhiTexture* m_texture = nullptr;
+    QImage m_pending;
+    quint64 m_generation = 0;
+};
+
+TitleTextCache* TitleTextCache::instance() {
+    static TitleTextCache instance;
+    return &instance;
+}
+
+TitleTextCache::TitleTextCache(QObject* parent)
+    : QObject(parent) {
+}
+
+TitleTextCache::~TitleTextCache() {
+}
+
+int TitleTextCache::count() const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+void TitleTextCache::prewarm(const QFont& font) {
+    PULSE_TRACE_SCOPE("render", "prewarmGlyphAtlas");
+    
+    QString ascii;
+    for (char c = 0x21; c < 0x7f; ++c) {
+        ascii.append(QLatin1Char(c));
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    m_atlas.prewarm(QRawFont::fromFont(font), ascii);
+    qDebug() << "Glyph atlas prewarmed with" << m_atlas.count() << "glyphs";
+}
+
+ShapedTitlePtr TitleTextCache::shape(const QString& text, const QFont& font, qreal maxWidth) {
+    QMutexLocker locker(&m_mutex);
+    const QString fontKey = font.key();
+    
+    // The unelided run also tells us whether the title needs eliding at all
+    const Key fullKey{text, fontKey, -1};
+    ShapedTitlePtr full = lookup(fullKey);
+    if (!full) {
+        full = layout(text, font, false);
+        insert(fullKey, full);
+    }
+    if (full->width <= maxWidth) {
+        return full;
+    }
+    
+    const int bucket = qMax(0, int(maxWidth) / kBucketWidth * kBucketWidth);
+    const Key key{text, fontKey, bucket};
+    if (ShapedTitlePtr elided = lookup(key)) {
+        return elided;
+    }
+    
+    ShapedTitlePtr elided = layout(QFontMetricsF(font).elidedText(text, Qt::ElideRight, bucket), font, true);
+    insert(key, elided);
+    return elided;
+}
+
+ShapedTitlePtr TitleTextCache::lookup(const Key& key) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    m_lru.splice(m_lru.begin(), m_lru, it->lru);
+    return it->title;
+}
+
+void TitleTextCache::insert(const Key& key, const ShapedTitlePtr& title) {
+    m_lru.push_front(key);
+    m_entries.insert(key, {title, m_lru.begin()});
+    
+    while (m_entries.size() > m_capacity) {
+        m_entries.remove(m_lru.back());
+        m_lru.pop_back();
+    }
+    
+    QMetaObject::invokeMethod(this, &TitleTextCache::statsChanged, Qt::QueuedConnection);
+}
+
+ShapedTitlePtr TitleTextCache::layout(const QString& text, const QFont& font, bool elided) {
+    PULSE_TRACE_SCOPE("render", "shapeTitle");
+    
+    QTextLayout textLayout(text, font);
+    textLayout.beginLayout();
+    QTextLine line = textLayout.createLine();
+    if (line.isValid()) {
+        line.setLineWidth(std::numeric_limits<int>::max());
+    }
+    textLayout.endLayout();
+    
+    auto title = std::make_shared<ShapedTitle>();
+    title->elided = elided;
+    if (!line.isValid()) {
+        return title;
+    }
+    title->width = line.naturalTextWidth();
+    title->height = line.height();
+    
+    for (const QGlyphRun& run : textLayout.glyphRuns()) {
+        const QRawFont rawFont = run.rawFont();
+        const qreal scale = rawFont.pixelSize() / GlyphAtlas::kBaseSize;
+        const QList<quint32> indexes = run.glyphIndexes();
+        const QList<QPointF> positions = run.positions();
+        
+        for (int i = 0; i < indexes.size(); ++i) {
+            const GlyphAtlas::Glyph& glyph = m_atlas.glyph(rawFont, indexes[i]);
+            if (!glyph.valid) continue;
+            
+            title->glyphs.append({
+                QRectF(positions[i] + glyph.offset * scale, QSizeF(glyph.atlasRect.size()) * scale),
+                QRectF(glyph.atlasRect)
+            });
+        }
+    }
+    
+    return title;
+}
+
+QSGTexture* TitleTextCache::texture(QQuickWindow* window) {
+    QMutexLocker locker(&m_mutex);
+    AtlasTexture*& texture = m_textures[window];
+    if (!texture) {
+        texture = new AtlasTexture(this);
+        
+        // Scene graph resources die with the scene graph, on the render thread
+        connect(window, &QQuickWindow::sceneGraphInvalidated, this, [this, window]() {
+            QMutexLocker locker(&m_mutex);
+            delete m_textures.take(window);
+        }, Qt::DirectConnection);
+    }
+    return texture;
+}
+
+} // namespace Pulse
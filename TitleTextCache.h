@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QObject>
+#include <QFont>
+#include <QHash>
+#include <QMutex>
+#include <QRectF>
+#include <QVector>
+#include <atomic>
+#include <list>
+#include <memory>
+#include "GlyphAtlas.h"
+
+class QQuickWindow;
+class QSGTexture;
+
+namespace Pulse {
+
+// Title text laid out once and reduced to atlas quads
+struct ShapedTitle {
+    struct Glyph {
+        QRectF quad;            // item coordinates, line top at y = 0
+        QRectF atlasRect;       // atlas pixels
+    };
+    
+    QVector<Glyph> glyphs;
+    qreal width = 0;
+    qreal height = 0;
+    bool elided = false;
+};
+
+using ShapedTitlePtr = std::shared_ptr<const ShapedTitle>;
+
+// Compositor-wide cache of shaped window titles, keyed by text, font and
+// elision width bucket, with an LRU bound. Resizing or re-tiling windows
+// only changes which cached run is drawn; titles are reshaped when the text
+// changes or the width crosses a bucket the title does not fit in.
+class TitleTextCache : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY statsChanged)
+    Q_PROPERTY(qint64 hits READ hits NOTIFY statsChanged)
+    Q_PROPERTY(qint64 misses READ misses NOTIFY statsChanged)
+    
+public:
+    static TitleTextCache* instance();
+    
+    // GUI thread, from items' updatePolish(). Locks out the render
+    // thread's atlas upload while glyphs are added.
+    ShapedTitlePtr shape(const QString& text, const QFont& font, qreal maxWidth);
+    
+    // Rasterises the printable ASCII range for font into the atlas
+    void prewarm(const QFont& font);
+    
+    // Render thread: the atlas texture for window, kept current as glyphs are added
+    QSGTexture* texture(QQuickWindow* window);
+    
+    void setCapacity(int entries) { m_capacity = entries; }
+    int count() const;
+    qint64 hits() const { return m_hits.load(std::memory_order_relaxed); }
+    qint64 misses() const { return m_misses.load(std::memory_order_relaxed); }
+    
+signals:
+    void statsChanged();
+    
+private:
+    explicit TitleTextCache(QObject* parent = nullptr);
+    ~TitleTextCache();
+    
+    class AtlasTexture;
+    
+    struct Key {
+        QString text;
+        QString font;
+        int bucket;             // -1: unelided
+        
+        bool operator==(const Key& other) const {
+            return bucket == other.bucket && text == other.text && font == other.font;
+        }
+    };
+    friend size_t qHash(const Key& key, size_t seed) {
+        return qHashMulti(seed, key.text, key.font, key.bucket);
+    }
+    
+    struct Entry {
+        ShapedTitlePtr title;
+        std::list<Key>::iterator lru;
+    };
+    
+    ShapedTitlePtr lookup(const Key& key);
+    ShapedTitlePtr layout(const QString& text, const QFont& font, bool elided);
+    void insert(const Key& key, const ShapedTitlePtr& title);
+    
+    mutable QMutex m_mutex;
+    GlyphAtlas m_atlas;
+    QHash<Key, Entry> m_entries;
+    std::list<Key> m_lru;               // front = most recently used
+    int m_capacity = 512;
+    QHash<QQuickWindow*, AtlasTexture*> m_textures;
+    
+    std::atomic<qint64> m_hits{0};
+    std::atomic<qint64> m_misses{0};
+};
+
+} // namespace Pulse
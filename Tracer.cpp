@@ -0,0 +1,455 @@
+#include "Tracer.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDBusConnection>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Pulse {
+
+namespace {
+
+constexpr size_t kEventsPerThread = 16384;
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    qint64 timestamp;
+    qint64 value;       // duration for 'X', sample for 'C'
+    char phase;         // 'B', 'E', 'X' or 'C'
+};
+
+// Written only by its owning thread; read by the exporter
+struct ThreadBuffer {
+    quint64 tid = 0;
+    QByteArray threadName;
+    std::atomic<quint32> generation{0};
+    std::atomic<size_t> count{0};
+    std::atomic<quint64> dropped{0};
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[kEventsPerThread]};
+};
+
+QMutex s_registryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> s_registry;
+std::atomic<quint32> s_generation{1};
+
+thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+
+ThreadBuffer* threadBuffer() {
+    if (!t_buffer) {
+        t_buffer = std::make_shared<ThreadBuffer>();
+        t_buffer->tid = static_cast<quint64>(::syscall(SYS_gettid));
+        
+        QThread* thread = QThread::currentThread();
+        QString name = thread ? thread->objectName() : QString();
+        if (name.isEmpty()) {
+            QCoreApplication* app = QCoreApplication::instance();
+            name = (thread && app && thread == app->thread())
+                ? QStringLiteral("GUI") : QStringLiteral("Thread %1").arg(t_buffer->tid);
+        }
+        t_buffer->threadName = name.toUtf8();
+        
+        QMutexLocker locker(&s_registryMutex);
+        s_registry.push_back(t_buffer);
+    }
+    return t_buffer.get();
+}
+
+void record(const char* category, const char* name, qint64 timestamp, qint64 value, char phase) {
+    ThreadBuffer* buffer = threadBuffer();
+    
+    // A new recording session resets the buffer lazily from its owning thread
+    quint32 generation = s_generation.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+    
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= kEventsPerThread) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    buffer->events[index] = TraceEvent{category, name, timestamp, value, phase};
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+struct Snapshot {
+    quint64 tid;
+    QByteArray threadName;
+    std::vector<TraceEvent> events;
+};
+
+std::vector<Snapshot> collect() {
+    std::vector<Snapshot> result;
+    quint32 generation = s_generation.load(std::memory_order_acquire);
+    
+    QMutexLocker locker(&s_registryMutex);
+    for (const auto& buffer : s_registry) {
+        if (buffer->generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        if (count == 0) {
+            continue;
+        }
+        Snapshot snapshot{buffer->tid, buffer->threadName, {}};
+        snapshot.events.assign(buffer->events.get(), buffer->events.get() + count);
+        result.push_back(std::move(snapshot));
+    }
+    return result;
+}
+
+void appendJsonString(QByteArray& out, const char* text) {
+    out.append('"');
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out.append('\\');
+        }
+        out.append(*c);
+    }
+    out.append('"');
+}
+
+QByteArray toChromeJson(const std::vector<Snapshot>& threads) {
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray out;
+    out.reserve(1 << 20);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) out.append(",\n");
+        first = false;
+    };
+    
+    for (const Snapshot& thread : threads) {
+        separator();
+        out.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":");
+        out.append(QByteArray::number(pid));
+        out.append(",\"tid\":");
+        out.append(QByteArray::number(thread.tid));
+        out.append(",\"args\":{\"name\":");
+        appendJsonString(out, thread.threadName.constData());
+        out.append("}}");
+        
+        for (const TraceEvent& event : thread.events) {
+            separator();
+            out.append("{\"ph\":\"");
+            out.append(event.phase);
+            out.append("\",\"cat\":");
+            appendJsonString(out, event.category);
+            out.append(",\"name\":");
+            appendJsonString(out, event.name);
+            out.append(",\"pid\":");
+            out.append(QByteArray::number(pid));
+            out.append(",\"tid\":");
+            out.append(QByteArray::number(thread.tid));
+            out.append(",\"ts\":");
+            out.append(QByteArray::number(event.timestamp / 1000.0, 'f', 3));
+            if (event.phase == 'X') {
+                out.append(",\"dur\":");
+                out.append(QByteArray::number(event.value / 1000.0, 'f', 3));
+            } else if (event.phase == 'C') {
+                out.append(",\"args\":{\"value\":");
+                out.append(QByteArray::number(event.value));
+                out.append('}');
+            }
+            out.append('}');
+        }
+    }
+    
+    out.append("]}\n");
+    return out;
+}
+
+// Minimal protobuf encoding of perfetto.protos.Trace
+void putVarint(QByteArray& out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+void putUInt(QByteArray& out, int field, quint64 value) {
+    putVarint(out, quint64(field) << 3);
+    putVarint(out, value);
+}
+
+void putBytes(QByteArray& out, int field, const QByteArray& bytes) {
+    putVarint(out, (quint64(field) << 3) | 2);
+    putVarint(out, bytes.size());
+    out.append(bytes);
+}
+
+enum TrackEventType : quint64 {
+    SliceBegin = 1,
+    SliceEnd = 2,
+    Counter = 4
+};
+
+constexpr quint64 kClockMonotonic = 3;
+constexpr quint64 kSequenceId = 1;
+constexpr quint64 kCounterTrackBase = 1ull << 40;
+
+QByteArray toPerfetto(const std::vector<Snapshot>& threads) {
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray out;
+    out.reserve(1 << 20);
+    
+    auto packet = [&](quint64 timestamp, const QByteArray& body, bool first = false) {
+        QByteArray p;
+        if (timestamp) {
+            putUInt(p, 8, timestamp);
+            putUInt(p, 58, kClockMonotonic);
+        }
+        putUInt(p, 10, kSequenceId);
+        if (first) {
+            putUInt(p, 13, 1); // SEQ_INCREMENTAL_STATE_CLEARED
+        }
+        p.append(body);
+        putBytes(out, 1, p);
+    };
+    
+    auto trackEvent = [](TrackEventType type, quint64 track, const TraceEvent& event) {
+        QByteArray e;
+        putUInt(e, 9, type);
+        putUInt(e, 11, track);
+        if (type != SliceEnd) {
+            putBytes(e, 22, QByteArray(event.category));
+            putBytes(e, 23, QByteArray(event.name));
+        }
+        if (type == Counter) {
+            putUInt(e, 30, quint64(event.value));
+        }
+        QByteArray body;
+        putBytes(body, 11, e);
+        return body;
+    };
+    
+    // Track descriptors: one per thread, one per counter name
+    QHash<QByteArray, quint64> counterTracks;
+    bool first = true;
+    for (const Snapshot& thread : threads) {
+        QByteArray threadDescriptor;
+        putUInt(threadDescriptor, 1, quint64(pid));
+        putUInt(threadDescriptor, 2, thread.tid);
+        putBytes(threadDescriptor, 5, thread.threadName);
+        
+        QByteArray track;
+        putUInt(track, 1, thread.tid);
+        putBytes(track, 4, threadDescriptor);
+        
+        QByteArray body;
+        putBytes(body, 60, track);
+        packet(0, body, first);
+        first = false;
+        
+        for (const TraceEvent& event : thread.events) {
+            if (event.phase != 'C' || counterTracks.contains(event.name)) {
+                continue;
+            }
+            quint64 uuid = kCounterTrackBase + counterTracks.size();
+            counterTracks.insert(event.name, uuid);
+            
+            QByteArray counterTrack;
+            putUInt(counterTrack, 1, uuid);
+            putBytes(counterTrack, 2, QByteArray(event.name));
+            putBytes(counterTrack, 8, QByteArray());
+            
+            QByteArray counterBody;
+            putBytes(counterBody, 60, counterTrack);
+            packet(0, counterBody);
+        }
+    }
+    
+    // Complete events are split into begin/end pairs and ordered so that
+    // slices ending or starting on the same timestamp still nest correctly
+    struct Item {
+        qint64 timestamp;
+        int rank;
+        qint64 tiebreak;
+        const TraceEvent* event;
+        quint64 track;
+        TrackEventType type;
+    };
+    std::vector<Item> items;
+    for (const Snapshot& thread : threads) {
+        for (const TraceEvent& event : thread.events) {
+            switch (event.phase) {
+            case 'X':
+                items.push_back({event.timestamp, 1, -event.value, &event, thread.tid, SliceBegin});
+                items.push_back({event.timestamp + event.value, 0, -event.timestamp, &event, thread.tid, SliceEnd});
+                break;
+            case 'B':
+                items.push_back({event.timestamp, 1, 0, &event, thread.tid, SliceBegin});
+                break;
+            case 'E':
+                items.push_back({event.timestamp, 0, 0, &event, thread.tid, SliceEnd});
+                break;
+            case 'C':
+                items.push_back({event.timestamp, 2, 0, &event, counterTracks.value(event.name), Counter});
+                break;
+            }
+        }
+    }
+    std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        if (a.timestamp != b.timestamp) return a.timestamp < b.timestamp;
+        if (a.rank != b.rank) return a.rank < b.rank;
+        return a.tiebreak < b.tiebreak;
+    });
+    
+    for (const Item& item : items) {
+        packet(quint64(item.timestamp), trackEvent(item.type, item.track, *item.event));
+    }
+    
+    return out;
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::s_enabled{false};
+
+class Tracer::Private {
+public:
+    bool dbusRegistered = false;
+    qint64 sessionStart = 0;
+};
+
+Tracer* Tracer::instance() {
+    static Tracer instance;
+    return &instance;
+}
+
+Tracer::Tracer(QObject* parent)
+    : QObject(parent)
+    , d(std::make_unique<Private>()) {
+}
+
+Tracer::~Tracer() {
+}
+
+qint64 Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::begin(const char* category, const char* name) {
+    if (enabled()) {
+        record(category, name, now(), 0, 'B');
+    }
+}
+
+void Tracer::end(const char* category, const char* name) {
+    if (enabled()) {
+        record(category, name, now(), 0, 'E');
+    }
+}
+
+void Tracer::complete(const char* category, const char* name, qint64 start, qint64 duration) {
+    record(category, name, start, duration, 'X');
+}
+
+void Tracer::counter(const char* category, const char* name, qint64 value) {
+    record(category, name, now(), value, 'C');
+}
+
+void Tracer::start() {
+    if (enabled()) {
+        return;
+    }
+    
+    s_generation.fetch_add(1, std::memory_order_acq_rel);
+    d->sessionStart = now();
+    s_enabled.store(true, std::memory_order_release);
+    emit recordingChanged(true);
+    qDebug() << "Tracing started";
+}
+
+void Tracer::stop() {
+    if (!enabled()) {
+        return;
+    }
+    
+    s_enabled.store(false, std::memory_order_release);
+    emit recordingChanged(false);
+    qDebug() << "Tracing stopped after" << (now() - d->sessionStart) / 1000000 << "ms";
+}
+
+bool Tracer::exportTo(const QString& filePath, Format format) const {
+    std::vector<Snapshot> threads = collect();
+    QByteArray data = (format == Format::Perfetto) ? toPerfetto(threads) : toChromeJson(threads);
+    
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to open trace file:" << filePath;
+        return false;
+    }
+    
+    file.write(data);
+    qDebug() << "Trace written to" << filePath << "threads:" << threads.size();
+    return true;
+}
+
+bool Tracer::exportOnDBus() {
+    if (d->dbusRegistered) {
+        return true;
+    }
+    
+    d->dbusRegistered = QDBusConnection::sessionBus().registerObject(
+        "/org/pulse/Tracer", this,
+        QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportScriptableSignals |
+        QDBusConnection::ExportScriptableProperties);
+        
+    if (!d->dbusRegistered) {
+        qWarning() << "Failed to register tracer on DBus";
+    }
+    return d->dbusRegistered;
+}
+
+bool Tracer::capture(int durationMs, const QString& filePath, const QString& format) {
+    if (enabled() || durationMs <= 0) {
+        return false;
+    }
+    
+    Format traceFormat = format.compare("perfetto", Qt::CaseInsensitive) == 0
+        ? Format::Perfetto : Format::ChromeJson;
+    
+    QString path = filePath;
+    if (path.isEmpty()) {
+        path = QDir::temp().filePath(QString("pulse-trace-%1.%2")
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"),
+                 traceFormat == Format::Perfetto ? "pftrace" : "json"));
+    }
+    
+    start();
+    QTimer::singleShot(durationMs, this, [this, path, traceFormat]() {
+        stop();
+        if (exportTo(path, traceFormat)) {
+            emit captureFinished(path);
+        }
+    });
+    return true;
+}
+
+QString Tracer::status() const {
+    if (!enabled()) {
+        return "idle";
+    }
+    return QString("recording for %1 ms").arg((now() - d->sessionStart) / 1000000);
+}
+
+} // namespace Pulse
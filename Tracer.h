@@ -0,0 +1,105 @@
+#pragma once
+
+#include "AllocationCounter.h"
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+namespace Pulse {
+
+// Low-overhead span/counter recorder. Events go into per-thread buffers and
+// are exported on demand as Chrome trace JSON or Perfetto protobuf.
+// Category and name arguments must be string literals (only the pointer is stored).
+class Tracer : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.pulse.Tracer")
+    Q_PROPERTY(bool recording READ isRecording NOTIFY recordingChanged)
+    
+public:
+    enum class Format {
+        ChromeJson,
+        Perfetto
+    };
+    Q_ENUM(Format)
+    
+    // Singleton instance
+    static Tracer* instance();
+    
+    // Hot path: a single relaxed load when tracing is off
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static qint64 now();
+    
+    // Recording
+    static void begin(const char* category, const char* name);
+    static void end(const char* category, const char* name);
+    static void complete(const char* category, const char* name, qint64 start, qint64 duration);
+    static void counter(const char* category, const char* name, qint64 value);
+    
+    // Control
+    void start();
+    void stop();
+    bool isRecording() const { return enabled(); }
+    bool exportTo(const QString& filePath, Format format) const;
+    
+    // Publish this object on the session bus at /org/pulse/Tracer
+    bool exportOnDBus();
+    
+public slots:
+    // Record for durationMs, then write the trace. format is "json" or "perfetto".
+    Q_SCRIPTABLE bool capture(int durationMs, const QString& filePath, const QString& format);
+    Q_SCRIPTABLE QString status() const;
+    
+signals:
+    void recordingChanged(bool recording);
+    Q_SCRIPTABLE void captureFinished(const QString& filePath);
+    
+private:
+    explicit Tracer(QObject* parent = nullptr);
+    ~Tracer();
+    
+    class Private;
+    std::unique_ptr<Private> d;
+    
+    static std::atomic<bool> s_enabled;
+};
+
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : m_category(category)
+        , m_name(name)
+        , m_start(Tracer::enabled() ? Tracer::now() : 0) {
+    }
+    
+    ~TraceScope() {
+        if (m_start && Tracer::enabled()) {
+            Tracer::complete(m_category, m_name, m_start, Tracer::now() - m_start);
+        }
+    }
+    
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    
+private:
+    const char* m_category;
+    const char* m_name;
+    qint64 m_start;
+};
+
+} // namespace Pulse
+
+#define PULSE_TRACE_CONCAT_(a, b) a##b
+#define PULSE_TRACE_CONCAT(a, b) PULSE_TRACE_CONCAT_(a, b)
+
+// Also charges heap allocations in the scope to the category
+// (diagnostics builds, see AllocationCounter)
+#define PULSE_TRACE_SCOPE(category, name) \
+    PULSE_ALLOCATION_SCOPE(category); \
+    ::Pulse::TraceScope PULSE_TRACE_CONCAT(pulseTraceScope_, __LINE__)(category, name)
+
+#define PULSE_TRACE_COUNTER(category, name, value) \
+    do { \
+        if (::Pulse::Tracer::enabled()) \
+            ::Pulse::Tracer::counter(category, name, value); \
+    } while (0)
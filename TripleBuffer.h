@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Pulse {
+
+// Lock-free latest-value exchange between one writer and one reader thread.
+// The writer fills writeBuffer() completely and publishes it; the reader
+// always sees the most recently published complete value.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side. The slot may hold stale data from an earlier round, so
+    // overwrite it fully (clearing containers keeps their capacity).
+    T& writeBuffer() { return m_slots[m_writeIndex]; }
+    
+    void publish() {
+        const uint8_t previous = m_middle.exchange(m_writeIndex | kFresh, std::memory_order_acq_rel);
+        m_writeIndex = previous & kIndexMask;
+    }
+    
+    // Reader side
+    const T& read() {
+        if (m_middle.load(std::memory_order_relaxed) & kFresh) {
+            const uint8_t previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+            m_readIndex = previous & kIndexMask;
+        }
+        return m_slots[m_readIndex];
+    }
+    
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+    
+    T m_slots[3]{};
+    std::atomic<uint8_t> m_middle{1};
+    uint8_t m_writeIndex = 0;   // writer-owned
+    uint8_t m_readIndex = 2;    // reader-owned
+};
+
+} // namespace Pulse
@@ -1,63 +1,291 @@
 #include "Window.h"
+#include "Tracer.h"
 #include <QWaylandSurface>
 #include <QDebug>
+#include <algorithm>
 
 namespace Pulse {
 
 quint32 Window::s_nextId = 1;
 
-Window::Window(QWaylandSurface* surface, QObject* parent)
+// How long to wait for a client to commit a configured size before moving on
+static constexpr int kConfigureTimeoutMs = 250;
+
+Window::Window(QWaylandSurface* surface, WindowStore* store, QObject* parent)
     : QObject(parent)
     , m_surface(surface)
+    , m_store(store)
     , m_id(s_nextId++) {
     
+    m_handle = m_store->insert(m_id);
+    
     // Initial geometry
-    m_geometry = QRect(100, 100, 800, 600);
+    m_store->setGeometry(m_handle, QRect(100, 100, 800, 600));
+    
+    // Placeholder until the client sets an xdg-toplevel title
+    m_title = surface && surface->client()
+        ? QString("Window %1 - PID %2").arg(m_id).arg(surface->client()->processId())
+        : QString("Untitled");
+    
+    m_configureTimer.setSingleShot(true);
+    m_configureTimer.setInterval(kConfigureTimeoutMs);
+    connect(&m_configureTimer, &QTimer::timeout, this, &Window::onConfigureTimeout);
+    
+    if (m_surface) {
+        // Our own view keeps a reference to the latest committed buffer
+        m_view.setSurface(m_surface);
+        connect(m_surface, &QWaylandSurface::redraw, this, &Window::onSurfaceCommitted);
+    }
     
     qDebug() << "Window created:" << m_id << "for surface:" << surface;
 }
 
 Window::~Window() {
+    m_store->remove(m_handle);
     qDebug() << "Window destroyed:" << m_id;
 }
 
-QString Window::title() const {
-    if (!m_surface) return "Untitled";
+void Window::setToplevel(QWaylandXdgToplevel* toplevel) {
+    if (m_toplevel == toplevel) return;
+    
+    if (m_toplevel) {
+        disconnect(m_toplevel, nullptr, this, nullptr);
+    }
     
-    // Try to get title from surface
-    // In real implementation, this would come from xdg-toplevel
-    return QString("Window %1 - PID %2").arg(m_id).arg(m_surface->client()->processId());
+    m_toplevel = toplevel;
+    
+    if (m_toplevel) {
+        connect(m_toplevel, &QWaylandXdgToplevel::titleChanged, this, &Window::updateTitle);
+        connect(m_toplevel, &QWaylandXdgToplevel::appIdChanged, this, &Window::updateAppId);
+        
+        // Emitted when the client acks a configure that changes states;
+        // size-only configures are matched on the next commit
+        connect(m_toplevel, &QWaylandXdgToplevel::statesChanged, this, &Window::checkConfigureAcked);
+        updateTitle();
+        updateAppId();
+        
+        // Clients send app id and title right after creating the toplevel;
+        // configure once those requests have been dispatched
+        QTimer::singleShot(0, this, &Window::sendInitialConfigure);
+    }
+}
+
+void Window::updateTitle() {
+    if (!m_toplevel || m_toplevel->title().isEmpty() || m_toplevel->title() == m_title) {
+        return;
+    }
+    m_title = m_toplevel->title();
+    emit titleChanged(m_title);
+}
+
+void Window::updateAppId() {
+    if (!m_toplevel || m_toplevel->appId() == m_appId) {
+        return;
+    }
+    m_appId = m_toplevel->appId();
+    emit appIdChanged(m_appId);
 }
 
 void Window::setGeometry(const QRect& geometry) {
-    if (m_geometry != geometry) {
-        m_geometry = geometry;
+    if (this->geometry() != geometry) {
+        PULSE_TRACE_SCOPE("window", "setGeometry");
+        m_store->setGeometry(m_handle, geometry);
         emit geometryChanged(geometry);
         qDebug() << "Window" << m_id << "geometry changed:" << geometry;
     }
 }
 
+void Window::requestGeometry(const QRect& geometry) {
+    // Until the initial configure has gone out the geometry is only
+    // recorded; sendInitialConfigure() sends it whatever its size
+    if (!m_toplevel || !m_initialConfigureSent) {
+        setGeometry(geometry);
+        return;
+    }
+    
+    // Pure moves need no client round trip
+    if (!m_configureInFlight && !m_hasPendingConfigure && geometry.size() == this->geometry().size()) {
+        setGeometry(geometry);
+        return;
+    }
+    
+    m_pendingGeometry = geometry;
+    m_hasPendingConfigure = true;
+    flushConfigure();
+}
+
+void Window::flushConfigure() {
+    if (!m_toplevel || m_configureInFlight || !m_hasPendingConfigure) {
+        return;
+    }
+    
+    PULSE_TRACE_SCOPE("window", "sendConfigure");
+    m_hasPendingConfigure = false;
+    m_configuredGeometry = m_pendingGeometry;
+    m_configuredStates = toplevelStates();
+    m_configureSerial = m_toplevel->sendConfigure(clientSize(m_configuredGeometry), m_configuredStates);
+    m_configureInFlight = true;
+    m_initialConfigureSent = true;
+    m_configureTimer.start();
+}
+
+void Window::sendInitialConfigure() {
+    if (!m_toplevel || m_initialConfigureSent) return;
+    
+    // Listeners may place the window; that only updates the geometry
+    emit placementNeeded();
+    
+    // Always sent: xdg-shell clients do not map before their first configure
+    m_pendingGeometry = geometry();
+    m_hasPendingConfigure = true;
+    flushConfigure();
+}
+
+void Window::onSurfaceCommitted() {
+    m_view.advance();
+    m_bufferReleased = false;
+    
+    if (m_configureInFlight) {
+        checkConfigureAcked();
+        return;
+    }
+    
+    // Client-initiated resize: follow the content so decorations stay in sync
+    const QSize committed = committedSize();
+    if (m_toplevel && !committed.isEmpty() && committed != clientSize(geometry())) {
+        setGeometry(QRect(geometry().topLeft(),
+                          committed + QSize(2 * borderSize(), titleBarHeight() + borderSize())));
+    }
+}
+
+void Window::checkConfigureAcked() {
+    if (!m_configureInFlight || !m_toplevel) {
+        return;
+    }
+    
+    // Qt keeps the acked serial private, but the toplevel's states are
+    // those of the last acked configure. Apply decoration and content
+    // geometry together once the client has acked our states and drawn
+    // the configured size.
+    QList<QWaylandXdgToplevel::State> acked = m_toplevel->states();
+    QList<QWaylandXdgToplevel::State> configured = m_configuredStates;
+    std::sort(acked.begin(), acked.end());
+    std::sort(configured.begin(), configured.end());
+    if (acked != configured || committedSize() != clientSize(m_configuredGeometry)) {
+        return;
+    }
+    
+    m_configureTimer.stop();
+    m_configureInFlight = false;
+    setGeometry(m_configuredGeometry);
+    flushConfigure();
+}
+
+QSize Window::committedSize() const {
+    // The xdg window geometry excludes client-side shadows and falls back
+    // to the surface bounds when the client sets none
+    if (m_toplevel && m_toplevel->xdgSurface()) {
+        const QRect windowGeometry = m_toplevel->xdgSurface()->windowGeometry();
+        if (windowGeometry.isValid()) return windowGeometry.size();
+    }
+    return m_surface ? m_surface->destinationSize() : QSize();
+}
+
+void Window::onConfigureTimeout() {
+    if (!m_configureInFlight) {
+        return;
+    }
+    
+    // The client did not honour the size (fixed-size or unresponsive);
+    // keep the requested position around whatever it last committed
+    qDebug() << "Window" << m_id << "configure" << m_configureSerial << "timed out";
+    m_configureInFlight = false;
+    
+    const QSize committed = committedSize();
+    QRect geometry = m_configuredGeometry;
+    if (!committed.isEmpty()) {
+        geometry.setSize(committed + QSize(2 * borderSize(), titleBarHeight() + borderSize()));
+    }
+    setGeometry(geometry);
+    flushConfigure();
+}
+
+void Window::scheduleStateConfigure() {
+    // Before the initial configure state changes are only queued: it is
+    // built from the window's state when it goes out
+    if (!m_initialConfigureSent) {
+        return;
+    }
+    
+    // States ride along with the next configure; keep the latest size
+    if (m_toplevel && !m_hasPendingConfigure) {
+        m_pendingGeometry = m_configureInFlight ? m_configuredGeometry : geometry();
+        m_hasPendingConfigure = true;
+        flushConfigure();
+    }
+}
+
+QList<QWaylandXdgToplevel::State> Window::toplevelStates() const {
+    QList<QWaylandXdgToplevel::State> states;
+    const State current = state();
+    if (current == State::Maximized) {
+        states.append(QWaylandXdgToplevel::MaximizedState);
+    } else if (current == State::Fullscreen) {
+        states.append(QWaylandXdgToplevel::FullscreenState);
+    }
+    if (focused()) {
+        states.append(QWaylandXdgToplevel::ActivatedState);
+    }
+    return states;
+}
+
 void Window::setFocused(bool focused) {
-    if (m_focused != focused) {
-        m_focused = focused;
+    if (this->focused() != focused) {
+        const quint8 flags = m_store->flags(m_handle);
+        m_store->setFlags(m_handle, focused ? flags | WindowStore::Focused : flags & ~WindowStore::Focused);
         emit focusedChanged(focused);
         qDebug() << "Window" << m_id << "focus:" << (focused ? "gained" : "lost");
+        scheduleStateConfigure();
     }
 }
 
+Window::State Window::state() const {
+    const quint8 flags = m_store->flags(m_handle);
+    if (flags & WindowStore::Minimized) return State::Minimized;
+    if (flags & WindowStore::Fullscreen) return State::Fullscreen;
+    if (flags & WindowStore::Maximized) return State::Maximized;
+    return State::Normal;
+}
+
 void Window::setState(State state) {
-    if (m_state != state) {
-        m_state = state;
+    if (this->state() != state) {
+        quint8 flags = m_store->flags(m_handle) &
+            ~(WindowStore::Minimized | WindowStore::Maximized | WindowStore::Fullscreen);
+        if (state == State::Minimized) flags |= WindowStore::Minimized;
+        else if (state == State::Maximized) flags |= WindowStore::Maximized;
+        else if (state == State::Fullscreen) flags |= WindowStore::Fullscreen;
+        m_store->setFlags(m_handle, flags);
         emit stateChanged(state);
         qDebug() << "Window" << m_id << "state changed to:" << static_cast<int>(state);
+        scheduleStateConfigure();
+    }
+}
+
+void Window::setWorkspace(int workspace) {
+    if (this->workspace() != workspace) {
+        m_store->setWorkspace(m_handle, workspace);
+        emit workspaceChanged(workspace);
+        qDebug() << "Window" << m_id << "moved to workspace" << workspace;
     }
 }
 
 void Window::close() {
     if (m_surface) {
-        // Send close request to client
-        // For now, just destroy
+        // Ask the client to close; the window goes away with its surface
         qDebug() << "Closing window:" << m_id;
+        if (m_toplevel) {
+            m_toplevel->sendClose();
+        }
         emit closed();
     }
 }
@@ -67,11 +295,25 @@ void Window::raise() {
     // Implementation would reorder window stack
 }
 
+void Window::releaseBuffer() {
+    if (m_bufferReleased) return;
+    
+    m_view.discardCurrentBuffer();
+    m_bufferReleased = true;
+    qDebug() << "Window" << m_id << "released its buffer";
+}
+
 QRect Window::clientArea() const {
-    return QRect(m_geometry.x() + borderSize(),
-                 m_geometry.y() + titleBarHeight(),
-                 m_geometry.width() - 2 * borderSize(),
-                 m_geometry.height() - titleBarHeight() - borderSize());
+    const QRect& frame = m_store->geometry(m_handle);
+    return QRect(frame.x() + borderSize(),
+                 frame.y() + titleBarHeight(),
+                 frame.width() - 2 * borderSize(),
+                 frame.height() - titleBarHeight() - borderSize());
+}
+
+QSize Window::clientSize(const QRect& geometry) const {
+    return QSize(geometry.width() - 2 * borderSize(),
+                 geometry.height() - titleBarHeight() - borderSize());
 }
 
 } // namespace Pulse
@@ -2,17 +2,31 @@
 
 #include <QObject>
 #include <QWaylandSurface>
+#include <QWaylandView>
+#include <QWaylandBufferRef>
+#include <QWaylandXdgShell>
+#include <QPointer>
 #include <QRect>
 #include <QSharedPointer>
+#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+#include "WindowStore.h"
 
 namespace Pulse {
 
 class Window : public QObject {
     Q_OBJECT
-    Q_PROPERTY(QRect geometry READ geometry NOTIFY geometryChanged)
+    // "Window" is taken by QtQuick.Window
+    QML_NAMED_ELEMENT(ClientWindow)
+    QML_UNCREATABLE("Owned by the compositor")
+    Q_PROPERTY(QRect geometry READ geometry WRITE requestGeometry NOTIFY geometryChanged)
+    Q_PROPERTY(QWaylandSurface* surface READ surface CONSTANT)
     Q_PROPERTY(QString title READ title NOTIFY titleChanged)
+    Q_PROPERTY(QString appId READ appId NOTIFY appIdChanged)
     Q_PROPERTY(bool focused READ focused NOTIFY focusedChanged)
     Q_PROPERTY(State state READ state NOTIFY stateChanged)
+    Q_PROPERTY(int workspace READ workspace NOTIFY workspaceChanged)
     
 public:
     enum class State {
@@ -23,40 +37,100 @@ public:
     };
     Q_ENUM(State)
     
-    explicit Window(QWaylandSurface* surface, QObject* parent = nullptr);
+    // Hot state (geometry, flags, workspace, z) lives in the store row
+    Window(QWaylandSurface* surface, WindowStore* store, QObject* parent = nullptr);
     ~Window();
     
     // Getters
+    quint32 id() const { return m_id; }
     QWaylandSurface* surface() const { return m_surface; }
-    QRect geometry() const { return m_geometry; }
-    QString title() const;
-    bool focused() const { return m_focused; }
-    State state() const { return m_state; }
+    QWaylandXdgToplevel* toplevel() const { return m_toplevel; }
+    QWaylandView* view() { return &m_view; }
+    QWaylandBufferRef currentBuffer() { return m_view.currentBuffer(); }
+    QRect geometry() const { return m_store->geometry(m_handle); }
+    const QString& title() const { return m_title; }
+    const QString& appId() const { return m_appId; }
+    bool focused() const { return m_store->flags(m_handle) & WindowStore::Focused; }
+    State state() const;
+    int workspace() const { return m_store->workspace(m_handle); }
+    WindowStore::Handle storeHandle() const { return m_handle; }
+    
+    // xdg-toplevel role, attached once the client assigns it
+    void setToplevel(QWaylandXdgToplevel* toplevel);
     
     // Window management
     void setGeometry(const QRect& geometry);
+    void requestGeometry(const QRect& geometry);
     void setFocused(bool focused);
     void setState(State state);
+    void setWorkspace(int workspace);
     void close();
     void raise();
     
+    // Drop the full-size client buffer (e.g. long-minimized); the next
+    // commit picks a buffer up again
+    void releaseBuffer();
+    bool bufferReleased() const { return m_bufferReleased; }
+    
+    // Scene graph nodes held for this window; adjusted from the render thread
+    int sceneNodes() const { return m_sceneNodes.load(std::memory_order_relaxed); }
+    void adjustSceneNodes(int delta) { m_sceneNodes.fetch_add(delta, std::memory_order_relaxed); }
+    
     // Decorations
     int borderSize() const { return 1; }
     int titleBarHeight() const { return 30; }
     QRect clientArea() const;
+    QSize clientSize(const QRect& geometry) const;
     
 signals:
     void geometryChanged(const QRect& geometry);
     void titleChanged(const QString& title);
+    void appIdChanged(const QString& appId);
     void focusedChanged(bool focused);
     void stateChanged(State state);
+    void workspaceChanged(int workspace);
     void closed();
     
+    // Right before the first configure, once the client has set its app id
+    // and title; the last chance to place the window without a reflow
+    void placementNeeded();
+    
+private slots:
+    void onSurfaceCommitted();
+    void onConfigureTimeout();
+    void checkConfigureAcked();
+    void updateTitle();
+    void updateAppId();
+    
 private:
-    QWaylandSurface* m_surface = nullptr;
-    QRect m_geometry;
-    bool m_focused = false;
-    State m_state = State::Normal;
+    void flushConfigure();
+    void sendInitialConfigure();
+    void scheduleStateConfigure();
+    QList<QWaylandXdgToplevel::State> toplevelStates() const;
+    QSize committedSize() const;
+    
+    // Cleared when the client destroys the surface, which can happen
+    // before the window's removal has been delivered
+    QPointer<QWaylandSurface> m_surface;
+    QPointer<QWaylandXdgToplevel> m_toplevel;
+    QWaylandView m_view;
+    bool m_bufferReleased = false;
+    std::atomic<int> m_sceneNodes{0};
+    QString m_title;
+    QString m_appId;
+    
+    // Configure/ack: at most one configure in flight, newer requests coalesce
+    QRect m_pendingGeometry;
+    QRect m_configuredGeometry;
+    QList<QWaylandXdgToplevel::State> m_configuredStates;
+    bool m_hasPendingConfigure = false;
+    bool m_configureInFlight = false;
+    bool m_initialConfigureSent = false;
+    uint m_configureSerial = 0;
+    QTimer m_configureTimer;
+    
+    WindowStore* m_store;
+    WindowStore::Handle m_handle;
     quint32 m_id = 0;
     
     static quint32 s_nextId;
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace Pulse {
+
+class Window;
+
+// Window lifecycle events on the EventBus. Windows are deleted only after
+// their WindowRemoved has been delivered, so the pointers are valid in
+// every handler. Their surfaces are not: a client may destroy one before
+// the event is flushed, and Window::surface() is null from then on.
+
+struct WindowAdded {
+    static constexpr const char* eventName = "WindowAdded";
+    Window* window = nullptr;
+};
+
+struct WindowRemoved {
+    static constexpr const char* eventName = "WindowRemoved";
+    Window* window = nullptr;
+};
+
+// window is null when nothing has focus
+struct ActiveWindowChanged {
+    static constexpr const char* eventName = "ActiveWindowChanged";
+    Window* window = nullptr;
+};
+
+} // namespace Pulse
@@ -1,37 +1,44 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
+import Pulse 1.0
 
-Rectangle {
+Item {
     id: windowItem
-    property var window: null
-    property var compositor: null
+    property ClientWindow window: null
+    property Compositor compositor: null
     
     x: window ? window.geometry.x : 0
     y: window ? window.geometry.y : 0
     width: window ? window.geometry.width : 100
     height: window ? window.geometry.height : 100
+    visible: !window || window.state !== 2  // Minimized; shown via thumbnails
     
-    color: "transparent"
-    border.width: 2
-    border.color: window && window.focused ? "#4a90e2" : "#666666"
-    radius: 4
+    // Frame, title bar, border and shadow in a single draw
+    WindowRenderer {
+        anchors.fill: parent
+        window: windowItem.window
+        trackGeometry: false
+        borderColor: "#666666"
+        titleBarColor: "#444444"
+        focusedBorderColor: "#4a90e2"
+        focusedTitleBarColor: "#357ae8"
+        clientColor: "#f0f0f0"
+    }
     
     // Title bar
-    Rectangle {
+    Item {
         id: titleBar
         width: parent.width
         height: 30
-        color: window && window.focused ? "#357ae8" : "#444444"
-        radius: 4
         
-        // Title text
-        Text {
+        // Title text, shaped once and drawn from the shared glyph atlas
+        TitleItem {
             anchors.left: parent.left
             anchors.leftMargin: 10
-            anchors.verticalCenter: parent.verticalCenter
+            anchors.top: parent.top
+            anchors.bottom: parent.bottom
             text: window ? window.title : "Window"
             color: "white"
-            elide: Text.ElideRight
             width: parent.width - 120
         }
         
@@ -66,12 +73,11 @@ Rectangle {
     }
     
     // Client area
-    Rectangle {
+    Item {
         anchors.top: titleBar.bottom
         anchors.left: parent.left
         anchors.right: parent.right
         anchors.bottom: parent.bottom
-        color: "#f0f0f0"
         
         Text {
             anchors.centerIn: parent
@@ -0,0 +1,105 @@
+// Window lifecycle test: surfaces destroyed before the bus delivers.
+//
+// WindowAdded and WindowRemoved reach their handlers at the next EventBus
+// flush, and a client can destroy its surface before that. Two cases run
+// against the subscribers that touch the surface (ClientMemoryTracker,
+// ThumbnailCache, WindowTablePublisher):
+//   added    the surface is destroyed between createWindow and the flush
+//   removed  the window is added and delivered, then destroyWindow runs
+//            and the surface is destroyed before the flush
+// Each case checks that Window::surface() is null once the surface is
+// gone and that every subscriber is back to an empty state. Reads of a
+// freed surface only crash by chance; build with AddressSanitizer to make
+// them fail reliably. Exits non-zero on any failed check.
+
+#include "ClientMemoryTracker.h"
+#include "EventBus.h"
+#include "ThumbnailCache.h"
+#include "WindowManager.h"
+#include "WindowTablePublisher.h"
+#include <QGuiApplication>
+#include <QStandardPaths>
+#include <QWaylandSurface>
+#include <QDebug>
+#include <memory>
+
+namespace Pulse {
+
+namespace {
+
+struct Subscribers {
+    WindowManager windowManager;
+    ThumbnailCache thumbnails{&windowManager};
+    ClientMemoryTracker clientMemory{&windowManager, &thumbnails};
+    WindowTablePublisher windowTable{&windowManager};
+};
+
+int s_failures = 0;
+
+void check(bool condition, const char* scenario, const char* what) {
+    if (!condition) {
+        qWarning() << scenario << "failed:" << what;
+        s_failures++;
+    }
+}
+
+void deliver() {
+    EventBus::instance()->flush();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void checkEmpty(const Subscribers& subscribers, const char* scenario) {
+    check(subscribers.windowManager.windowCount() == 0, scenario, "window manager still holds the window");
+    check(subscribers.clientMemory.totalBytes() == 0, scenario, "client memory still accounts the window");
+    check(subscribers.clientMemory.clients().isEmpty(), scenario, "client memory still lists the client");
+    check(subscribers.thumbnails.count() == 0, scenario, "thumbnail cache still holds the window");
+}
+
+void surfaceGoneBeforeAdded(Subscribers& subscribers) {
+    auto surface = std::make_unique<QWaylandSurface>();
+    Window* window = subscribers.windowManager.createWindow(surface.get());
+    
+    // WindowAdded is still queued
+    surface.reset();
+    check(window->surface() == nullptr, "added", "surface() not cleared");
+    deliver();
+    
+    subscribers.windowManager.destroyWindow(window);
+    deliver();
+    checkEmpty(subscribers, "added");
+}
+
+void surfaceGoneBeforeRemoved(Subscribers& subscribers) {
+    auto surface = std::make_unique<QWaylandSurface>();
+    Window* window = subscribers.windowManager.createWindow(surface.get());
+    deliver();
+    
+    // WindowRemoved is still queued
+    subscribers.windowManager.destroyWindow(window);
+    surface.reset();
+    check(window->surface() == nullptr, "removed", "surface() not cleared");
+    deliver();
+    checkEmpty(subscribers, "removed");
+}
+
+} // namespace
+
+} // namespace Pulse
+
+int main(int argc, char *argv[]) {
+    // Keeps the window manager's session file out of the user's data
+    QStandardPaths::setTestModeEnabled(true);
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("pulse-window-lifecycle-test");
+    
+    Pulse::Subscribers subscribers;
+    Pulse::surfaceGoneBeforeAdded(subscribers);
+    Pulse::surfaceGoneBeforeRemoved(subscribers);
+    
+    qDebug() << "Window lifecycle:" << (Pulse::s_failures ? "FAILED" : "passed");
+    return Pulse::s_failures == 0 ? 0 : 1;
+}
@@ -1,24 +1,91 @@
 #include "WindowManager.h"
+#include "EventBus.h"
+#include "Tracer.h"
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QScreen>
 #include <QWaylandSurface>
 #include <QDebug>
 #include <algorithm>
+#include <climits>
 
 namespace Pulse {
 
+// Default number of virtual workspaces
+static constexpr int kDefaultWorkspaceCount = 4;
+
+// Periodic session snapshot, written only when something changed
+static constexpr int kSessionSaveIntervalMs = 60000;
+
+static QString currentOutputName() {
+    QScreen* screen = QGuiApplication::primaryScreen();
+    return screen ? screen->name() : QString();
+}
+
+static QRect currentOutputGeometry() {
+    QScreen* screen = QGuiApplication::primaryScreen();
+    return screen ? QRect(QPoint(0, 0), screen->size()) : QRect(0, 0, 1920, 1080);
+}
+
 WindowManager::WindowManager(QObject* parent)
     : QObject(parent) {
+    setWorkspaceCount(kDefaultWorkspaceCount);
+    m_workspaces.first()->setActive(true);
+    
+    // Placement from the previous run, looked up as clients reconnect
+    m_session.load(SessionStore::defaultPath());
+    
+    connect(&m_layout, &LayoutEngine::layoutReady, this, &WindowManager::commitLayout);
+    
+    // Keep the store's output column in step with the screens
+    if (qobject_cast<QGuiApplication*>(QCoreApplication::instance())) {
+        auto watchScreen = [this](QScreen* screen) {
+            connect(screen, &QScreen::geometryChanged, this, &WindowManager::updateOutputs);
+        };
+        for (QScreen* screen : QGuiApplication::screens()) {
+            watchScreen(screen);
+        }
+        connect(qGuiApp, &QGuiApplication::screenAdded, this, [this, watchScreen](QScreen* screen) {
+            watchScreen(screen);
+            updateOutputs();
+        });
+        connect(qGuiApp, &QGuiApplication::screenRemoved, this, &WindowManager::updateOutputs);
+        updateOutputs();
+    }
+    
+    // First handler of WindowRemoved, so every other handler still sees
+    // the window alive
+    EventBus::instance()->subscribe<WindowRemoved, &WindowManager::onWindowRemoved>(this);
+    
+    m_sessionTimer.setInterval(kSessionSaveIntervalMs);
+    connect(&m_sessionTimer, &QTimer::timeout, this, [this]() {
+        if (m_sessionDirty) {
+            saveSession();
+        }
+    });
+    m_sessionTimer.start();
+    
+    if (QCoreApplication* app = QCoreApplication::instance()) {
+        connect(app, &QCoreApplication::aboutToQuit, this, &WindowManager::saveSession);
+    }
+    
     qDebug() << "WindowManager initialized";
 }
 
 WindowManager::~WindowManager() {
-    // Clean up all windows
-    for (auto window : m_windows) {
-        delete window;
+    // Shutdown without aboutToQuit (e.g. the compositor torn down first)
+    if (m_sessionDirty) {
+        saveSession();
     }
+    
+    // Clean up all windows, including removed ones not deleted yet, while
+    // the store they point into is alive
     m_windows.clear();
+    qDeleteAll(findChildren<Window*>(QString(), Qt::FindDirectChildrenOnly));
 }
 
 Window* WindowManager::createWindow(QWaylandSurface* surface) {
+    PULSE_TRACE_SCOPE("layout", "createWindow");
     if (!surface) {
         qWarning() << "Cannot create window for null surface";
         return nullptr;
@@ -32,59 +99,119 @@ Window* WindowManager::createWindow(QWaylandSurface* surface) {
     }
     
     // Create new window
-    Window* window = new Window(surface, this);
-    m_windows.insert(window->surface()->client()->processId(), window);
+    Window* window = new Window(surface, &m_store, this);
+    m_windows.insert(window->id(), window);
     
-    // Set initial position (cascade)
-    static int cascadeOffset = 30;
-    QRect geometry = window->geometry();
-    geometry.moveTopLeft(QPoint(cascadeOffset, cascadeOffset));
-    window->setGeometry(geometry);
+    // Track title/app id for search, and join the back of the MRU list
+    m_searchIndex.update(window->id(), window->title(), window->appId());
+    auto reindex = [this, window]() {
+        m_searchIndex.update(window->id(), window->title(), window->appId());
+        emit windowTitlesChanged();
+    };
+    connect(window, &Window::titleChanged, this, reindex);
+    connect(window, &Window::appIdChanged, this, reindex);
+    
+    connect(window, &Window::placementNeeded, this, [this, window]() {
+        restorePlacement(window);
+    });
+    connect(window, &Window::geometryChanged, this, &WindowManager::markSessionDirty);
+    connect(window, &Window::geometryChanged, this, [this, window]() {
+        m_store.setOutput(window->storeHandle(), WindowStore::outputAt(window->geometry(), m_outputs));
+    });
+    connect(window, &Window::stateChanged, this, &WindowManager::markSessionDirty);
+    connect(window, &Window::workspaceChanged, this, &WindowManager::markSessionDirty);
+    m_mru.push_back(window);
+    m_mruEntries.insert(window, MruEntry{std::prev(m_mru.end()), 0});
     
-    cascadeOffset += 30;
-    if (cascadeOffset > 200) cascadeOffset = 30;
+    // New windows open on the current workspace
+    Workspace* workspace = currentWorkspaceObject();
+    const bool tiled = workspace->layout() == Workspace::Layout::Tiled;
+    window->setWorkspace(m_currentWorkspace);
+    workspace->addWindow(window);
+    
+    if (tiled) {
+        // Tiled here rather than on the pool: the initial configure must
+        // carry the window's slot, not the cascade size and a resize later
+        m_layout.invalidate(workspace->index());
+        commitLayout(LayoutEngine::compute(LayoutEngine::Algorithm::Tile, layoutSnapshot(workspace)));
+    } else {
+        // Cascade until the client identifies itself and a saved placement
+        // may replace this (see restorePlacement)
+        QRect geometry = window->geometry();
+        geometry.moveTopLeft(QPoint(m_cascadeOffset, m_cascadeOffset));
+        window->requestGeometry(geometry);
+        
+        m_cascadeOffset += 30;
+        if (m_cascadeOffset > 200) m_cascadeOffset = 30;
+    }
+    m_sessionDirty = true;
     
     // Make it active
     setActiveWindow(window);
     
     qDebug() << "Window created, total:" << m_windows.size();
-    emit windowAdded(window);
+    EventBus::instance()->publish(WindowAdded{window});
     emit windowCountChanged(m_windows.size());
+    PULSE_TRACE_COUNTER("layout", "windowCount", m_windows.size());
+    
+    if (!tiled) {
+        relayoutWorkspace(workspace);
+    }
     
     return window;
 }
 
 void WindowManager::destroyWindow(Window* window) {
-    if (!window || !m_windows.values().contains(window)) {
+    PULSE_TRACE_SCOPE("layout", "destroyWindow");
+    if (!window) {
         return;
     }
     
-    quint32 keyToRemove = 0;
-    for (auto it = m_windows.begin(); it != m_windows.end(); ++it) {
-        if (it.value() == window) {
-            keyToRemove = it.key();
-            break;
+    // Keyed by id; a lookup instead of copying every window into a list
+    auto entry = m_windows.find(window->id());
+    if (entry != m_windows.end() && entry.value() == window) {
+        m_windows.erase(entry);
+        m_searchIndex.remove(window->id());
+        disconnect(window, nullptr, this, nullptr);
+        
+        Workspace* workspace = m_workspaces.value(window->workspace());
+        if (workspace) {
+            workspace->removeWindow(window);
         }
-    }
-    
-    if (keyToRemove) {
-        m_windows.remove(keyToRemove);
         
+        // The row lives until deleteLater; keep it out of store passes
+        m_store.setWorkspace(window->storeHandle(), -1);
+        
+        auto mru = m_mruEntries.find(window);
+        if (mru != m_mruEntries.end()) {
+            m_mru.erase(mru->position);
+            m_mruEntries.erase(mru);
+        }
+        m_sessionStack.remove(window);
+        m_sessionDirty = true;
+        
+        // Focus falls back to the most recently used window on this workspace
         if (m_activeWindow == window) {
             m_activeWindow = nullptr;
-            if (!m_windows.isEmpty()) {
-                setActiveWindow(m_windows.first());
+            if (Window* fallback = mostRecentOnCurrentWorkspace(window)) {
+                setActiveWindow(fallback);
             }
         }
         
         qDebug() << "Window destroyed, remaining:" << m_windows.size();
-        emit windowRemoved(window);
+        EventBus::instance()->publish(WindowRemoved{window});
         emit windowCountChanged(m_windows.size());
+        PULSE_TRACE_COUNTER("layout", "windowCount", m_windows.size());
         
-        window->deleteLater();
+        // Deleted once the removal has been delivered (onWindowRemoved)
+        relayoutWorkspace(workspace);
     }
 }
 
+void WindowManager::onWindowRemoved(const WindowRemoved& event) {
+    event.window->deleteLater();
+}
+
 Window* WindowManager::windowForSurface(QWaylandSurface* surface) const {
     for (auto window : m_windows) {
         if (window->surface() == surface) {
@@ -95,10 +222,16 @@ Window* WindowManager::windowForSurface(QWaylandSurface* surface) const {
 }
 
 void WindowManager::setActiveWindow(Window* window) {
+    PULSE_TRACE_SCOPE("layout", "setActiveWindow");
     if (m_activeWindow == window) {
         return;
     }
     
+    // Activating a window on another workspace brings that workspace up
+    if (window && window->workspace() != m_currentWorkspace) {
+        activateWorkspace(window->workspace(), false);
+    }
+    
     // Deactivate current window
     if (m_activeWindow) {
         m_activeWindow->setFocused(false);
@@ -109,9 +242,20 @@ void WindowManager::setActiveWindow(Window* window) {
     if (m_activeWindow) {
         m_activeWindow->setFocused(true);
         m_activeWindow->raise();
+        touchMru(m_activeWindow);
     }
     
     emit activeWindowChanged(m_activeWindow);
+    EventBus::instance()->publish(ActiveWindowChanged{m_activeWindow});
+}
+
+Window* WindowManager::mostRecentOnCurrentWorkspace(const Window* excluded) const {
+    for (Window* candidate : m_mru) {
+        if (candidate != excluded && candidate->workspace() == m_currentWorkspace) {
+            return candidate;
+        }
+    }
+    return nullptr;
 }
 
 void WindowManager::closeWindow(Window* window) {
@@ -149,7 +293,7 @@ void WindowManager::moveWindow(Window* window, const QPoint& delta) {
     if (window) {
         QRect geometry = window->geometry();
         geometry.translate(delta);
-        window->setGeometry(geometry);
+        window->requestGeometry(geometry);
     }
 }
 
@@ -175,76 +319,330 @@ void WindowManager::resizeWindow(Window* window, const QSize& delta, Qt::Edges e
     if (geometry.width() < 100) geometry.setWidth(100);
     if (geometry.height() < 100) geometry.setHeight(100);
     
-    window->setGeometry(geometry);
+    window->requestGeometry(geometry);
 }
 
 Window* WindowManager::windowAt(const QPoint& pos) const {
-    // Check from top-most to bottom-most
-    QList<Window*> windows = m_windows.values();
-    std::reverse(windows.begin(), windows.end());
+    // One linear pass over the geometry, z and flag columns
+    const quint32 id = m_store.windowAt(pos, m_currentWorkspace);
+    return id ? m_windows.value(id) : nullptr;
+}
+
+void WindowManager::setWorkspaceCount(int count) {
+    count = qMax(1, count);
+    if (count == m_workspaces.size()) return;
     
-    for (Window* window : windows) {
-        if (window->geometry().contains(pos)) {
-            return window;
+    while (m_workspaces.size() < count) {
+        auto* workspace = new Workspace(m_workspaces.size(), this);
+        
+        // Stacking order is the workspace's row order; mirror it into z
+        auto restack = [this, workspace]() { updateWindowStack(workspace); };
+        connect(workspace, &QAbstractItemModel::rowsInserted, this, restack);
+        connect(workspace, &QAbstractItemModel::rowsRemoved, this, restack);
+        connect(workspace, &QAbstractItemModel::rowsMoved, this, restack);
+        m_workspaces.append(workspace);
+    }
+    
+    // Windows on removed workspaces move to the last remaining one
+    while (m_workspaces.size() > count) {
+        Workspace* removed = m_workspaces.takeLast();
+        Workspace* target = m_workspaces.last();
+        const QList<Window*> windows = removed->windows();
+        for (Window* window : windows) {
+            removed->removeWindow(window);
+            window->setWorkspace(target->index());
+            target->addWindow(window);
+        }
+        if (m_currentWorkspace >= count) {
+            m_currentWorkspace = count - 1;
+            target->setActive(true);
+            emit currentWorkspaceChanged(m_currentWorkspace);
         }
+        removed->deleteLater();
     }
     
-    return nullptr;
+    emit workspacesChanged();
 }
 
-void WindowManager::arrangeWindows() {
-    // Simple vertical arrangement
-    int y = 50;
-    for (Window* window : m_windows) {
-        QRect geometry = window->geometry();
-        geometry.moveTopLeft(QPoint(50, y));
-        window->setGeometry(geometry);
-        y += geometry.height() + 20;
+QList<QObject*> WindowManager::workspaceObjects() const {
+    QList<QObject*> result;
+    result.reserve(m_workspaces.size());
+    for (Workspace* workspace : m_workspaces) {
+        result.append(workspace);
     }
+    return result;
 }
 
-void WindowManager::tileWindows() {
-    if (m_windows.isEmpty()) return;
+void WindowManager::switchToWorkspace(int index) {
+    activateWorkspace(index, true);
+}
+
+void WindowManager::activateWorkspace(int index, bool restoreFocus) {
+    if (index < 0 || index >= m_workspaces.size() || index == m_currentWorkspace) {
+        return;
+    }
+    PULSE_TRACE_SCOPE("layout", "switchWorkspace");
     
-    // Simple 2-column tiling
-    int count = m_windows.size();
-    int columns = qMin(2, count);
-    int rows = (count + columns - 1) / columns;
+    // Only visibility flips; each workspace keeps its delegates and nodes
+    Workspace* previous = m_workspaces.at(m_currentWorkspace);
+    previous->setLastActiveWindow(m_activeWindow);
+    previous->setActive(false);
     
-    int screenWidth = 1920;  // Should get from output
-    int screenHeight = 1080;
+    m_currentWorkspace = index;
+    Workspace* next = m_workspaces.at(index);
+    next->setActive(true);
+    emit currentWorkspaceChanged(index);
     
-    int colWidth = screenWidth / columns;
-    int rowHeight = screenHeight / rows;
+    if (!restoreFocus) return;
     
-    int i = 0;
-    for (Window* window : m_windows) {
-        int col = i % columns;
-        int row = i / columns;
-        
-        QRect geometry(col * colWidth, 
-                      row * rowHeight,
-                      colWidth - 10,
-                      rowHeight - 10);
-        
-        window->setGeometry(geometry);
-        i++;
+    Window* focus = next->lastActiveWindow();
+    if (!focus) {
+        for (Window* candidate : m_mru) {
+            if (candidate->workspace() == index) {
+                focus = candidate;
+                break;
+            }
+        }
     }
+    setActiveWindow(focus);
+}
+
+void WindowManager::moveWindowToWorkspace(Window* window, int index) {
+    if (!window || index < 0 || index >= m_workspaces.size() || window->workspace() == index) {
+        return;
+    }
+    
+    Workspace* from = m_workspaces.value(window->workspace());
+    Workspace* to = m_workspaces.at(index);
+    if (from) {
+        from->removeWindow(window);
+    }
+    window->setWorkspace(index);
+    to->addWindow(window);
+    
+    // Focus stays on this workspace, as when the window is closed
+    if (m_activeWindow == window) {
+        setActiveWindow(mostRecentOnCurrentWorkspace(window));
+    }
+    
+    relayoutWorkspace(from);
+    relayoutWorkspace(to);
+}
+
+void WindowManager::relayoutWorkspace(Workspace* workspace) {
+    // Tiling is persistent: keep tiled workspaces tiled as windows come and go
+    if (!workspace) return;
+    
+    // Passes computed before the change would drop or misplace windows;
+    // an arrange or cascade still under way is redone with the new set
+    const std::optional<LayoutEngine::Algorithm> dropped = m_layout.invalidate(workspace->index());
+    if (workspace->layout() == Workspace::Layout::Tiled) {
+        requestLayout(workspace, LayoutEngine::Algorithm::Tile);
+    } else if (dropped) {
+        requestLayout(workspace, *dropped);
+    }
+}
+
+void WindowManager::touchMru(Window* window) {
+    auto it = m_mruEntries.find(window);
+    if (it == m_mruEntries.end()) return;
+    
+    m_mru.splice(m_mru.begin(), m_mru, it->position);
+    it->stamp = ++m_activationCounter;
+}
+
+QList<Window*> WindowManager::mruWindows(int limit) const {
+    QList<Window*> result;
+    result.reserve(limit < 0 ? int(m_mru.size()) : qMin(limit, int(m_mru.size())));
+    for (Window* window : m_mru) {
+        if (limit >= 0 && result.size() >= limit) break;
+        result.append(window);
+    }
+    return result;
+}
+
+quint64 WindowManager::activationStamp(Window* window) const {
+    return m_mruEntries.value(window).stamp;
+}
+
+QList<Window*> WindowManager::findWindows(const QString& query, int limit) const {
+    PULSE_TRACE_SCOPE("layout", "findWindows");
+    
+    QVector<WindowSearchIndex::Match> matches = m_searchIndex.search(query);
+    
+    struct Ranked {
+        Window* window;
+        float score;
+        quint64 stamp;
+    };
+    QVector<Ranked> ranked;
+    ranked.reserve(matches.size());
+    for (const auto& match : matches) {
+        Window* window = m_windows.value(match.windowId);
+        if (window) {
+            ranked.append({window, match.score, activationStamp(window)});
+        }
+    }
+    
+    auto better = [](const Ranked& a, const Ranked& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.stamp > b.stamp;
+    };
+    int count = limit < 0 ? ranked.size() : qMin(limit, int(ranked.size()));
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), better);
+    
+    QList<Window*> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result.append(ranked[i].window);
+    }
+    return result;
+}
+
+void WindowManager::arrangeWindows() {
+    Workspace* workspace = currentWorkspaceObject();
+    workspace->setLayout(Workspace::Layout::Floating);
+    requestLayout(workspace, LayoutEngine::Algorithm::Arrange);
+}
+
+void WindowManager::tileWindows() {
+    Workspace* workspace = currentWorkspaceObject();
+    workspace->setLayout(Workspace::Layout::Tiled);
+    requestLayout(workspace, LayoutEngine::Algorithm::Tile);
 }
 
 void WindowManager::cascadeWindows() {
-    int offset = 30;
-    for (Window* window : m_windows) {
-        QRect geometry = window->geometry();
-        geometry.moveTopLeft(QPoint(offset, offset));
-        window->setGeometry(geometry);
-        offset += 30;
+    Workspace* workspace = currentWorkspaceObject();
+    workspace->setLayout(Workspace::Layout::Floating);
+    requestLayout(workspace, LayoutEngine::Algorithm::Cascade);
+}
+
+LayoutSnapshot WindowManager::layoutSnapshot(Workspace* workspace) const {
+    PULSE_TRACE_SCOPE("layout", "snapshot");
+    
+    LayoutSnapshot snapshot;
+    snapshot.workspace = workspace->index();
+    snapshot.output = currentOutputGeometry();
+    
+    // Straight from the store's columns, in stacking order
+    FrameArena::Vector<int> rows = FrameArena::instance()->vector<int>(workspace->windows().size());
+    m_store.stack(workspace->index(), rows);
+    
+    const std::vector<quint32>& ids = m_store.ids();
+    const std::vector<QRect>& geometries = m_store.geometries();
+    const std::vector<quint8>& flags = m_store.flagColumn();
+    snapshot.windows.reserve(int(rows.size()));
+    for (int row : rows) {
+        snapshot.windows.append({ids[row], geometries[row], (flags[row] & WindowStore::Minimized) != 0});
+    }
+    return snapshot;
+}
+
+void WindowManager::requestLayout(Workspace* workspace, LayoutEngine::Algorithm algorithm) {
+    m_layout.request(algorithm, layoutSnapshot(workspace));
+}
+
+void WindowManager::commitLayout(const LayoutResult& result) {
+    PULSE_TRACE_SCOPE("layout", "commit");
+    
+    // Windows that left the workspace since the snapshot keep their place
+    for (const auto& [windowId, geometry] : result.geometries) {
+        Window* window = m_windows.value(windowId);
+        if (window && window->workspace() == result.workspace) {
+            window->requestGeometry(geometry);
+        }
     }
 }
 
-void WindowManager::updateWindowStack() {
-    // Implementation for z-order management
-    // This would manage window stacking order
+void WindowManager::restorePlacement(Window* window) {
+    SessionStore::Record record;
+    if (!m_session.take(window->appId(), window->title(), &record)) {
+        return;
+    }
+    
+    PULSE_TRACE_SCOPE("session", "restorePlacement");
+    qDebug() << "Restoring placement of" << window->appId() << "to" << record.geometry;
+    
+    // Same output: exact position. Otherwise keep the size and the cascade.
+    QRect geometry = record.geometry;
+    if (record.output != currentOutputName()) {
+        geometry.moveTopLeft(window->geometry().topLeft());
+    }
+    
+    if (record.workspace != window->workspace() && m_workspaces.value(record.workspace)) {
+        moveWindowToWorkspace(window, record.workspace);
+    }
+    
+    // Restack among the windows restored into the same workspace
+    Workspace* workspace = m_workspaces.value(window->workspace());
+    if (workspace) {
+        int row = 0;
+        for (Window* other : workspace->windows()) {
+            if (other != window && m_sessionStack.value(other, INT_MAX) < record.stackPosition) {
+                ++row;
+            }
+        }
+        m_sessionStack.insert(window, record.stackPosition);
+        workspace->moveWindow(window, row);
+    }
+    
+    if (!workspace || workspace->layout() != Workspace::Layout::Tiled) {
+        window->requestGeometry(geometry);
+    }
+    
+    const Window::State state = Window::State(record.state);
+    if (state == Window::State::Maximized) {
+        maximizeWindow(window);
+    } else if (state == Window::State::Minimized || state == Window::State::Fullscreen) {
+        window->setState(state);
+    }
+}
+
+bool WindowManager::saveSession() {
+    QVector<SessionStore::Record> records;
+    records.reserve(m_windows.size());
+    
+    const QString output = currentOutputName();
+    for (Workspace* workspace : std::as_const(m_workspaces)) {
+        const QList<Window*>& windows = workspace->windows();
+        for (int i = 0; i < windows.size(); ++i) {
+            Window* window = windows[i];
+            // Without an app id there is nothing to match on next time
+            if (window->appId().isEmpty()) continue;
+            
+            SessionStore::Record record;
+            record.appId = window->appId();
+            record.title = window->title();
+            record.output = output;
+            record.geometry = window->geometry();
+            record.state = int(window->state());
+            record.workspace = workspace->index();
+            record.stackPosition = i;
+            records.append(record);
+        }
+    }
+    
+    if (!SessionStore::save(SessionStore::defaultPath(), records)) {
+        return false;
+    }
+    m_sessionDirty = false;
+    qDebug() << "Session saved:" << records.size() << "windows";
+    return true;
+}
+
+void WindowManager::updateWindowStack(Workspace* workspace) {
+    const QList<Window*>& windows = workspace->windows();
+    for (int i = 0; i < windows.size(); ++i) {
+        m_store.setZ(windows[i]->storeHandle(), i);
+    }
+}
+
+void WindowManager::updateOutputs() {
+    m_outputs.clear();
+    for (QScreen* screen : QGuiApplication::screens()) {
+        m_outputs.append(screen->geometry());
+    }
+    m_store.assignOutputs(m_outputs);
 }
 
 } // namespace Pulse
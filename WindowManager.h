@@ -1,16 +1,30 @@
 #pragma once
 
 #include "Window.h"
+#include "WindowEvents.h"
+#include "WindowSearchIndex.h"
+#include "WindowStore.h"
+#include "LayoutEngine.h"
+#include "Workspace.h"
+#include "SessionStore.h"
 #include <QObject>
+#include <QHash>
 #include <QList>
 #include <QMap>
+#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include <list>
 
 namespace Pulse {
 
 class WindowManager : public QObject {
     Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by the compositor")
     Q_PROPERTY(int windowCount READ windowCount NOTIFY windowCountChanged)
-    Q_PROPERTY(Window* activeWindow READ activeWindow NOTIFY activeWindowChanged)
+    Q_PROPERTY(Pulse::Window* activeWindow READ activeWindow NOTIFY activeWindowChanged)
+    Q_PROPERTY(QList<QObject*> workspaces READ workspaceObjects NOTIFY workspacesChanged)
+    Q_PROPERTY(int currentWorkspace READ currentWorkspace WRITE switchToWorkspace NOTIFY currentWorkspaceChanged)
     
 public:
     explicit WindowManager(QObject* parent = nullptr);
@@ -20,38 +34,108 @@ public:
     Window* createWindow(QWaylandSurface* surface);
     void destroyWindow(Window* window);
     Window* windowForSurface(QWaylandSurface* surface) const;
+    Window* windowById(quint32 id) const { return m_windows.value(id); }
     
     // Window operations
-    void setActiveWindow(Window* window);
-    void closeWindow(Window* window);
-    void minimizeWindow(Window* window);
-    void maximizeWindow(Window* window);
-    void toggleMaximize(Window* window);
+    Q_INVOKABLE void setActiveWindow(Pulse::Window* window);
+    Q_INVOKABLE void closeWindow(Pulse::Window* window);
+    Q_INVOKABLE void minimizeWindow(Pulse::Window* window);
+    Q_INVOKABLE void maximizeWindow(Pulse::Window* window);
+    Q_INVOKABLE void toggleMaximize(Pulse::Window* window);
     void moveWindow(Window* window, const QPoint& delta);
     void resizeWindow(Window* window, const QSize& delta, Qt::Edges edges);
     
     // Getters
     int windowCount() const { return m_windows.size(); }
-    QList<Window*> windows() const { return m_windows.values(); }
+    const QMap<quint32, Window*>& windows() const { return m_windows; }
     Window* activeWindow() const { return m_activeWindow; }
     Window* windowAt(const QPoint& pos) const;
     
+    // Hot state of every window in flat columns, for whole-scene passes
+    const WindowStore& store() const { return m_store; }
+    
+    // Focus history, most recent first
+    QList<Window*> mruWindows(int limit = -1) const;
+    quint64 activationStamp(Window* window) const;
+    
+    // Fuzzy title/app id search, ranked by score then recency
+    QList<Window*> findWindows(const QString& query, int limit = 20) const;
+    
+    // Workspaces
+    int workspaceCount() const { return m_workspaces.size(); }
+    void setWorkspaceCount(int count);
+    QList<Workspace*> workspaces() const { return m_workspaces; }
+    QList<QObject*> workspaceObjects() const;
+    Workspace* workspace(int index) const { return m_workspaces.value(index); }
+    Workspace* currentWorkspaceObject() const { return m_workspaces.at(m_currentWorkspace); }
+    int currentWorkspace() const { return m_currentWorkspace; }
+    Q_INVOKABLE void switchToWorkspace(int index);
+    Q_INVOKABLE void moveWindowToWorkspace(Pulse::Window* window, int index);
+    
     // Layout
     void arrangeWindows();
     void tileWindows();
     void cascadeWindows();
     
+    // Session snapshot: placement of windows with an app id
+    bool saveSession();
+    
 signals:
-    void windowAdded(Window* window);
-    void windowRemoved(Window* window);
     void activeWindowChanged(Window* window);
     void windowCountChanged(int count);
+    void windowTitlesChanged();
+    void workspacesChanged();
+    void currentWorkspaceChanged(int index);
     
 private:
+    struct MruEntry {
+        std::list<Window*>::iterator position;
+        quint64 stamp = 0;
+    };
+    
+    // Declared first: windows write their rows until they are deleted
+    WindowStore m_store;
     QMap<quint32, Window*> m_windows;
+    
+    // Screen geometries; a window's output is the one holding its centre
+    QVector<QRect> m_outputs;
     Window* m_activeWindow = nullptr;
     
-    void updateWindowStack();
+    // MRU: list front is the most recently activated window
+    std::list<Window*> m_mru;
+    QHash<Window*, MruEntry> m_mruEntries;
+    quint64 m_activationCounter = 0;
+    
+    WindowSearchIndex m_searchIndex;
+    
+    QList<Workspace*> m_workspaces;
+    int m_currentWorkspace = 0;
+    
+    // Layout passes run on worker threads and commit back here
+    LayoutEngine m_layout;
+    
+    // Next position for windows without a saved placement
+    int m_cascadeOffset = 30;
+    
+    // Saved placement from the previous run, and where restored windows
+    // sat in their workspace's stack
+    SessionStore m_session;
+    QHash<Window*, int> m_sessionStack;
+    QTimer m_sessionTimer;
+    bool m_sessionDirty = false;
+    
+    void touchMru(Window* window);
+    Window* mostRecentOnCurrentWorkspace(const Window* excluded) const;
+    void activateWorkspace(int index, bool restoreFocus);
+    void relayoutWorkspace(Workspace* workspace);
+    LayoutSnapshot layoutSnapshot(Workspace* workspace) const;
+    void requestLayout(Workspace* workspace, LayoutEngine::Algorithm algorithm);
+    void commitLayout(const LayoutResult& result);
+    void updateWindowStack(Workspace* workspace);
+    void updateOutputs();
+    void restorePlacement(Window* window);
+    void markSessionDirty() { m_sessionDirty = true; }
+    void onWindowRemoved(const WindowRemoved& event);
 };
 
 } // namespace Pulse
@@ -1,6 +1,7 @@
 #include "WindowRenderer.h"
-#include <QSGSimpleRectNode>
-#include <QSGSimpleTextureNode>
+#include "DecorationMaterial.h"
+#include "Tracer.h"
+#include <QSGGeometryNode>
 #include <QQuickWindow>
 #include <QDebug>
 
@@ -13,6 +14,9 @@ WindowRenderer::WindowRenderer(QQuickItem* parent)
 }
 
 WindowRenderer::~WindowRenderer() {
+    if (m_nodeOwner) {
+        m_nodeOwner->adjustSceneNodes(-1);
+    }
 }
 
 void WindowRenderer::setWindow(Window* window) {
@@ -60,64 +64,111 @@ void WindowRenderer::setTitleBarColor(const QColor& color) {
     }
 }
 
+void WindowRenderer::setFocusedBorderColor(const QColor& color) {
+    if (m_focusedBorderColor != color) {
+        m_focusedBorderColor = color;
+        emit focusedBorderColorChanged(color);
+        update();
+    }
+}
+
+void WindowRenderer::setFocusedTitleBarColor(const QColor& color) {
+    if (m_focusedTitleBarColor != color) {
+        m_focusedTitleBarColor = color;
+        emit focusedTitleBarColorChanged(color);
+        update();
+    }
+}
+
+void WindowRenderer::setClientColor(const QColor& color) {
+    if (m_clientColor != color) {
+        m_clientColor = color;
+        emit clientColorChanged(color);
+        update();
+    }
+}
+
+void WindowRenderer::setTrackGeometry(bool track) {
+    if (m_trackGeometry != track) {
+        m_trackGeometry = track;
+        emit trackGeometryChanged(track);
+        updateGeometry();
+    }
+}
+
 QSGNode* WindowRenderer::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) {
     Q_UNUSED(data)
+    PULSE_TRACE_SCOPE("render", "updatePaintNode");
+    
+    // Node accounting follows the window the node is drawn for
+    if (m_nodeOwner != m_window && oldNode) {
+        if (m_nodeOwner) m_nodeOwner->adjustSceneNodes(-1);
+        if (m_window) m_window->adjustSceneNodes(1);
+        m_nodeOwner = m_window;
+    }
     
     if (!m_window) {
         delete oldNode;
+        m_nodeOwner = nullptr;
         return nullptr;
     }
     
-    // Create or reuse node
-    QSGNode* parentNode = oldNode;
-    if (!parentNode) {
-        parentNode = new QSGNode;
-    }
-    
-    // Clear existing children
-    while (parentNode->firstChild()) {
-        parentNode->removeChildNode(parentNode->firstChild());
+    // One quad per window; the material draws the whole frame
+    auto* node = static_cast<QSGGeometryNode*>(oldNode);
+    if (!node) {
+        m_window->adjustSceneNodes(1);
+        m_nodeOwner = m_window;
+        node = new QSGGeometryNode;
+        node->setGeometry(new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4));
+        node->geometry()->setDrawingMode(QSGGeometry::DrawTriangleStrip);
+        node->setFlag(QSGNode::OwnsGeometry);
+        node->setMaterial(new DecorationMaterial);
+        node->setFlag(QSGNode::OwnsMaterial);
     }
     
-    // Draw window decorations
-    drawWindowDecorations(parentNode);
+    drawWindowDecorations(node);
     
-    return parentNode;
+    return node;
 }
 
-void WindowRenderer::drawWindowDecorations(QSGNode* parentNode) {
+void WindowRenderer::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        update();
+    }
+}
+
+void WindowRenderer::drawWindowDecorations(QSGGeometryNode* node) {
     if (!m_window) return;
     
-    // Draw border
-    auto* borderNode = new QSGSimpleRectNode;
-    borderNode->setRect(boundingRect());
-    borderNode->setColor(m_window->focused() ? QColor("#4a90e2") : m_borderColor);
-    parentNode->appendChildNode(borderNode);
-    
-    // Draw title bar
-    QRect titleRect(0, 0, width(), m_window->titleBarHeight());
-    auto* titleNode = new QSGSimpleRectNode;
-    titleNode->setRect(titleRect);
-    titleNode->setColor(m_window->focused() ? QColor("#357ae8") : m_titleBarColor);
-    parentNode->appendChildNode(titleNode);
+    auto* material = static_cast<DecorationMaterial*>(node->material());
+    material->size = size();
+    material->borderWidth = m_window->borderSize();
+    material->titleBarHeight = m_window->titleBarHeight();
+    material->borderColor = m_window->focused() ? m_focusedBorderColor : m_borderColor;
+    material->titleBarColor = m_window->focused() ? m_focusedTitleBarColor : m_titleBarColor;
+    material->clientColor = m_clientColor;
+    node->markDirty(QSGNode::DirtyMaterial);
     
-    // Draw client area (simulated content)
-    QRect clientRect = m_window->clientArea();
-    clientRect.moveTopLeft(QPoint(m_window->borderSize(), m_window->titleBarHeight()));
-    auto* clientNode = new QSGSimpleRectNode;
-    clientNode->setRect(QRectF(clientRect));
-    clientNode->setColor(Qt::white);
-    parentNode->appendChildNode(clientNode);
+    // Grow the quad so the shadow fits; texture coordinates carry the
+    // position relative to the frame for the distance function
+    const qreal margin = material->shadowMargin();
+    const QRectF quad = boundingRect().adjusted(-margin, -margin, margin, margin);
+    QSGGeometry::updateTexturedRectGeometry(node->geometry(), quad,
+                                            quad.translated(-boundingRect().topLeft()));
+    node->markDirty(QSGNode::DirtyGeometry);
 }
 
 void WindowRenderer::updateGeometry() {
     if (!m_window) return;
     
-    QRect geometry = m_window->geometry();
-    setX(geometry.x());
-    setY(geometry.y());
-    setWidth(geometry.width());
-    setHeight(geometry.height());
+    if (m_trackGeometry) {
+        QRect geometry = m_window->geometry();
+        setX(geometry.x());
+        setY(geometry.y());
+        setWidth(geometry.width());
+        setHeight(geometry.height());
+    }
     
     update();
 }
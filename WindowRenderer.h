@@ -3,15 +3,23 @@
 #include <QObject>
 #include <QQuickItem>
 #include <QPointer>
+#include <QtQml/qqmlregistration.h>
 #include "Window.h"
 
+class QSGGeometryNode;
+
 namespace Pulse {
 
 class WindowRenderer : public QQuickItem {
     Q_OBJECT
-    Q_PROPERTY(Window* window READ window WRITE setWindow NOTIFY windowChanged)
+    QML_ELEMENT
+    Q_PROPERTY(Pulse::Window* window READ window WRITE setWindow NOTIFY windowChanged)
     Q_PROPERTY(QColor borderColor READ borderColor WRITE setBorderColor NOTIFY borderColorChanged)
     Q_PROPERTY(QColor titleBarColor READ titleBarColor WRITE setTitleBarColor NOTIFY titleBarColorChanged)
+    Q_PROPERTY(QColor focusedBorderColor READ focusedBorderColor WRITE setFocusedBorderColor NOTIFY focusedBorderColorChanged)
+    Q_PROPERTY(QColor focusedTitleBarColor READ focusedTitleBarColor WRITE setFocusedTitleBarColor NOTIFY focusedTitleBarColorChanged)
+    Q_PROPERTY(QColor clientColor READ clientColor WRITE setClientColor NOTIFY clientColorChanged)
+    Q_PROPERTY(bool trackGeometry READ trackGeometry WRITE setTrackGeometry NOTIFY trackGeometryChanged)
     
 public:
     explicit WindowRenderer(QQuickItem* parent = nullptr);
@@ -26,16 +34,37 @@ public:
     QColor titleBarColor() const { return m_titleBarColor; }
     void setTitleBarColor(const QColor& color);
     
+    // Used instead of the two above while the window has focus
+    QColor focusedBorderColor() const { return m_focusedBorderColor; }
+    void setFocusedBorderColor(const QColor& color);
+    
+    QColor focusedTitleBarColor() const { return m_focusedTitleBarColor; }
+    void setFocusedTitleBarColor(const QColor& color);
+    
+    // Shown in the client area until the client's surface covers it
+    QColor clientColor() const { return m_clientColor; }
+    void setClientColor(const QColor& color);
+    
+    // When false the item is sized by its parent (e.g. anchors) instead of
+    // following the window geometry
+    bool trackGeometry() const { return m_trackGeometry; }
+    void setTrackGeometry(bool track);
+    
 signals:
     void windowChanged(Window* window);
     void borderColorChanged(const QColor& color);
     void titleBarColorChanged(const QColor& color);
+    void focusedBorderColorChanged(const QColor& color);
+    void focusedTitleBarColorChanged(const QColor& color);
+    void clientColorChanged(const QColor& color);
+    void trackGeometryChanged(bool track);
     void closeClicked();
     void minimizeClicked();
     void maximizeClicked();
     
 protected:
     QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override;
+    void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
     
 private slots:
     void updateGeometry();
@@ -43,10 +72,15 @@ private slots:
     
 private:
     QPointer<Window> m_window;
+    QPointer<Window> m_nodeOwner;
     QColor m_borderColor = Qt::gray;
     QColor m_titleBarColor = Qt::darkGray;
+    QColor m_focusedBorderColor = QColor(0x4a, 0x90, 0xe2);
+    QColor m_focusedTitleBarColor = QColor(0x35, 0x7a, 0xe8);
+    QColor m_clientColor = QColor(0xf0, 0xf0, 0xf0);
+    bool m_trackGeometry = true;
     
-    void drawWindowDecorations(QSGNode* node);
+    void drawWindowDecorations(QSGGeometryNode* node);
 };
 
 } // namespace Pulse
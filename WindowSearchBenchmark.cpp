@@ -0,0 +1,160 @@
+// Window search benchmark.
+//
+// Fills a WindowSearchIndex with --windows windows titled the way a busy
+// session is (browser tabs, terminals, editors, chat) and times searches
+// for a fixed set of queries: common prefixes that match many windows,
+// exact titles that match a few, queries too short for trigrams (the
+// substring scan) and misses. Each search ranks its matches the way
+// WindowManager::findWindows() does, best score first and recency second,
+// and keeps the top 20. Also times retitling one window, the incremental
+// index update. Exits non-zero when any query's p95 is over --max-ms.
+
+#include "WindowSearchIndex.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+namespace Pulse {
+
+namespace {
+
+constexpr int kResultLimit = 20;
+
+const char* const kApps[] = {
+    "org.mozilla.firefox", "org.gnome.Terminal", "code", "org.kde.dolphin",
+    "Slack", "org.gnome.Evolution", "libreoffice-writer", "mpv"
+};
+
+const char* const kWords[] = {
+    "build", "log", "review", "readme", "release", "notes", "draft", "inbox",
+    "dashboard", "metrics", "compositor", "window", "search", "index", "test",
+    "deploy", "staging", "incident", "design", "budget", "planning", "video"
+};
+
+QString randomTitle(QRandomGenerator& random, int id) {
+    QString title;
+    const int words = 2 + random.bounded(4);
+    for (int i = 0; i < words; ++i) {
+        if (i) title += QLatin1Char(' ');
+        title += QLatin1String(kWords[random.bounded(int(std::size(kWords)))]);
+    }
+    return title + QStringLiteral(" - %1").arg(id);
+}
+
+// Recency stands in for WindowManager's activation stamps
+int rankedSearch(const WindowSearchIndex& index, const std::vector<quint64>& stamps, const QString& query) {
+    struct Ranked {
+        quint32 windowId;
+        float score;
+        quint64 stamp;
+    };
+    
+    const QVector<WindowSearchIndex::Match> matches = index.search(query);
+    std::vector<Ranked> ranked;
+    ranked.reserve(matches.size());
+    for (const WindowSearchIndex::Match& match : matches) {
+        ranked.push_back({match.windowId, match.score, stamps[match.windowId]});
+    }
+    
+    const int count = qMin(kResultLimit, int(ranked.size()));
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [](const Ranked& a, const Ranked& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.stamp > b.stamp;
+    });
+    return int(matches.size());
+}
+
+struct Timing {
+    double p50 = 0;
+    double p95 = 0;
+    double max = 0;
+};
+
+Timing summarize(std::vector<double> ms) {
+    std::sort(ms.begin(), ms.end());
+    auto percentile = [&ms](double p) {
+        const int rank = int(std::ceil(p * ms.size())) - 1;
+        return ms[qBound(0, rank, int(ms.size()) - 1)];
+    };
+    return { percentile(0.50), percentile(0.95), ms.back() };
+}
+
+} // namespace
+
+} // namespace Pulse
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("pulse-window-search-benchmark");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fuzzy window search latency over a large session");
+    parser.addHelpOption();
+    parser.addOption({"windows", "Windows in the index", "count", "5000"});
+    parser.addOption({"runs", "Searches per query", "count", "200"});
+    parser.addOption({"max-ms", "p95 limit per query", "ms", "1"});
+    parser.process(app);
+    
+    const int windows = qMax(1, parser.value("windows").toInt());
+    const int runs = qMax(1, parser.value("runs").toInt());
+    const double maxMs = parser.value("max-ms").toDouble();
+    
+    QRandomGenerator random(42);
+    Pulse::WindowSearchIndex index;
+    std::vector<quint64> stamps(windows + 1, 0);
+    std::vector<QString> titles(windows + 1);
+    for (int id = 1; id <= windows; ++id) {
+        titles[id] = Pulse::randomTitle(random, id);
+        index.update(quint32(id), titles[id], QLatin1String(Pulse::kApps[random.bounded(int(std::size(Pulse::kApps)))]));
+        stamps[id] = random.generate64();
+    }
+    
+    const QStringList queries = {
+        "firefox", "term", "build log", titles[windows / 2], "re", "q", "compositor search", "zzqx"
+    };
+    
+    int exitCode = 0;
+    for (const QString& query : queries) {
+        std::vector<double> ms;
+        int matches = 0;
+        for (int i = 0; i < runs; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            matches = Pulse::rankedSearch(index, stamps, query);
+            ms.push_back(timer.nsecsElapsed() / 1e6);
+        }
+        
+        const Pulse::Timing timing = Pulse::summarize(ms);
+        const bool failed = timing.p95 > maxMs;
+        qInfo().noquote() << QString("%1 %2 matches, p50 %3 ms, p95 %4 ms, max %5 ms%6")
+            .arg(QString("\"%1\"").arg(query), -30).arg(matches, 5)
+            .arg(timing.p50, 0, 'f', 3).arg(timing.p95, 0, 'f', 3).arg(timing.max, 0, 'f', 3)
+            .arg(failed ? " FAILED" : "");
+        if (failed) exitCode = 1;
+    }
+    
+    // Retitling touches only the trigrams that changed
+    std::vector<double> updateMs;
+    for (int i = 0; i < runs; ++i) {
+        const int id = 1 + random.bounded(windows);
+        const QString title = Pulse::randomTitle(random, id);
+        QElapsedTimer timer;
+        timer.start();
+        index.update(quint32(id), title, QStringLiteral("org.mozilla.firefox"));
+        updateMs.push_back(timer.nsecsElapsed() / 1e6);
+    }
+    const Pulse::Timing update = Pulse::summarize(updateMs);
+    qInfo().noquote() << QString("retitle: p50 %1 ms, p95 %2 ms, max %3 ms")
+        .arg(update.p50, 0, 'f', 3).arg(update.p95, 0, 'f', 3).arg(update.max, 0, 'f', 3);
+    
+    qInfo().noquote() << QString("%1 windows, p95 limit %2 ms: %3")
+        .arg(windows).arg(maxMs).arg(exitCode ? "FAILED" : "passed");
+    return exitCode;
+}
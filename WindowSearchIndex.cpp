@@ -0,0 +1,168 @@
+#include "WindowSearchIndex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace Pulse {
+
+QString WindowSearchIndex::normalize(const QString& text) {
+    return text.toCaseFolded();
+}
+
+std::vector<quint64> WindowSearchIndex::trigramsOf(const QString& text) {
+    std::vector<quint64> result;
+    if (text.size() < 3) {
+        return result;
+    }
+    
+    result.reserve(text.size() - 2);
+    const char16_t* data = reinterpret_cast<const char16_t*>(text.utf16());
+    for (qsizetype i = 0; i + 2 < text.size(); ++i) {
+        result.push_back((quint64(data[i]) << 32) | (quint64(data[i + 1]) << 16) | quint64(data[i + 2]));
+    }
+    
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+int WindowSearchIndex::allocateSlot(quint32 windowId) {
+    int slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = static_cast<int>(m_documents.size());
+        m_documents.emplace_back();
+        m_hitCounts.push_back(0);
+    }
+    m_documents[slot].windowId = windowId;
+    m_slotByWindow.insert(windowId, slot);
+    return slot;
+}
+
+void WindowSearchIndex::addPostings(int slot, const std::vector<quint64>& trigrams) {
+    for (quint64 trigram : trigrams) {
+        m_postings[trigram].push_back(slot);
+    }
+}
+
+void WindowSearchIndex::removePostings(int slot, const std::vector<quint64>& trigrams) {
+    for (quint64 trigram : trigrams) {
+        auto it = m_postings.find(trigram);
+        if (it == m_postings.end()) continue;
+        
+        std::vector<int>& slots = it.value();
+        auto pos = std::find(slots.begin(), slots.end(), slot);
+        if (pos != slots.end()) {
+            *pos = slots.back();
+            slots.pop_back();
+        }
+        if (slots.empty()) {
+            m_postings.erase(it);
+        }
+    }
+}
+
+void WindowSearchIndex::update(quint32 windowId, const QString& title, const QString& appId) {
+    QString text = normalize(appId.isEmpty() ? title : title + QLatin1Char(' ') + appId);
+    
+    auto existing = m_slotByWindow.constFind(windowId);
+    const bool known = existing != m_slotByWindow.constEnd();
+    const int slot = known ? existing.value() : allocateSlot(windowId);
+    Document& document = m_documents[slot];
+    if (known && document.text == text) {
+        return;
+    }
+    
+    std::vector<quint64> trigrams = trigramsOf(text);
+    
+    // Only touch postings for trigrams that were added or dropped
+    std::vector<quint64> removed;
+    std::vector<quint64> added;
+    std::set_difference(document.trigrams.begin(), document.trigrams.end(),
+                        trigrams.begin(), trigrams.end(), std::back_inserter(removed));
+    std::set_difference(trigrams.begin(), trigrams.end(),
+                        document.trigrams.begin(), document.trigrams.end(), std::back_inserter(added));
+    removePostings(slot, removed);
+    addPostings(slot, added);
+    
+    document.text = text;
+    document.trigrams = std::move(trigrams);
+}
+
+void WindowSearchIndex::remove(quint32 windowId) {
+    auto it = m_slotByWindow.find(windowId);
+    if (it == m_slotByWindow.end()) return;
+    
+    int slot = it.value();
+    m_slotByWindow.erase(it);
+    
+    Document& document = m_documents[slot];
+    removePostings(slot, document.trigrams);
+    document = Document();
+    m_freeSlots.push_back(slot);
+}
+
+void WindowSearchIndex::clear() {
+    m_documents.clear();
+    m_freeSlots.clear();
+    m_slotByWindow.clear();
+    m_postings.clear();
+    m_hitCounts.clear();
+    m_touched.clear();
+}
+
+QVector<WindowSearchIndex::Match> WindowSearchIndex::search(const QString& query) const {
+    QVector<Match> matches;
+    const QString needle = normalize(query.trimmed());
+    if (needle.isEmpty()) {
+        return matches;
+    }
+    
+    // Too short for trigrams: plain substring scan
+    if (needle.size() < 3) {
+        for (auto it = m_slotByWindow.constBegin(); it != m_slotByWindow.constEnd(); ++it) {
+            const QString& text = m_documents[it.value()].text;
+            qsizetype pos = text.indexOf(needle);
+            if (pos >= 0) {
+                matches.append({it.key(), pos == 0 ? 2.0f : 1.0f});
+            }
+        }
+        return matches;
+    }
+    
+    const std::vector<quint64> trigrams = trigramsOf(needle);
+    const int required = std::max<int>(1, static_cast<int>(trigrams.size() + 1) / 2);
+    
+    m_touched.clear();
+    for (quint64 trigram : trigrams) {
+        auto it = m_postings.constFind(trigram);
+        if (it == m_postings.constEnd()) continue;
+        
+        for (int slot : it.value()) {
+            if (m_hitCounts[slot]++ == 0) {
+                m_touched.push_back(slot);
+            }
+        }
+    }
+    
+    for (int slot : m_touched) {
+        const int hits = m_hitCounts[slot];
+        m_hitCounts[slot] = 0;
+        if (hits < required) continue;
+        
+        const Document& document = m_documents[slot];
+        float score = float(hits) / float(trigrams.size());
+        qsizetype pos = document.text.indexOf(needle);
+        if (pos == 0) {
+            score += 1.0f;
+        } else if (pos > 0) {
+            score += 0.5f;
+        }
+        matches.append({document.windowId, score});
+    }
+    
+    return matches;
+}
+
+} // namespace Pulse
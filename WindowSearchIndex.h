@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+namespace Pulse {
+
+// Incremental trigram index over window titles and app ids.
+// Updating one window only touches the trigrams that changed.
+class WindowSearchIndex {
+public:
+    struct Match {
+        quint32 windowId;
+        float score;
+    };
+    
+    void update(quint32 windowId, const QString& title, const QString& appId);
+    void remove(quint32 windowId);
+    void clear();
+    
+    // Fuzzy search; results are unordered beyond score (callers add recency)
+    QVector<Match> search(const QString& query) const;
+    
+    int size() const { return m_slotByWindow.size(); }
+    
+private:
+    struct Document {
+        quint32 windowId = 0;
+        QString text;                 // lower-cased "title appId"
+        std::vector<quint64> trigrams; // sorted, unique
+    };
+    
+    static QString normalize(const QString& text);
+    static std::vector<quint64> trigramsOf(const QString& text);
+    
+    int allocateSlot(quint32 windowId);
+    void addPostings(int slot, const std::vector<quint64>& trigrams);
+    void removePostings(int slot, const std::vector<quint64>& trigrams);
+    
+    std::vector<Document> m_documents;       // indexed by slot
+    std::vector<int> m_freeSlots;
+    QHash<quint32, int> m_slotByWindow;
+    QHash<quint64, std::vector<int>> m_postings;
+    
+    // Scratch space for search, sized to m_documents
+    mutable std::vector<quint16> m_hitCounts;
+    mutable std::vector<int> m_touched;
+};
+
+} // namespace Pulse
@@ -0,0 +1,117 @@
+#include "WindowStore.h"
+#include <QRegion>
+#include <algorithm>
+
+namespace Pulse {
+
+WindowStore::Handle WindowStore::insert(quint32 windowId) {
+    Handle handle;
+    if (!m_freeHandles.empty()) {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    } else {
+        handle = Handle(m_rows.size());
+        m_rows.push_back(-1);
+    }
+    
+    m_rows[handle] = int(m_ids.size());
+    m_ids.push_back(windowId);
+    m_geometry.push_back(QRect());
+    m_z.push_back(0);
+    m_flags.push_back(0);
+    m_workspace.push_back(0);
+    m_output.push_back(0);
+    m_handles.push_back(handle);
+    return handle;
+}
+
+void WindowStore::remove(Handle handle) {
+    const int removed = m_rows[handle];
+    const int last = int(m_ids.size()) - 1;
+    
+    // Keep rows packed: the last row takes the removed one's place
+    if (removed != last) {
+        m_ids[removed] = m_ids[last];
+        m_geometry[removed] = m_geometry[last];
+        m_z[removed] = m_z[last];
+        m_flags[removed] = m_flags[last];
+        m_workspace[removed] = m_workspace[last];
+        m_output[removed] = m_output[last];
+        m_handles[removed] = m_handles[last];
+        m_rows[m_handles[removed]] = removed;
+    }
+    
+    m_ids.pop_back();
+    m_geometry.pop_back();
+    m_z.pop_back();
+    m_flags.pop_back();
+    m_workspace.pop_back();
+    m_output.pop_back();
+    m_handles.pop_back();
+    
+    m_rows[handle] = -1;
+    m_freeHandles.push_back(handle);
+}
+
+quint32 WindowStore::windowAt(const QPoint& pos, int workspace, quint8 excludedFlags) const {
+    quint32 hit = 0;
+    int hitZ = -1;
+    
+    const int count = size();
+    for (int i = 0; i < count; ++i) {
+        if (m_workspace[i] != workspace || (m_flags[i] & excludedFlags) || m_z[i] <= hitZ) {
+            continue;
+        }
+        if (m_geometry[i].contains(pos)) {
+            hit = m_ids[i];
+            hitZ = m_z[i];
+        }
+    }
+    return hit;
+}
+
+void WindowStore::stack(int workspace, FrameArena::Vector<int>& rows) const {
+    rows.clear();
+    const int count = size();
+    for (int i = 0; i < count; ++i) {
+        if (m_workspace[i] == workspace) {
+            rows.push_back(i);
+        }
+    }
+    std::sort(rows.begin(), rows.end(), [this](int a, int b) { return m_z[a] < m_z[b]; });
+}
+
+void WindowStore::occluded(int workspace, FrameArena::Vector<quint32>& ids, quint8 excludedFlags) const {
+    FrameArena::Vector<int> rows = FrameArena::instance()->vector<int>(m_ids.size());
+    stack(workspace, rows);
+    
+    QRegion covered;
+    for (auto it = rows.crbegin(); it != rows.crend(); ++it) {
+        const int i = *it;
+        if (m_flags[i] & excludedFlags) continue;
+        
+        if (QRegion(m_geometry[i]).subtracted(covered).isEmpty()) {
+            ids.push_back(m_ids[i]);
+        }
+        covered += m_geometry[i];
+    }
+}
+
+int WindowStore::outputAt(const QRect& geometry, const QVector<QRect>& outputs) {
+    const QPoint center = geometry.center();
+    for (int i = 0; i < outputs.size(); ++i) {
+        if (outputs[i].contains(center)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void WindowStore::assignOutputs(const QVector<QRect>& outputs) {
+    const int count = size();
+    for (int i = 0; i < count; ++i) {
+        m_output[i] = outputAt(m_geometry[i], outputs);
+    }
+}
+
+} // namespace Pulse
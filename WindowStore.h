@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+#include "FrameArena.h"
+
+namespace Pulse {
+
+// Hot per-window state kept in contiguous columns (structure of arrays).
+// Passes over every window (hit-testing, occlusion, layout, publishing)
+// walk a few flat arrays instead of chasing Window objects across the
+// heap. Window is a facade over one row and keeps emitting its signals.
+//
+// Rows stay packed: removing a window moves the last row into its place.
+// Windows therefore hold a stable handle, mapped to the current row.
+class WindowStore {
+public:
+    using Handle = quint32;
+    
+    enum Flag : quint8 {
+        Focused = 0x01,
+        Minimized = 0x02,
+        Maximized = 0x04,
+        Fullscreen = 0x08
+    };
+    
+    Handle insert(quint32 windowId);
+    void remove(Handle handle);
+    
+    int size() const { return int(m_ids.size()); }
+    int row(Handle handle) const { return m_rows[handle]; }
+    
+    // One window
+    quint32 id(Handle handle) const { return m_ids[row(handle)]; }
+    const QRect& geometry(Handle handle) const { return m_geometry[row(handle)]; }
+    void setGeometry(Handle handle, const QRect& geometry) { m_geometry[row(handle)] = geometry; }
+    int z(Handle handle) const { return m_z[row(handle)]; }
+    void setZ(Handle handle, int z) { m_z[row(handle)] = z; }
+    quint8 flags(Handle handle) const { return m_flags[row(handle)]; }
+    void setFlags(Handle handle, quint8 flags) { m_flags[row(handle)] = flags; }
+    int workspace(Handle handle) const { return m_workspace[row(handle)]; }
+    void setWorkspace(Handle handle, int workspace) { m_workspace[row(handle)] = workspace; }
+    int output(Handle handle) const { return m_output[row(handle)]; }
+    void setOutput(Handle handle, int output) { m_output[row(handle)] = output; }
+    
+    // Whole columns; index i of each belongs to the same window
+    const std::vector<quint32>& ids() const { return m_ids; }
+    const std::vector<QRect>& geometries() const { return m_geometry; }
+    const std::vector<int>& zOrder() const { return m_z; }
+    const std::vector<quint8>& flagColumn() const { return m_flags; }
+    const std::vector<int>& workspaces() const { return m_workspace; }
+    const std::vector<int>& outputs() const { return m_output; }
+    
+    // Topmost window on the workspace containing pos, skipping windows
+    // with any of the excluded flags; 0 if there is none
+    quint32 windowAt(const QPoint& pos, int workspace, quint8 excludedFlags = Minimized) const;
+    
+    // Rows on the workspace in stacking order, bottom first
+    void stack(int workspace, FrameArena::Vector<int>& rows) const;
+    
+    // Windows on the workspace entirely covered by windows above them,
+    // top-most first. Windows with an excluded flag neither count nor cover.
+    void occluded(int workspace, FrameArena::Vector<quint32>& ids, quint8 excludedFlags = Minimized) const;
+    
+    // Index of the output holding the centre of geometry; 0 if none does
+    static int outputAt(const QRect& geometry, const QVector<QRect>& outputs);
+    
+    // Recomputes the output column after outputs changed
+    void assignOutputs(const QVector<QRect>& outputs);
+    
+private:
+    // Columns, indexed by row
+    std::vector<quint32> m_ids;
+    std::vector<QRect> m_geometry;
+    std::vector<int> m_z;
+    std::vector<quint8> m_flags;
+    std::vector<int> m_workspace;
+    std::vector<int> m_output;
+    std::vector<Handle> m_handles;
+    
+    // Indexed by handle
+    std::vector<int> m_rows;
+    std::vector<Handle> m_freeHandles;
+};
+
+} // namespace Pulse
@@ -0,0 +1,290 @@
+// Full-scene pass benchmark for the window store.
+//
+// Runs the passes WindowManager makes over every window twice over the same
+// scene: once over WindowStore's columns, and once over the layout windows
+// had before the store, where every window was its own QObject holding its
+// geometry, state and focus, reached through a QMap node. The objects are
+// allocated in random id order between filler allocations, the way a
+// long-running compositor's heap ends up, so neighbouring windows do not
+// sit next to each other in memory.
+//
+// Passes: hit-testing a grid of points, building a layout snapshot of every
+// workspace in stacking order, the bounding rect of visible windows per
+// output (damage), and reassigning outputs. Each pass's results are checked
+// to match between the two layouts. Occlusion is not timed: its region
+// arithmetic costs the same either way. Exits non-zero when the geometric
+// mean speedup is below --min-speedup.
+
+#include "WindowStore.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace Pulse {
+
+namespace {
+
+constexpr int kWorkspaces = 4;
+constexpr int kHitPoints = 64;
+
+const QVector<QRect> kOutputs = { QRect(0, 0, 1920, 1080), QRect(1920, 0, 2560, 1440) };
+
+// Window as it was before the store: hot fields inside a heap QObject
+class ObjectWindow : public QObject {
+public:
+    quint32 id = 0;
+    void* surface = nullptr;
+    QRect geometry;
+    bool focused = false;
+    bool minimized = false;
+    int workspace = 0;
+    int z = 0;
+    int output = 0;
+    QString title;
+};
+
+struct Scene {
+    WindowStore store;
+    std::vector<WindowStore::Handle> handles;
+    
+    QMap<quint32, ObjectWindow*> objects;
+    QList<ObjectWindow*> stacks[kWorkspaces];     // bottom first
+    std::vector<std::unique_ptr<ObjectWindow>> owned;
+    std::vector<QByteArray> filler;
+};
+
+void buildScene(Scene& scene, int count) {
+    QRandomGenerator random(42);
+    
+    std::vector<quint32> ids(count);
+    for (int i = 0; i < count; ++i) {
+        ids[i] = quint32(i + 1);
+    }
+    std::shuffle(ids.begin(), ids.end(), random);
+    
+    for (quint32 id : ids) {
+        const QRect geometry(random.bounded(4200), random.bounded(1300),
+                             200 + random.bounded(800), 150 + random.bounded(600));
+        const int workspace = random.bounded(kWorkspaces);
+        const bool minimized = random.bounded(10) == 0;
+        
+        auto object = std::make_unique<ObjectWindow>();
+        object->id = id;
+        object->geometry = geometry;
+        object->minimized = minimized;
+        object->workspace = workspace;
+        object->z = scene.stacks[workspace].size();
+        object->title = QStringLiteral("Window %1").arg(id);
+        scene.objects.insert(id, object.get());
+        scene.stacks[workspace].append(object.get());
+        scene.owned.push_back(std::move(object));
+        scene.filler.emplace_back(16 + random.bounded(512), '\0');
+        
+        const WindowStore::Handle handle = scene.store.insert(id);
+        scene.store.setGeometry(handle, geometry);
+        scene.store.setFlags(handle, minimized ? WindowStore::Minimized : 0);
+        scene.store.setWorkspace(handle, workspace);
+        scene.store.setZ(handle, scene.stacks[workspace].size() - 1);
+        scene.handles.push_back(handle);
+    }
+}
+
+QVector<QPoint> hitPoints() {
+    QVector<QPoint> points;
+    for (int y = 0; y < kHitPoints; ++y) {
+        for (int x = 0; x < kHitPoints; ++x) {
+            points.append(QPoint(x * 4480 / kHitPoints, y * 1440 / kHitPoints));
+        }
+    }
+    return points;
+}
+
+// Each pass returns a checksum so the two layouts can be compared
+
+quint64 hitTestObjects(const Scene& scene, const QVector<QPoint>& points) {
+    quint64 sum = 0;
+    for (const QPoint& point : points) {
+        const ObjectWindow* hit = nullptr;
+        for (const ObjectWindow* window : scene.objects) {
+            if (window->workspace != 0 || window->minimized || (hit && window->z <= hit->z)) continue;
+            if (window->geometry.contains(point)) {
+                hit = window;
+            }
+        }
+        sum += hit ? hit->id : 0;
+    }
+    return sum;
+}
+
+quint64 hitTestStore(const Scene& scene, const QVector<QPoint>& points) {
+    quint64 sum = 0;
+    for (const QPoint& point : points) {
+        sum += scene.store.windowAt(point, 0);
+    }
+    return sum;
+}
+
+quint64 snapshotObjects(const Scene& scene) {
+    quint64 sum = 0;
+    for (const QList<ObjectWindow*>& stack : scene.stacks) {
+        std::vector<std::pair<quint32, QRect>> snapshot;
+        snapshot.reserve(stack.size());
+        for (const ObjectWindow* window : stack) {
+            snapshot.emplace_back(window->id, window->geometry);
+            sum = sum * 31 + window->id + (window->minimized ? 1 : 0) + quint64(window->geometry.x());
+        }
+    }
+    return sum;
+}
+
+quint64 snapshotStore(const Scene& scene) {
+    const std::vector<quint32>& ids = scene.store.ids();
+    const std::vector<QRect>& geometries = scene.store.geometries();
+    const std::vector<quint8>& flags = scene.store.flagColumn();
+    
+    quint64 sum = 0;
+    FrameArena::Vector<int> rows = FrameArena::instance()->vector<int>(ids.size());
+    for (int workspace = 0; workspace < kWorkspaces; ++workspace) {
+        scene.store.stack(workspace, rows);
+        std::vector<std::pair<quint32, QRect>> snapshot;
+        snapshot.reserve(rows.size());
+        for (int row : rows) {
+            snapshot.emplace_back(ids[row], geometries[row]);
+            sum = sum * 31 + ids[row] + ((flags[row] & WindowStore::Minimized) ? 1 : 0) + quint64(geometries[row].x());
+        }
+    }
+    return sum;
+}
+
+quint64 damageObjects(const Scene& scene) {
+    QRect damage[2];
+    for (const ObjectWindow* window : scene.objects) {
+        if (window->workspace == 0 && !window->minimized) {
+            damage[window->output] |= window->geometry;
+        }
+    }
+    return quint64(damage[0].width()) * 7 + damage[0].height() + quint64(damage[1].width()) * 13 + damage[1].height();
+}
+
+quint64 damageStore(const Scene& scene) {
+    const std::vector<QRect>& geometries = scene.store.geometries();
+    const std::vector<quint8>& flags = scene.store.flagColumn();
+    const std::vector<int>& workspaces = scene.store.workspaces();
+    const std::vector<int>& outputs = scene.store.outputs();
+    
+    QRect damage[2];
+    for (int i = 0; i < scene.store.size(); ++i) {
+        if (workspaces[i] == 0 && !(flags[i] & WindowStore::Minimized)) {
+            damage[outputs[i]] |= geometries[i];
+        }
+    }
+    return quint64(damage[0].width()) * 7 + damage[0].height() + quint64(damage[1].width()) * 13 + damage[1].height();
+}
+
+quint64 outputsObjects(Scene& scene) {
+    quint64 sum = 0;
+    for (ObjectWindow* window : std::as_const(scene.objects)) {
+        window->output = WindowStore::outputAt(window->geometry, kOutputs);
+        sum += window->output;
+    }
+    return sum;
+}
+
+quint64 outputsStore(Scene& scene) {
+    scene.store.assignOutputs(kOutputs);
+    quint64 sum = 0;
+    for (int output : scene.store.outputs()) {
+        sum += output;
+    }
+    return sum;
+}
+
+// Median of the runs, in microseconds
+double timePass(int runs, const std::function<quint64()>& pass, quint64* checksum) {
+    std::vector<double> times;
+    for (int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        *checksum = pass();
+        times.push_back(timer.nsecsElapsed() / 1e3);
+        FrameArena::instance()->reset();
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+} // namespace
+
+} // namespace Pulse
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("pulse-window-store-benchmark");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Full-scene window passes: store columns against per-window objects");
+    parser.addHelpOption();
+    parser.addOption({"windows", "Windows in the scene", "count", "10000"});
+    parser.addOption({"runs", "Runs per pass; the median is reported", "count", "25"});
+    parser.addOption({"min-speedup", "Required geometric mean speedup", "ratio", "2"});
+    parser.process(app);
+    
+    Pulse::Scene scene;
+    Pulse::buildScene(scene, qMax(1, parser.value("windows").toInt()));
+    const QVector<QPoint> points = Pulse::hitPoints();
+    const int runs = qMax(1, parser.value("runs").toInt());
+    
+    // Outputs first: damage reads them
+    struct Pass {
+        const char* name;
+        std::function<quint64()> objects;
+        std::function<quint64()> store;
+    };
+    const Pass passes[] = {
+        { "outputs", [&]() { return Pulse::outputsObjects(scene); },
+                     [&]() { return Pulse::outputsStore(scene); } },
+        { "hitTest", [&]() { return Pulse::hitTestObjects(scene, points); },
+                     [&]() { return Pulse::hitTestStore(scene, points); } },
+        { "snapshot", [&]() { return Pulse::snapshotObjects(scene); },
+                      [&]() { return Pulse::snapshotStore(scene); } },
+        { "damage", [&]() { return Pulse::damageObjects(scene); },
+                    [&]() { return Pulse::damageStore(scene); } }
+    };
+    
+    int exitCode = 0;
+    double logSpeedup = 0;
+    for (const Pass& pass : passes) {
+        quint64 objectSum = 0;
+        quint64 storeSum = 0;
+        const double objectUs = Pulse::timePass(runs, pass.objects, &objectSum);
+        const double storeUs = Pulse::timePass(runs, pass.store, &storeSum);
+        const double speedup = objectUs / qMax(storeUs, 0.001);
+        logSpeedup += std::log(speedup);
+        
+        qInfo().noquote() << QString("%1 objects %2 us, store %3 us, %4x%5")
+            .arg(pass.name, -8).arg(objectUs, 0, 'f', 1).arg(storeUs, 0, 'f', 1)
+            .arg(speedup, 0, 'f', 2).arg(objectSum == storeSum ? "" : " MISMATCH");
+        if (objectSum != storeSum) {
+            exitCode = 1;
+        }
+    }
+    
+    const double mean = std::exp(logSpeedup / std::size(passes));
+    const double required = parser.value("min-speedup").toDouble();
+    qInfo().noquote() << QString("Geometric mean speedup %1x (required %2x)").arg(mean, 0, 'f', 2).arg(required);
+    if (mean < required) {
+        exitCode = 1;
+    }
+    return exitCode;
+}
@@ -0,0 +1,113 @@
+#include "WindowSwitcherModel.h"
+#include "EventBus.h"
+
+namespace Pulse {
+
+WindowSwitcherModel::WindowSwitcherModel(WindowManager* windowManager, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_windowManager(windowManager) {
+    
+    // Coalesce bursts of window changes into one refresh per event loop turn
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(0);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &WindowSwitcherModel::refresh);
+    
+    EventBus* bus = EventBus::instance();
+    bus->subscribe<WindowAdded, &WindowSwitcherModel::scheduleRefresh>(this);
+    bus->subscribe<WindowRemoved, &WindowSwitcherModel::scheduleRefresh>(this);
+    bus->subscribe<ActiveWindowChanged, &WindowSwitcherModel::scheduleRefresh>(this);
+    connect(m_windowManager, &WindowManager::windowTitlesChanged,
+            this, &WindowSwitcherModel::scheduleRefresh);
+    
+    refresh();
+}
+
+void WindowSwitcherModel::setQuery(const QString& query) {
+    if (m_query == query) return;
+    
+    m_query = query;
+    emit queryChanged(query);
+    refresh();
+}
+
+void WindowSwitcherModel::setLimit(int limit) {
+    if (m_limit == limit) return;
+    
+    m_limit = limit;
+    emit limitChanged(limit);
+    scheduleRefresh();
+}
+
+int WindowSwitcherModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant WindowSwitcherModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    
+    Window* window = m_rows.at(index.row());
+    if (!window) {
+        return QVariant();
+    }
+    
+    switch (role) {
+    case WindowRole:
+        return QVariant::fromValue(window);
+    case WindowIdRole:
+        return window->id();
+    case Qt::DisplayRole:
+    case TitleRole:
+        return window->title();
+    case AppIdRole:
+        return window->appId();
+    case FocusedRole:
+        return window->focused();
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> WindowSwitcherModel::roleNames() const {
+    return {
+        { WindowRole, "window" },
+        { WindowIdRole, "windowId" },
+        { TitleRole, "title" },
+        { AppIdRole, "appId" },
+        { FocusedRole, "focused" }
+    };
+}
+
+void WindowSwitcherModel::activate(int row) {
+    if (row < 0 || row >= m_rows.size() || !m_rows.at(row)) {
+        return;
+    }
+    m_windowManager->setActiveWindow(m_rows.at(row));
+}
+
+void WindowSwitcherModel::scheduleRefresh() {
+    if (!m_refreshTimer.isActive()) {
+        m_refreshTimer.start();
+    }
+}
+
+void WindowSwitcherModel::refresh() {
+    m_refreshTimer.stop();
+    
+    QList<Window*> windows = m_query.trimmed().isEmpty()
+        ? m_windowManager->mruWindows(m_limit)
+        : m_windowManager->findWindows(m_query, m_limit);
+    
+    beginResetModel();
+    m_rows.clear();
+    m_rows.reserve(windows.size());
+    for (Window* window : windows) {
+        m_rows.append(window);
+    }
+    endResetModel();
+    
+    emit countChanged();
+}
+
+} // namespace Pulse
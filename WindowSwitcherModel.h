@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include "WindowManager.h"
+
+namespace Pulse {
+
+// Alt-Tab / "go to window" list: MRU order when the query is empty,
+// ranked fuzzy matches otherwise
+class WindowSwitcherModel : public QAbstractListModel {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by the compositor")
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(int limit READ limit WRITE setLimit NOTIFY limitChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    
+public:
+    enum Roles {
+        WindowRole = Qt::UserRole + 1,
+        WindowIdRole,
+        TitleRole,
+        AppIdRole,
+        FocusedRole
+    };
+    
+    explicit WindowSwitcherModel(WindowManager* windowManager, QObject* parent = nullptr);
+    
+    QString query() const { return m_query; }
+    void setQuery(const QString& query);
+    
+    int limit() const { return m_limit; }
+    void setLimit(int limit);
+    
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    
+    Q_INVOKABLE void activate(int row);
+    
+signals:
+    void queryChanged(const QString& query);
+    void limitChanged(int limit);
+    void countChanged();
+    
+private slots:
+    void scheduleRefresh();
+    void refresh();
+    
+private:
+    WindowManager* m_windowManager;
+    QList<QPointer<Window>> m_rows;
+    QString m_query;
+    int m_limit = 50;
+    QTimer m_refreshTimer;
+};
+
+} // namespace Pulse
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+namespace Pulse {
+
+// Shared-memory window table published by the compositor for panels, docks
+// and other out-of-process observers. The layout is fixed-size and plain
+// data so readers need nothing but this header; bump kWindowTableVersion on
+// any incompatible change and only ever append fields.
+constexpr uint32_t kWindowTableMagic = 0x31545750;   // "PWT1"
+constexpr uint32_t kWindowTableVersion = 1;
+constexpr uint32_t kWindowTableCapacity = 256;
+
+struct WindowTableEntry {
+    enum Flags : uint32_t {
+        Focused = 1u << 0,
+        Visible = 1u << 1      // not minimized and on the current workspace
+    };
+    
+    uint32_t id;
+    uint32_t flags;
+    uint32_t state;            // Window::State
+    int32_t workspace;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    int64_t pid;
+    uint64_t activationStamp;  // larger is more recent, 0 if never focused
+    char appId[64];            // UTF-8, NUL terminated
+    char title[128];
+};
+
+struct WindowTableHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t entrySize;
+    
+    // Seqlock: odd while the compositor is writing. Readers copy, then
+    // retry if the value changed or was odd.
+    std::atomic<uint64_t> sequence;
+    
+    uint32_t count;
+    uint32_t activeWindowId;
+    int32_t currentWorkspace;
+    uint32_t reserved;
+};
+
+struct WindowTable {
+    WindowTableHeader header;
+    WindowTableEntry entries[kWindowTableCapacity];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "seqlock counter must be lock-free to live in shared memory");
+static_assert(sizeof(WindowTableEntry) == 240, "WindowTableEntry layout changed");
+
+// Unix socket on which the compositor hands out the table and a change
+// eventfd, one per Wayland display. Clients pass nothing and get the
+// display they run on. Empty without XDG_RUNTIME_DIR: a shared directory
+// would let another user serve or squat the socket.
+inline std::string windowTableSocketPath(const char* waylandDisplay = nullptr) {
+    const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    if (!runtimeDir || !*runtimeDir) return {};
+    
+    if (!waylandDisplay || !*waylandDisplay) waylandDisplay = std::getenv("WAYLAND_DISPLAY");
+    if (!waylandDisplay || !*waylandDisplay) waylandDisplay = "wayland-0";
+    
+    // WAYLAND_DISPLAY may be an absolute socket path
+    if (*waylandDisplay == '/') return std::string(waylandDisplay) + ".pulse-window-table";
+    return std::string(runtimeDir) + "/" + waylandDisplay + ".pulse-window-table";
+}
+
+} // namespace Pulse
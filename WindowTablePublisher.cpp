@@ -0,0 +1,344 @@
+#include "WindowTablePublisher.h"
+#include "EventBus.h"
+#include "WindowManager.h"
+#include "Tracer.h"
+#include <QFile>
+#include <QSocketNotifier>
+#include <QWaylandClient>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Pulse {
+
+namespace {
+
+// Readers beyond this are refused; each one costs an fd pair
+constexpr int kMaxReaders = 32;
+
+// Fixed size; F_SEAL_FUTURE_WRITE (Linux 5.1) keeps existing mappings
+// writable but refuses new writable ones
+#ifdef F_SEAL_FUTURE_WRITE
+constexpr int kTableSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE | F_SEAL_SEAL;
+#else
+constexpr int kTableSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+#endif
+
+// Truncate on a UTF-8 code point boundary and always NUL terminate
+template<size_t N>
+void copyString(char (&target)[N], const QString& source) {
+    const QByteArray utf8 = source.toUtf8();
+    qsizetype length = qMin<qsizetype>(utf8.size(), N - 1);
+    while (length > 0 && length < utf8.size() && (utf8[length] & 0xc0) == 0x80) {
+        --length;
+    }
+    std::memcpy(target, utf8.constData(), length);
+    std::memset(target + length, 0, N - length);
+}
+
+bool isServed(const sockaddr_un& address) {
+    const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) return false;
+    const bool served = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    ::close(probe);
+    return served;
+}
+
+bool sendFds(int socket, const int* fds, int count) {
+    char byte = 0;
+    iovec io = { &byte, 1 };
+    
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    msghdr message = {};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = CMSG_SPACE(count * sizeof(int));
+    
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(count * sizeof(int));
+    std::memcpy(CMSG_DATA(header), fds, count * sizeof(int));
+    
+    return ::sendmsg(socket, &message, MSG_NOSIGNAL) == 1;
+}
+
+} // namespace
+
+WindowTablePublisher::WindowTablePublisher(WindowManager* windowManager, QObject* parent)
+    : QObject(parent)
+    , m_windowManager(windowManager) {
+    
+    EventBus* bus = EventBus::instance();
+    bus->subscribe<WindowAdded, &WindowTablePublisher::onWindowAdded>(this);
+    bus->subscribe<WindowRemoved, &WindowTablePublisher::schedulePublish>(this);
+    bus->subscribe<ActiveWindowChanged, &WindowTablePublisher::schedulePublish>(this);
+    connect(m_windowManager, &WindowManager::currentWorkspaceChanged,
+            this, &WindowTablePublisher::schedulePublish);
+    connect(m_windowManager, &WindowManager::windowTitlesChanged,
+            this, &WindowTablePublisher::schedulePublish);
+    
+    // A re-tile or workspace switch touches many windows; write once
+    m_publishTimer.setSingleShot(true);
+    m_publishTimer.setInterval(0);
+    connect(&m_publishTimer, &QTimer::timeout, this, &WindowTablePublisher::publish);
+}
+
+WindowTablePublisher::~WindowTablePublisher() {
+    stop();
+}
+
+bool WindowTablePublisher::start(const QString& socketPath) {
+    if (m_table) return true;
+    
+    if (socketPath.isEmpty()) {
+        qWarning() << "Window table: XDG_RUNTIME_DIR is not set, not publishing";
+        return false;
+    }
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    const QByteArray path = QFile::encodeName(socketPath);
+    if (path.size() >= qsizetype(sizeof(address.sun_path))) {
+        qWarning() << "Window table: socket path too long" << socketPath;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.constData(), path.size());
+    
+    // Only a stale socket from a crashed compositor may be replaced; one
+    // that still accepts belongs to a live compositor on this display
+    if (isServed(address)) {
+        qWarning() << "Window table: already published on" << socketPath;
+        return false;
+    }
+    
+    m_tableFd = ::memfd_create("pulse-window-table", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (m_tableFd < 0 || ::ftruncate(m_tableFd, sizeof(WindowTable)) != 0) {
+        qWarning() << "Window table: failed to create shared memory";
+        stop();
+        return false;
+    }
+    
+    void* mapping = ::mmap(nullptr, sizeof(WindowTable), PROT_READ | PROT_WRITE,
+                           MAP_SHARED, m_tableFd, 0);
+    if (mapping == MAP_FAILED) {
+        qWarning() << "Window table: failed to map shared memory";
+        stop();
+        return false;
+    }
+    m_table = static_cast<WindowTable*>(mapping);
+    
+    // Readers get a descriptor opened read-only, and once our mapping
+    // exists the seals stop anyone resizing the table or mapping it
+    // writable again, even through /proc
+    const QByteArray procPath = "/proc/self/fd/" + QByteArray::number(m_tableFd);
+    m_readOnlyFd = ::open(procPath.constData(), O_RDONLY | O_CLOEXEC);
+    if (m_readOnlyFd < 0 || ::fcntl(m_tableFd, F_ADD_SEALS, kTableSeals) != 0) {
+        qWarning() << "Window table: failed to seal shared memory";
+        stop();
+        return false;
+    }
+    
+    m_table = new (mapping) WindowTable;
+    m_table->header.magic = kWindowTableMagic;
+    m_table->header.version = kWindowTableVersion;
+    m_table->header.capacity = kWindowTableCapacity;
+    m_table->header.entrySize = sizeof(WindowTableEntry);
+    m_table->header.sequence.store(0, std::memory_order_relaxed);
+    
+    ::unlink(path.constData());
+    m_listenSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (m_listenSocket < 0 ||
+        ::bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(m_listenSocket, 8) != 0) {
+        qWarning() << "Window table: failed to listen on" << socketPath;
+        stop();
+        return false;
+    }
+    m_socketPath = socketPath;
+    
+    m_listenNotifier = new QSocketNotifier(m_listenSocket, QSocketNotifier::Read, this);
+    connect(m_listenNotifier, &QSocketNotifier::activated,
+            this, &WindowTablePublisher::acceptReader);
+    
+    for (Window* window : m_windowManager->windows()) {
+        onWindowAdded(WindowAdded{window});
+    }
+    publish();
+    
+    qDebug() << "Window table published on" << socketPath;
+    return true;
+}
+
+void WindowTablePublisher::stop() {
+    while (!m_readers.isEmpty()) {
+        removeReader(m_readers.first().socket);
+    }
+    
+    delete m_listenNotifier;
+    m_listenNotifier = nullptr;
+    if (m_listenSocket >= 0) {
+        ::close(m_listenSocket);
+        m_listenSocket = -1;
+    }
+    if (!m_socketPath.isEmpty()) {
+        ::unlink(QFile::encodeName(m_socketPath).constData());
+        m_socketPath.clear();
+    }
+    
+    if (m_table) {
+        ::munmap(m_table, sizeof(WindowTable));
+        m_table = nullptr;
+    }
+    if (m_readOnlyFd >= 0) {
+        ::close(m_readOnlyFd);
+        m_readOnlyFd = -1;
+    }
+    if (m_tableFd >= 0) {
+        ::close(m_tableFd);
+        m_tableFd = -1;
+    }
+}
+
+quint64 WindowTablePublisher::sequence() const {
+    return m_table ? m_table->header.sequence.load(std::memory_order_relaxed) : 0;
+}
+
+void WindowTablePublisher::onWindowAdded(const WindowAdded& event) {
+    // Unique: start() replays existing windows, and a window whose
+    // WindowAdded is still queued then arrives here twice
+    Window* window = event.window;
+    connect(window, &Window::geometryChanged, this, &WindowTablePublisher::schedulePublish, Qt::UniqueConnection);
+    connect(window, &Window::stateChanged, this, &WindowTablePublisher::schedulePublish, Qt::UniqueConnection);
+    connect(window, &Window::focusedChanged, this, &WindowTablePublisher::schedulePublish, Qt::UniqueConnection);
+    connect(window, &Window::workspaceChanged, this, &WindowTablePublisher::schedulePublish, Qt::UniqueConnection);
+    connect(window, &Window::appIdChanged, this, &WindowTablePublisher::schedulePublish, Qt::UniqueConnection);
+    schedulePublish();
+}
+
+void WindowTablePublisher::schedulePublish() {
+    if (m_table && !m_publishTimer.isActive()) {
+        m_publishTimer.start();
+    }
+}
+
+void WindowTablePublisher::publish() {
+    if (!m_table) return;
+    PULSE_TRACE_SCOPE("wm", "publishWindowTable");
+    
+    WindowTableHeader& header = m_table->header;
+    const quint64 sequence = header.sequence.load(std::memory_order_relaxed);
+    
+    // Odd sequence marks the write; the release fence keeps the data
+    // stores below from becoming visible before it
+    header.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    const int currentWorkspace = m_windowManager->currentWorkspace();
+    uint32_t count = 0;
+    for (Window* window : m_windowManager->windows()) {
+        if (count == kWindowTableCapacity) break;
+        
+        WindowTableEntry& entry = m_table->entries[count++];
+        const QRect geometry = window->geometry();
+        const bool minimized = window->state() == Window::State::Minimized;
+        
+        entry.id = window->id();
+        entry.flags = (window->focused() ? WindowTableEntry::Focused : 0u) |
+                      (!minimized && window->workspace() == currentWorkspace ? WindowTableEntry::Visible : 0u);
+        entry.state = uint32_t(window->state());
+        entry.workspace = window->workspace();
+        entry.x = geometry.x();
+        entry.y = geometry.y();
+        entry.width = geometry.width();
+        entry.height = geometry.height();
+        entry.pid = window->surface() && window->surface()->client()
+            ? window->surface()->client()->processId() : 0;
+        entry.activationStamp = m_windowManager->activationStamp(window);
+        copyString(entry.appId, window->appId());
+        copyString(entry.title, window->title());
+    }
+    
+    header.count = count;
+    header.activeWindowId = m_windowManager->activeWindow() ? m_windowManager->activeWindow()->id() : 0;
+    header.currentWorkspace = currentWorkspace;
+    header.sequence.store(sequence + 2, std::memory_order_release);
+    
+    // Wake readers; the counter just accumulates if they are slow
+    const quint64 one = 1;
+    for (const Reader& reader : std::as_const(m_readers)) {
+        if (::write(reader.eventFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            qWarning() << "Window table: failed to notify reader";
+        }
+    }
+    
+    emit published(sequence + 2);
+}
+
+void WindowTablePublisher::acceptReader() {
+    int socket;
+    while ((socket = ::accept4(m_listenSocket, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK)) >= 0) {
+        if (m_readers.size() >= kMaxReaders) {
+            qWarning() << "Window table: too many readers, refusing connection";
+            ::close(socket);
+            continue;
+        }
+        
+        // The runtime directory already keeps other users out; this also
+        // covers a socket path somewhere less private
+        ucred credentials = {};
+        socklen_t length = sizeof(credentials);
+        if (::getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0 ||
+            credentials.uid != ::getuid()) {
+            qWarning() << "Window table: refusing reader of uid" << credentials.uid;
+            ::close(socket);
+            continue;
+        }
+        
+        // Each reader gets its own eventfd so one reader draining it
+        // cannot swallow another's notification
+        const int eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        const int fds[2] = { m_readOnlyFd, eventFd };
+        if (eventFd < 0 || !sendFds(socket, fds, 2)) {
+            if (eventFd >= 0) ::close(eventFd);
+            ::close(socket);
+            continue;
+        }
+        
+        // The connection stays open only so we notice when the reader exits
+        auto* notifier = new QSocketNotifier(socket, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, [this, socket]() {
+            char buffer[64];
+            const ssize_t result = ::read(socket, buffer, sizeof(buffer));
+            if (result == 0 || (result < 0 && errno != EAGAIN && errno != EINTR)) {
+                removeReader(socket);
+            }
+        });
+        
+        m_readers.append({socket, eventFd, notifier});
+        emit readerCountChanged(m_readers.size());
+    }
+}
+
+void WindowTablePublisher::removeReader(int socket) {
+    for (int i = 0; i < m_readers.size(); ++i) {
+        if (m_readers[i].socket != socket) continue;
+        
+        const Reader reader = m_readers.takeAt(i);
+        reader.notifier->setEnabled(false);
+        reader.notifier->deleteLater();
+        ::close(reader.eventFd);
+        ::close(reader.socket);
+        emit readerCountChanged(m_readers.size());
+        return;
+    }
+}
+
+} // namespace Pulse
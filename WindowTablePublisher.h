@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QObject>
+#include <QList>
+#include <QTimer>
+#include "WindowTable.h"
+#include "WindowEvents.h"
+
+class QSocketNotifier;
+
+namespace Pulse {
+
+class Window;
+class WindowManager;
+
+// Publishes WindowManager state into the shared window table. Updates are
+// coalesced to one seqlock-protected write per event loop pass, after which
+// every connected reader's eventfd is signalled.
+class WindowTablePublisher : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(quint64 sequence READ sequence NOTIFY published)
+    Q_PROPERTY(int readerCount READ readerCount NOTIFY readerCountChanged)
+    
+public:
+    explicit WindowTablePublisher(WindowManager* windowManager, QObject* parent = nullptr);
+    ~WindowTablePublisher();
+    
+    // Fails without a path (see windowTableSocketPath) or when another
+    // compositor already serves it
+    bool start(const QString& socketPath);
+    void stop();
+    
+    quint64 sequence() const;
+    int readerCount() const { return m_readers.size(); }
+    
+public slots:
+    void schedulePublish();
+    
+signals:
+    void published(quint64 sequence);
+    void readerCountChanged(int count);
+    
+private slots:
+    void publish();
+    void acceptReader();
+    
+private:
+    void onWindowAdded(const WindowAdded& event);
+    
+    struct Reader {
+        int socket;
+        int eventFd;
+        QSocketNotifier* notifier;
+    };
+    
+    void removeReader(int socket);
+    
+    WindowManager* m_windowManager;
+    QString m_socketPath;
+    int m_listenSocket = -1;
+    int m_tableFd = -1;
+    int m_readOnlyFd = -1;
+    WindowTable* m_table = nullptr;
+    QSocketNotifier* m_listenNotifier = nullptr;
+    QList<Reader> m_readers;
+    QTimer m_publishTimer;
+};
+
+} // namespace Pulse
@@ -0,0 +1,178 @@
+#include "WindowTableReader.h"
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace Pulse {
+
+class WindowTableReader::Private {
+public:
+    int socket = -1;
+    int tableFd = -1;
+    int eventFd = -1;
+    const WindowTable* table = nullptr;
+    size_t mappedSize = 0;
+    
+    bool receiveFds(int* fds, int count);
+};
+
+bool WindowTableReader::Private::receiveFds(int* fds, int count) {
+    char byte = 0;
+    iovec io = { &byte, 1 };
+    
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    msghdr message = {};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    
+    if (::recvmsg(socket, &message, MSG_CMSG_CLOEXEC) <= 0) {
+        return false;
+    }
+    
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS ||
+        header->cmsg_len != CMSG_LEN(count * sizeof(int))) {
+        return false;
+    }
+    
+    std::memcpy(fds, CMSG_DATA(header), count * sizeof(int));
+    return true;
+}
+
+WindowTableReader::WindowTableReader()
+    : d(std::make_unique<Private>()) {
+}
+
+WindowTableReader::~WindowTableReader() {
+    disconnect();
+}
+
+bool WindowTableReader::connect(const std::string& socketPath) {
+    disconnect();
+    
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    
+    d->socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (d->socket < 0 ||
+        ::connect(d->socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        disconnect();
+        return false;
+    }
+    
+    // The compositor answers with [read-only table memfd, eventfd] and
+    // keeps the connection open; closing it unregisters us
+    int fds[2] = { -1, -1 };
+    if (!d->receiveFds(fds, 2)) {
+        disconnect();
+        return false;
+    }
+    d->tableFd = fds[0];
+    d->eventFd = fds[1];
+    
+    struct stat info = {};
+    if (::fstat(d->tableFd, &info) != 0 || size_t(info.st_size) < sizeof(WindowTableHeader)) {
+        disconnect();
+        return false;
+    }
+    
+    void* mapping = ::mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, d->tableFd, 0);
+    if (mapping == MAP_FAILED) {
+        disconnect();
+        return false;
+    }
+    d->table = static_cast<const WindowTable*>(mapping);
+    d->mappedSize = info.st_size;
+    
+    const WindowTableHeader& header = d->table->header;
+    if (header.magic != kWindowTableMagic || header.version != kWindowTableVersion ||
+        header.entrySize != sizeof(WindowTableEntry) ||
+        sizeof(WindowTableHeader) + size_t(header.capacity) * header.entrySize > d->mappedSize) {
+        disconnect();
+        return false;
+    }
+    
+    return true;
+}
+
+void WindowTableReader::disconnect() {
+    if (d->table) {
+        ::munmap(const_cast<WindowTable*>(d->table), d->mappedSize);
+        d->table = nullptr;
+        d->mappedSize = 0;
+    }
+    for (int* fd : { &d->socket, &d->tableFd, &d->eventFd }) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+bool WindowTableReader::isConnected() const {
+    return d->table != nullptr;
+}
+
+int WindowTableReader::notifyFd() const {
+    return d->eventFd;
+}
+
+void WindowTableReader::clearNotification() {
+    uint64_t value;
+    if (d->eventFd >= 0) {
+        // Non-blocking; EAGAIN just means nothing was pending
+        [[maybe_unused]] ssize_t result = ::read(d->eventFd, &value, sizeof(value));
+    }
+}
+
+uint64_t WindowTableReader::sequence() const {
+    return d->table ? d->table->header.sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool WindowTableReader::snapshot(Snapshot& out, int maxAttempts) const {
+    if (!d->table) return false;
+    
+    const WindowTableHeader& header = d->table->header;
+    const uint32_t capacity = header.capacity;
+    out.windows.reserve(capacity);
+    
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        const uint64_t begin = header.sequence.load(std::memory_order_acquire);
+        if (begin & 1) {
+            // Writer mid-update; it only holds the table for a memcpy's worth
+            if (attempt > 16) std::this_thread::yield();
+            continue;
+        }
+        
+        // Anything read here may be torn; it is only trusted if the
+        // sequence is unchanged afterwards
+        uint32_t count;
+        std::memcpy(&count, &header.count, sizeof(count));
+        if (count > capacity) count = capacity;
+        
+        out.windows.resize(count);
+        std::memcpy(out.windows.data(), d->table->entries, count * sizeof(WindowTableEntry));
+        std::memcpy(&out.activeWindowId, &header.activeWindowId, sizeof(out.activeWindowId));
+        std::memcpy(&out.currentWorkspace, &header.currentWorkspace, sizeof(out.currentWorkspace));
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header.sequence.load(std::memory_order_relaxed) == begin) {
+            out.sequence = begin;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+} // namespace Pulse
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "WindowTable.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Pulse {
+
+// Client side of the shared window table. Reading a snapshot takes no
+// syscalls or locks: the table is mapped read-only and copied under the
+// compositor's seqlock. notifyFd() becomes readable after every update, so
+// readers can sleep in poll()/epoll instead of polling the table.
+class WindowTableReader {
+public:
+    struct Snapshot {
+        uint64_t sequence = 0;
+        uint32_t activeWindowId = 0;
+        int32_t currentWorkspace = 0;
+        std::vector<WindowTableEntry> windows;
+    };
+    
+    WindowTableReader();
+    ~WindowTableReader();
+    
+    WindowTableReader(const WindowTableReader&) = delete;
+    WindowTableReader& operator=(const WindowTableReader&) = delete;
+    
+    bool connect(const std::string& socketPath = windowTableSocketPath());
+    void disconnect();
+    bool isConnected() const;
+    
+    // Change notification; call clearNotification() once woken
+    int notifyFd() const;
+    void clearNotification();
+    
+    // Cheap check whether anything changed since a snapshot
+    uint64_t sequence() const;
+    
+    // Copies a consistent table; false if not connected or the writer kept
+    // the table busy for maxAttempts tries
+    bool snapshot(Snapshot& out, int maxAttempts = 1000) const;
+    
+private:
+    class Private;
+    std::unique_ptr<Private> d;
+};
+
+} // namespace Pulse
@@ -0,0 +1,207 @@
+// Window table consistency test.
+//
+// The GUI thread runs a WindowManager and a WindowTablePublisher and
+// rewrites the table as fast as it can: every generation changes how many
+// windows there are and gives all of them new geometry. A reader thread
+// takes WindowTableReader snapshots of the shared table meanwhile and
+// checks that each one comes from a single generation:
+//   x       the generation, the same in every entry
+//   y       the entry's index within the generation, each exactly once
+//   width   100 + the number of windows, equal to the header count
+// A second publisher on the same socket must refuse to start. Exits
+// non-zero on any torn snapshot or a taken-over table.
+
+#include "WindowManager.h"
+#include "WindowTablePublisher.h"
+#include "WindowTableReader.h"
+#include <QCommandLineParser>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QGuiApplication>
+#include <QStandardPaths>
+#include <QWaylandSurface>
+#include <QDebug>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Pulse {
+
+namespace {
+
+constexpr int kMaxWindows = 200;
+constexpr int kBaseWidth = 100;
+constexpr int kConnectTimeoutMs = 5000;
+
+// Window count for a generation; jumps around so the table grows and
+// shrinks by varying amounts
+int windowCount(int generation) {
+    return 1 + (generation * 37) % kMaxWindows;
+}
+
+struct ReaderResult {
+    quint64 snapshots = 0;
+    quint64 busy = 0;
+    quint64 torn = 0;
+    quint64 generations = 0;
+};
+
+// Describes what is wrong with a snapshot, or returns an empty string
+QString checkSnapshot(const WindowTableReader::Snapshot& snapshot) {
+    if (snapshot.sequence & 1) {
+        return QStringLiteral("odd sequence %1").arg(snapshot.sequence);
+    }
+    if (snapshot.windows.empty()) {
+        return QString();
+    }
+    
+    const int count = int(snapshot.windows.size());
+    const int generation = snapshot.windows.front().x;
+    std::vector<bool> seen(count, false);
+    
+    for (const WindowTableEntry& entry : snapshot.windows) {
+        if (entry.x != generation) {
+            return QStringLiteral("generations %1 and %2 mixed").arg(generation).arg(entry.x);
+        }
+        if (entry.width - kBaseWidth != count) {
+            return QStringLiteral("generation %1 has %2 windows, header says %3")
+                .arg(generation).arg(entry.width - kBaseWidth).arg(count);
+        }
+        if (entry.y < 0 || entry.y >= count || seen[entry.y]) {
+            return QStringLiteral("generation %1 repeats or misses index %2").arg(generation).arg(entry.y);
+        }
+        seen[entry.y] = true;
+    }
+    return QString();
+}
+
+void readTable(const std::string& socketPath, std::atomic<bool>& done, ReaderResult& result) {
+    WindowTableReader reader;
+    if (!reader.connect(socketPath)) {
+        qWarning() << "Reader failed to connect";
+        result.torn++;
+        return;
+    }
+    
+    WindowTableReader::Snapshot snapshot;
+    quint64 lastSequence = 0;
+    int lastGeneration = -1;
+    
+    while (!done.load(std::memory_order_acquire)) {
+        if (!reader.snapshot(snapshot)) {
+            result.busy++;
+            continue;
+        }
+        result.snapshots++;
+        
+        QString error = checkSnapshot(snapshot);
+        if (error.isEmpty() && snapshot.sequence < lastSequence) {
+            error = QStringLiteral("sequence went back from %1 to %2").arg(lastSequence).arg(snapshot.sequence);
+        }
+        if (!error.isEmpty()) {
+            if (result.torn++ < 10) {
+                qWarning().noquote() << "Torn snapshot at sequence" << snapshot.sequence << ":" << error;
+            }
+            continue;
+        }
+        
+        lastSequence = snapshot.sequence;
+        if (!snapshot.windows.empty() && snapshot.windows.front().x != lastGeneration) {
+            lastGeneration = snapshot.windows.front().x;
+            result.generations++;
+        }
+    }
+}
+
+} // namespace
+
+} // namespace Pulse
+
+int main(int argc, char *argv[]) {
+    // Keeps the window manager's session file out of the user's data
+    QStandardPaths::setTestModeEnabled(true);
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("pulse-window-table-test");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Checks window table snapshots for tearing under concurrent updates");
+    parser.addHelpOption();
+    parser.addOption({"generations", "Table rewrites", "count", "20000"});
+    parser.process(app);
+    
+    const QString socketPath = QDir::temp().filePath(
+        QStringLiteral("pulse-window-table-test-%1").arg(QCoreApplication::applicationPid()));
+    
+    // Outlive the windows, so the table keeps reporting them
+    std::vector<std::unique_ptr<QWaylandSurface>> surfaces;
+    Pulse::WindowManager windowManager;
+    Pulse::WindowTablePublisher publisher(&windowManager);
+    if (!publisher.start(socketPath)) {
+        return 2;
+    }
+    
+    std::atomic<bool> done{false};
+    Pulse::ReaderResult result;
+    std::thread reader(Pulse::readTable, socketPath.toStdString(), std::ref(done), std::ref(result));
+    
+    // The reader blocks in connect() until the publisher accepts it
+    QDeadlineTimer connectDeadline(Pulse::kConnectTimeoutMs);
+    while (publisher.readerCount() == 0 && !connectDeadline.hasExpired()) {
+        QCoreApplication::processEvents();
+    }
+    
+    std::vector<Pulse::Window*> windows;
+    const int generations = qMax(1, parser.value("generations").toInt());
+    
+    for (int generation = 0; generation < generations && publisher.readerCount() > 0; ++generation) {
+        const int count = Pulse::windowCount(generation);
+        while (int(windows.size()) > count) {
+            windowManager.destroyWindow(windows.back());
+            windows.pop_back();
+        }
+        while (int(windows.size()) < count) {
+            if (surfaces.size() == windows.size()) {
+                surfaces.push_back(std::make_unique<QWaylandSurface>());
+            }
+            windows.push_back(windowManager.createWindow(surfaces[windows.size()].get()));
+        }
+        
+        for (int i = 0; i < count; ++i) {
+            windows[i]->setGeometry(QRect(generation, i, Pulse::kBaseWidth + count, 100));
+        }
+        
+        // Published from the coalescing timer, with this generation complete
+        const quint64 before = publisher.sequence();
+        publisher.schedulePublish();
+        while (publisher.sequence() == before) {
+            QCoreApplication::processEvents();
+        }
+    }
+    
+    done.store(true, std::memory_order_release);
+    reader.join();
+    
+    // A live table is never taken over
+    Pulse::WindowTablePublisher second(&windowManager);
+    const bool takenOver = second.start(socketPath);
+    publisher.stop();
+    
+    qDebug().nospace() << result.snapshots << " snapshots of " << result.generations
+                       << " distinct generations, " << result.busy << " gave up on a busy table, "
+                       << result.torn << " torn";
+    
+    if (result.generations < 2) {
+        qWarning() << "Reader saw too few updates to test anything";
+        return 1;
+    }
+    if (takenOver) {
+        qWarning() << "A second publisher replaced the live table";
+        return 1;
+    }
+    return result.torn == 0 ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "Workspace.h"
+
+namespace Pulse {
+
+Workspace::Workspace(int index, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_index(index)
+    , m_name(QString("Workspace %1").arg(index + 1)) {
+}
+
+void Workspace::setName(const QString& name) {
+    if (m_name != name) {
+        m_name = name;
+        emit nameChanged(name);
+    }
+}
+
+void Workspace::setActive(bool active) {
+    if (m_active != active) {
+        m_active = active;
+        emit activeChanged(active);
+    }
+}
+
+void Workspace::addWindow(Window* window) {
+    if (!window || m_windows.contains(window)) return;
+    
+    const int row = m_windows.size();
+    beginInsertRows(QModelIndex(), row, row);
+    m_windows.append(window);
+    endInsertRows();
+    
+    emit countChanged(m_windows.size());
+}
+
+void Workspace::removeWindow(Window* window) {
+    const int row = m_windows.indexOf(window);
+    if (row < 0) return;
+    
+    beginRemoveRows(QModelIndex(), row, row);
+    m_windows.removeAt(row);
+    endRemoveRows();
+    
+    if (m_lastActiveWindow == window) {
+        m_lastActiveWindow = nullptr;
+    }
+    emit countChanged(m_windows.size());
+}
+
+void Workspace::moveWindow(Window* window, int row) {
+    const int from = m_windows.indexOf(window);
+    row = qBound(0, row, m_windows.size() - 1);
+    if (from < 0 || from == row) return;
+    
+    // Qt's move API takes the destination before the move
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), row > from ? row + 1 : row);
+    m_windows.move(from, row);
+    endMoveRows();
+}
+
+int Workspace::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_windows.size();
+}
+
+QVariant Workspace::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_windows.size() || role != WindowRole) {
+        return QVariant();
+    }
+    return QVariant::fromValue(m_windows.at(index.row()));
+}
+
+QHash<int, QByteArray> Workspace::roleNames() const {
+    return { { WindowRole, "window" } };
+}
+
+} // namespace Pulse
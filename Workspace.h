@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QtQml/qqmlregistration.h>
+#include "Window.h"
+
+namespace Pulse {
+
+// A virtual desktop: its own window set and layout state. Also serves as the
+// list model for the workspace's retained delegate subtree in QML, so
+// switching workspaces never recreates window items.
+class Workspace : public QAbstractListModel {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Owned by the compositor")
+    Q_PROPERTY(int index READ index CONSTANT)
+    Q_PROPERTY(QString name READ name WRITE setName NOTIFY nameChanged)
+    Q_PROPERTY(bool active READ active NOTIFY activeChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    
+public:
+    enum class Layout {
+        Floating,
+        Tiled
+    };
+    Q_ENUM(Layout)
+    
+    enum Roles {
+        WindowRole = Qt::UserRole + 1
+    };
+    
+    explicit Workspace(int index, QObject* parent = nullptr);
+    
+    int index() const { return m_index; }
+    QString name() const { return m_name; }
+    void setName(const QString& name);
+    
+    bool active() const { return m_active; }
+    void setActive(bool active);
+    
+    // Window set
+    int count() const { return m_windows.size(); }
+    const QList<Window*>& windows() const { return m_windows; }
+    bool contains(Window* window) const { return m_windows.contains(window); }
+    void addWindow(Window* window);
+    void removeWindow(Window* window);
+    void moveWindow(Window* window, int row);
+    
+    // Layout state
+    Layout layout() const { return m_layout; }
+    void setLayout(Layout layout) { m_layout = layout; }
+    Window* lastActiveWindow() const { return m_lastActiveWindow; }
+    void setLastActiveWindow(Window* window) { m_lastActiveWindow = window; }
+    
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    
+signals:
+    void nameChanged(const QString& name);
+    void activeChanged(bool active);
+    void countChanged(int count);
+    
+private:
+    int m_index;
+    QString m_name;
+    bool m_active = false;
+    QList<Window*> m_windows;
+    Layout m_layout = Layout::Floating;
+    QPointer<Window> m_lastActiveWindow;
+};
+
+} // namespace Pulse
@@ -0,0 +1,54 @@
+#version 440
+
+layout(location = 0) in vec2 local;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    float titleBarHeight;
+    vec4 frame;             // width, height, corner radius, border width
+    vec4 shadow;            // offset x, offset y, softness
+    vec4 borderColor;
+    vec4 titleBarColor;
+    vec4 clientColor;
+    vec4 shadowColor;
+};
+
+// Signed distance to a rounded box centred on the origin
+float roundedBox(vec2 p, vec2 halfSize, float radius)
+{
+    vec2 q = abs(p) - halfSize + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+vec4 premultiply(vec4 color)
+{
+    return vec4(color.rgb * color.a, color.a);
+}
+
+void main()
+{
+    vec2 halfSize = frame.xy * 0.5;
+    vec2 p = local - halfSize;
+    float radius = min(frame.z, min(halfSize.x, halfSize.y));
+    
+    // Screen-space width of one pixel in distance units, for antialiasing
+    float outer = roundedBox(p, halfSize, radius);
+    float aa = max(fwidth(outer), 1e-4);
+    float coverage = clamp(0.5 - outer / aa, 0.0, 1.0);
+    
+    float inner = roundedBox(p, halfSize - frame.w, max(radius - frame.w, 0.0));
+    float interior = clamp(0.5 - inner / aa, 0.0, 1.0);
+    
+    vec4 fill = local.y < titleBarHeight ? titleBarColor : clientColor;
+    vec4 body = premultiply(mix(borderColor, fill, interior)) * coverage;
+    
+    // Soft shadow from the same distance field, offset and blurred
+    float shadowDistance = roundedBox(p - shadow.xy, halfSize, radius);
+    float shadowAlpha = 1.0 - smoothstep(-shadow.z * 0.5, shadow.z, shadowDistance);
+    vec4 dropShadow = premultiply(shadowColor) * shadowAlpha;
+    
+    fragColor = (body + dropShadow * (1.0 - body.a)) * qt_Opacity;
+}
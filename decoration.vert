@@ -0,0 +1,26 @@
+#version 440
+
+layout(location = 0) in vec4 vertex;
+layout(location = 1) in vec2 frameCoord;
+
+layout(location = 0) out vec2 local;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    float titleBarHeight;
+    vec4 frame;             // width, height, corner radius, border width
+    vec4 shadow;            // offset x, offset y, softness
+    vec4 borderColor;
+    vec4 titleBarColor;
+    vec4 clientColor;
+    vec4 shadowColor;
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+void main()
+{
+    local = frameCoord;
+    gl_Position = qt_Matrix * vertex;
+}
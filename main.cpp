@@ -1,19 +1,88 @@
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQuickWindow>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QDebug>
+
+#ifdef PULSE_QML_MODULE
+// The Pulse module is linked statically
+Q_IMPORT_QML_PLUGIN(PulsePlugin)
+#endif
+
+namespace {
+
+// Compiled into the binary by the Pulse module: nothing is read from disk
+// or JIT-compiled at startup. PULSE_QML_DIR loads plain QML from that
+// directory instead, and builds without the module fall back to main.qml
+// next to the executable.
+QUrl mainQml() {
+    const QString compiled = QStringLiteral(":/qt/qml/Pulse/main.qml");
+    const QString directory = qEnvironmentVariable("PULSE_QML_DIR");
+    
+    if (directory.isEmpty() && QFile::exists(compiled)) {
+        return QUrl(QStringLiteral("qrc") + compiled);
+    }
+    const QDir base(directory.isEmpty() ? QCoreApplication::applicationDirPath() : directory);
+    return QUrl::fromLocalFile(base.filePath(QStringLiteral("main.qml")));
+}
+
+// The compositor's input thread reads the devices itself with
+// PULSE_LIBINPUT or on eglfs/linuxfb (see Compositor::attachWindow). The
+// platform plugin must then leave them alone, or every event arrives
+// twice; its input is only set up in QGuiApplication, so decide first.
+void releaseInputDevices(int argc, char** argv) {
+    QByteArray platform = qgetenv("QT_QPA_PLATFORM");
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (qstrcmp(argv[i], "-platform") == 0 || qstrcmp(argv[i], "--platform") == 0) {
+            platform = argv[i + 1];
+        }
+    }
+    
+    // Plugin options follow a colon, e.g. eglfs:/dev/fb1
+    platform = platform.split(':').constFirst();
+    if (qEnvironmentVariableIsSet("PULSE_LIBINPUT") || platform == "eglfs" || platform == "linuxfb") {
+        qputenv("QT_QPA_EGLFS_DISABLE_INPUT", "1");
+        qputenv("QT_QPA_FB_DISABLE_INPUT", "1");
+    }
+}
+
+} // namespace
 
 int main(int argc, char *argv[]) {
+    // Time to first frame, from process start
+    QElapsedTimer startup;
+    startup.start();
+    
+    releaseInputDevices(argc, argv);
     QGuiApplication app(argc, argv);
     
     app.setApplicationName("Pulse Shell");
     app.setOrganizationName("Pulse Desktop");
     
+    const QUrl url = mainQml();
     QQmlApplicationEngine engine;
-    engine.load(QUrl::fromLocalFile("/home/developer/pulse/src/shell/pulse-shell-src/main.qml"));
+    engine.load(url);
     
     if (engine.rootObjects().isEmpty()) {
+        qWarning() << "Failed to load" << url;
         return -1;
     }
     
+    const qint64 loadedMs = startup.elapsed();
+    if (auto* window = qobject_cast<QQuickWindow*>(engine.rootObjects().constFirst())) {
+        QObject::connect(window, &QQuickWindow::frameSwapped, &app, [&startup, loadedMs]() {
+            qDebug().nospace() << "Startup: QML loaded after " << loadedMs << " ms, first frame after "
+                               << startup.elapsed() << " ms";
+            
+            // PULSE_STARTUP_BENCHMARK=1 exits here; see StartupBenchmark.cpp
+            if (qEnvironmentVariableIsSet("PULSE_STARTUP_BENCHMARK")) {
+                QCoreApplication::quit();
+            }
+        }, Qt::SingleShotConnection);
+    }
+    
     return app.exec();
 }
@@ -0,0 +1,23 @@
+#version 440
+
+layout(location = 0) in vec2 coord;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    vec4 color;
+};
+
+layout(binding = 1) uniform sampler2D atlas;
+
+void main()
+{
+    // Atlas coordinates are in pixels so the atlas can grow without
+    // invalidating cached geometry. The atlas is a single R8 channel.
+    float distance = texture(atlas, coord / vec2(textureSize(atlas, 0))).r;
+    float width = max(fwidth(distance), 1e-4) * 0.7;
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    fragColor = vec4(color.rgb * color.a, color.a) * alpha * qt_Opacity;
+}
@@ -0,0 +1,20 @@
+#version 440
+
+layout(location = 0) in vec4 vertex;
+layout(location = 1) in vec2 atlasCoord;
+
+layout(location = 0) out vec2 coord;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;
+    float qt_Opacity;
+    vec4 color;
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+void main()
+{
+    coord = atlasCoord;
+    gl_Position = qt_Matrix * vertex;
+}